@@ -6,6 +6,7 @@
 #include "core/window.h"
 #include "engine/graphics/renderer.h"
 #include "engine/graphics/renderer2d.h"
+#include "engine/graphics/render_graph.h"
 #include "resources/resource_manager.h"
 #include "states/state_manager.h"
 
@@ -22,6 +23,18 @@ struct App {
 static App s_app;
 /////////////////////////////////////////////////////////////////////////////////
 
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static void scene_pass(void* user_data) {
+  renderer_clear(glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
+  state_manager_render(&s_app.state_manager);
+}
+
+static void ui_pass(void* user_data) {
+  state_manager_render_ui(&s_app.state_manager);
+}
+/////////////////////////////////////////////////////////////////////////////////
+
 // Public functions
 /////////////////////////////////////////////////////////////////////////////////
 bool app_init(void* user_data) {
@@ -29,11 +42,12 @@ bool app_init(void* user_data) {
   Font* font = resources_add_font("fonts/Kleader.ttf", "default_font");
 
   // Adding textures 
-  resources_add_texture("ground_texture", "textures/sand_texture.png");
-  resources_add_texture("platform_texture", "textures/container.png");
-  resources_add_texture("title", "textures/title_texture.png");
+  // NOTE: The crosshair is loaded right away, and keeps its pixels, since the window icon and cursor need them
+  resources_add_texture_async("ground_texture", "textures/sand_texture.png");
+  resources_add_texture_async("platform_texture", "textures/container.png");
+  resources_add_texture_async("title", "textures/title_texture.png");
   resources_add_cubemap("desert_cubemap", "cubemaps/desert_cubemap/");
-  Texture* crosshair_texture = resources_add_texture("crosshair", "textures/crosshair006.png");
+  Texture* crosshair_texture = resources_add_texture("crosshair", "textures/crosshair006.png", true);
 
   // Adding music 
   audio_system_add_music(MUSIC_MENU, "assets/music/menu_theme.mp3");
@@ -55,6 +69,13 @@ bool app_init(void* user_data) {
   // State manager init
   state_manager_init(&s_app.state_manager, font);
 
+  // Render passes
+  u32 scene = render_graph_add_pass("scene", scene_pass);
+  render_graph_write(scene, RENDER_GRAPH_BACKBUFFER);
+
+  u32 ui = render_graph_add_pass("ui", ui_pass);
+  render_graph_write(ui, RENDER_GRAPH_BACKBUFFER);
+
   // Window stuff 
   window_set_exit_key(KEY_F1);
   window_set_icon(crosshair_texture); 
@@ -73,11 +94,7 @@ void app_update(void* user_data) {
 }
 
 void app_render(void* user_data) {
-  renderer_clear(glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
-  
-  state_manager_render(&s_app.state_manager);
-  state_manager_render_ui(&s_app.state_manager);
- 
+  render_graph_execute();
   renderer_present();
 }
 /////////////////////////////////////////////////////////////////////////////////
@@ -23,7 +23,7 @@ Object* object_create(const glm::vec3& pos, const glm::vec3& coll_scale, const P
   obj->collider = BoxCollider{.half_size = coll_scale / 2.0f};
   physics_body_add_collider(obj->body, COLLIDER_BOX, &obj->collider);
 
-  obj->mesh = mesh_create();
+  obj->mesh = resources_acquire_mesh(RESOURCES_MESH_CUBE);
   obj->material = material_load(resources_get_texture(texture_id), nullptr, resources_get_shader("default_shader-3d"));
   
   obj->is_active = true;
@@ -37,7 +37,7 @@ void object_destroy(Object* obj) {
     return;
   }
 
-  mesh_destroy(obj->mesh);
+  resources_release_mesh(obj->mesh);
   delete obj;
 }
 
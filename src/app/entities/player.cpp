@@ -4,6 +4,7 @@
 #include "physics/physics_body.h"
 #include "physics/collider.h"
 #include "resources/mesh.h"
+#include "resources/resource_manager.h"
 
 #include <glm/vec3.hpp>
 
@@ -23,7 +24,7 @@ Player* player_create(const glm::vec3& start_pos) {
   });
   physics_body_add_collider(player->body, COLLIDER_BOX, &player->collider); 
 
-  player->mesh = mesh_create();
+  player->mesh = resources_acquire_mesh(RESOURCES_MESH_CUBE);
   player->is_active = true;
 
   return player;
@@ -34,7 +35,7 @@ void player_destroy(Player* player) {
     return;
   }
 
-  mesh_destroy(player->mesh);
+  resources_release_mesh(player->mesh);
   delete player;
 }
 
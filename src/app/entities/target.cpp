@@ -25,7 +25,7 @@ Target* target_create(const glm::vec3& pos) {
   target->collider = BoxCollider{.half_size = glm::vec3(0.38f, 1.26f, 0.37f) / 2.0f};
   physics_body_add_collider(target->body, COLLIDER_BOX, &target->collider);
 
-  target->model = resources_add_model("bottle", "models/Bottle/BeerBottle.obj");
+  target->model = resources_acquire_model("models/Bottle/BeerBottle.obj");
   target->is_active = true;
 
   return target;
@@ -33,6 +33,7 @@ Target* target_create(const glm::vec3& pos) {
 
 void target_destroy(Target* target) {
   if(target) {
+    resources_release_model(target->model);
     delete target;
   }
 }
@@ -44,7 +45,7 @@ void target_render(Target* target) {
 
   glm::vec3 body_trans = target->body->transform.position;
   transform_translate(&target->transform, body_trans + glm::vec3(-0.1f, -0.66f, 3.262f));
-  render_model(target->transform, target->model);
+  render_model(target->transform, target->model, &target->lod);
 }
 
 void target_active(Target* target, const bool active) {
@@ -14,6 +14,7 @@ struct Target {
   PhysicsBody* body; 
   BoxCollider collider;
   Model* model;
+  u32 lod; // The LOD the model was last rendered at
 
   bool is_active;
 };
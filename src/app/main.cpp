@@ -1,8 +1,12 @@
 #include "engine/core/app_desc.h"
 #include "engine/core/engine.h"
+#include "engine/resources/texture_cooker.h"
 #include "app/app.h"
 
-int main() {
+#include <cstring>
+#include <cstdlib>
+
+int main(int argc, char** argv) {
   AppDesc desc = {
     .window_width = 1280, 
     .window_height = 720, 
@@ -17,6 +21,24 @@ int main() {
     .has_editor = false,
   };
 
+  // For benchmarks: '--headless' and '--frames <count>'
+  // For cooking textures ahead of time (no window is ever opened): 
+  // '--cook <image> <out.ctex>' and '--cook-cubemap <faces directory/> <out.ctex>'
+  for(i32 i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "--cook") == 0 && i + 2 < argc) {
+      return texture_cook(argv[i + 1], argv[i + 2]) ? 0 : 1;
+    }
+    else if(strcmp(argv[i], "--cook-cubemap") == 0 && i + 2 < argc) {
+      return texture_cook_cubemap(argv[i + 1], argv[i + 2]) ? 0 : 1;
+    }
+    else if(strcmp(argv[i], "--headless") == 0) {
+      desc.is_headless = true;
+    }
+    else if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      desc.max_frames = strtoull(argv[++i], nullptr, 10);
+    }
+  }
+
   engine_init(desc);
   engine_run(desc);
   engine_shutdown(desc);
@@ -98,7 +98,7 @@ void particles_render() {
   }
 
   for(u32 i = 0; i < PARTICLES_MAX; i++) {
-    render_cube(s_particles.particles[i]->transform.position, glm::vec3(0.1f), glm::vec4(1.0f));
+    render_cube(s_particles.particles[i]->transform.position, glm::vec3(0.1f), glm::vec4(0.4f, 0.4f, 0.4f, 1.0f));
   }
 }
 
@@ -1,6 +1,9 @@
 #include "editor.h"
 #include "engine/core/window.h"
 #include "engine/graphics/camera.h"
+#include "engine/graphics/gpu_memory.h"
+#include "engine/graphics/render_thread.h"
+#include "engine/graphics/renderer.h"
 
 #include <imgui/imgui.h>
 #include <imgui/backends/imgui_impl_glfw.h>
@@ -20,6 +23,37 @@ struct Editor {
 static Editor s_editor;
 /////////////////////////////////////////////////////////////////////////////////
 
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static void show_renderer_stats() {
+  RendererStats stats = renderer_get_stats();
+
+  ImGui::Begin("Renderer");
+
+  ImGui::Text("Draw calls: %u", stats.draw_calls);
+  ImGui::Text("Triangles: %u", stats.triangles);
+  ImGui::Text("Visible: %u, Culled: %u", stats.visible_count, stats.culled_count);
+  ImGui::Text("State changes: %u", stats.state_changes);
+  ImGui::Text("Texture binds: %u", stats.texture_binds);
+  ImGui::Text("Uploaded: %.2fKB", stats.bytes_uploaded / 1024.0f);
+  ImGui::Text("Fence waits: %.3fms", stats.fence_wait_time);
+
+  ImGui::SeparatorText("GPU");
+  ImGui::Text("Skybox: %.3fms", stats.gpu_times[GPU_TIMER_SKYBOX]);
+  ImGui::Text("3D: %.3fms", stats.gpu_times[GPU_TIMER_3D]);
+  ImGui::Text("Instanced: %.3fms", stats.gpu_times[GPU_TIMER_INSTANCED]);
+  ImGui::Text("2D: %.3fms", stats.gpu_times[GPU_TIMER_2D]);
+
+  ImGui::SeparatorText("GPU memory");
+  for(u32 i = 0; i < GPU_MEMORY_TYPES_MAX; i++) {
+    ImGui::Text("%s: %.2fMB", gpu_memory_type_str((GPUMemoryType)i), gpu_memory_get((GPUMemoryType)i) / (1024.0f * 1024.0f));
+  }
+  ImGui::Text("Total: %.2fMB", gpu_memory_get_total() / (1024.0f * 1024.0f));
+
+  ImGui::End();
+}
+/////////////////////////////////////////////////////////////////////////////////
+
 // Public functions
 /////////////////////////////////////////////////////////////////////////////////
 void editor_init(const glm::vec3& camera_pos, const glm::vec3& camera_target, const bool initial_active) {
@@ -40,9 +74,17 @@ void editor_init(const glm::vec3& camera_pos, const glm::vec3& camera_target, co
   }
   
   // Setting up the opengl backend
-  if(!ImGui_ImplOpenGL3_Init("#version 460 core")) {
-    fprintf(stderr, "[ERROR]: Failed to initialize OpenGL for ImGui");
-  }
+  // NOTE: Anything that touches OpenGL has to happen on the render thread
+  render_thread_call([]() {
+    if(!ImGui_ImplOpenGL3_Init("#version 460 core")) {
+      fprintf(stderr, "[ERROR]: Failed to initialize OpenGL for ImGui");
+      return;
+    }
+
+    // The backend's 'NewFrame' only ever creates its GL objects (the first time around). 
+    // Doing it here keeps 'editor_begin' from waiting on the render thread every frame.
+    ImGui_ImplOpenGL3_NewFrame();
+  });
 
   // Create editor camera 
   s_editor.editor_cam = camera_create(camera_pos, camera_target); 
@@ -55,7 +97,9 @@ void editor_shutdown() {
   }
 
   ImGui_ImplGlfw_Shutdown();
-  ImGui_ImplOpenGL3_Shutdown();
+  render_thread_call([]() {
+    ImGui_ImplOpenGL3_Shutdown();
+  });
   ImGui::DestroyContext();
 }
 
@@ -64,11 +108,12 @@ void editor_begin() {
     return;
   }
 
-  ImGui_ImplOpenGL3_NewFrame();
+  // NOTE: The OpenGL backend has nothing to do per frame. Its GL objects are created in 'editor_init'.
   ImGui_ImplGlfw_NewFrame();
   ImGui::NewFrame();
 
   ImGui::ShowDemoWindow();
+  show_renderer_stats();
 }
 
 void editor_end() {
@@ -77,7 +122,23 @@ void editor_end() {
   }
 
   ImGui::Render();
-  ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+  // ImGui reuses its draw lists for the next frame before the render 
+  // thread gets to this one, so the recorded command gets a copy of them.
+  ImDrawData* draw_data = ImGui::GetDrawData();
+  ImDrawData* copy      = IM_NEW(ImDrawData)(*draw_data);
+  for(i32 i = 0; i < copy->CmdLists.Size; i++) {
+    copy->CmdLists[i] = draw_data->CmdLists[i]->CloneOutput();
+  }
+
+  render_thread_push([copy]() {
+    ImGui_ImplOpenGL3_RenderDrawData(copy);
+
+    for(i32 i = 0; i < copy->CmdLists.Size; i++) {
+      IM_DELETE(copy->CmdLists[i]);
+    }
+    IM_DELETE(copy);
+  });
 }
 
 void editor_set_active(bool active) {
@@ -12,6 +12,7 @@
 /////////////////////////////////////////////////////////////////////////////////
 struct AudioSystem {
   ma_engine* engine;
+  ma_context* context = nullptr; // Only used by the null backend
   ma_sound sounds[SOUNDS_MAX];
   ma_sound music[MUSIC_MAX];
 
@@ -42,14 +43,38 @@ static void load_music(const std::string& path, const MusicType type) {
 
 // Public functions
 /////////////////////////////////////////////////////////////////////////////////
-bool audio_system_init() {
+bool audio_system_init(const bool headless) {
+  ma_engine_config config = ma_engine_config_init();
+
+  if(headless) {
+    audio_sys.context = new ma_context{};
+
+    ma_backend backends[] = {ma_backend_null};
+    ma_result result = ma_context_init(backends, 1, nullptr, audio_sys.context);
+    if(result != MA_SUCCESS) {
+      fprintf(stderr, "[AUDIO-ERROR, ERROR-CODE = %i]: Failed to initialize the null \'ma_context\'\n", result);
+      delete audio_sys.context;
+      audio_sys.context = nullptr;
+
+      return false;
+    }
+
+    config.pContext = audio_sys.context;
+  }
+
   audio_sys.engine = new ma_engine{};
 
-  ma_result result = ma_engine_init(nullptr, audio_sys.engine);
+  ma_result result = ma_engine_init(&config, audio_sys.engine);
   if(result != MA_SUCCESS) {
     fprintf(stderr, "[AUDIO-ERROR, ERROR-CODE = %i]: Failed to initialize \'ma_engine\'\n", result);
     delete audio_sys.engine;
 
+    if(audio_sys.context) {
+      ma_context_uninit(audio_sys.context);
+      delete audio_sys.context;
+      audio_sys.context = nullptr;
+    }
+
     return false;
   }
 
@@ -62,6 +87,12 @@ bool audio_system_init() {
 void audio_system_shutdown() {
   ma_engine_uninit(audio_sys.engine);
   delete audio_sys.engine;
+
+  if(audio_sys.context) {
+    ma_context_uninit(audio_sys.context);
+    delete audio_sys.context;
+    audio_sys.context = nullptr;
+  }
 }
 
 void audio_system_add_sound(const SoundType sound, const std::string& path) {
@@ -8,7 +8,9 @@
 
 // Public functions
 /////////////////////////////////////////////////////////////////////////////////
-bool audio_system_init();
+// NOTE: A headless audio system uses miniaudio's null backend. Sounds still get
+// mixed and played in real time, but nothing ever reaches an audio device.
+bool audio_system_init(const bool headless = false);
 void audio_system_shutdown();
 
 void audio_system_add_sound(const SoundType sound, const std::string& path);
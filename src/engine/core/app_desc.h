@@ -1,6 +1,7 @@
 #pragma once
 
 #include "defines.h"
+#include "graphics/texture_residency.h"
 
 #include <string>
 
@@ -25,5 +26,22 @@ struct AppDesc {
 
   void* user_data = nullptr;
   bool has_editor = false;
+
+  // Replay the rendering commands of each frame on a dedicated thread that owns the 
+  // OpenGL context. Turn it off to do everything on the main thread instead.
+  bool has_render_thread = true;
+
+  // Run without a display or an audio device, for benchmarks and build machines. Everything 
+  // still gets updated and rendered as usual, just into an offscreen framebuffer that is never 
+  // shown, while the audio gets mixed into miniaudio's null backend.
+  bool is_headless = false;
+
+  // Quit after this many frames. Runs until the window gets closed if 0.
+  u64 max_frames = 0;
+
+  // How many bytes of textures can be on the GPU, and how many bytes of decoded 
+  // pixels can be on their way there at once (see 'texture_residency.h')
+  usizei texture_vram_budget = TEXTURE_RESIDENCY_VRAM_BUDGET;
+  usizei texture_ram_budget  = TEXTURE_RESIDENCY_RAM_BUDGET;
 };
 /////////////////////////////////////////////////////////////////////////////////
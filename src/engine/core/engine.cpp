@@ -5,9 +5,15 @@
 #include "core/window.h"
 #include "core/input.h"
 #include "core/event.h"
+#include "core/thread_pool.h"
 
 #include "graphics/renderer.h"
 #include "graphics/renderer2d.h"
+#include "graphics/render_thread.h"
+#include "graphics/render_graph.h"
+#include "graphics/texture_residency.h"
+#include "graphics/shader.h"
+#include "graphics/shader_cache.h"
 
 #include "audio/audio_system.h"
 
@@ -32,14 +38,24 @@ bool game_quit(const EventType type, const EventDesc& desc) {
 /////////////////////////////////////////////////////////////////////////////////
 void engine_init(const AppDesc& desc) {
   // Window init 
-  if(!window_create(desc.window_width, desc.window_height, desc.window_title.c_str())) {
+  if(!window_create(desc.window_width, desc.window_height, desc.window_title.c_str(), desc.is_headless)) {
     printf("[ERROR]: Window failed to be created\n");
     return;
   }
 
+  // Render thread init
+  // NOTE: Has to happen before anything touches OpenGL, since the context moves to the new thread
+  if(desc.has_render_thread && !render_thread_init()) {
+    printf("[ERROR]: Render thread failed to be created\n");
+    return;
+  }
+
   // Input init
   input_init();
 
+  // Thread pool init
+  thread_pool_init();
+
   // Resource manager init 
   resources_init("assets/");
 
@@ -49,14 +65,24 @@ void engine_init(const AppDesc& desc) {
     return;
   }
 
+  // Texture budgets
+  usizei vram_budget = desc.texture_vram_budget;
+  usizei ram_budget  = desc.texture_ram_budget;
+  render_thread_call([vram_budget, ram_budget]() {
+    texture_residency_set_budget(vram_budget, ram_budget);
+  });
+
   // Renderer 2D init
   if(!renderer2d_create()) {
     printf("[ERROR]: Renderer2D failed to be created\n");
     return;
   }
 
+  // The built-in shaders should be done (and timed) before the app starts loading its own things
+  shader_wait_compiles();
+
   // Audio init
-  if(!audio_system_init()) {
+  if(!audio_system_init(desc.is_headless)) {
     printf("[ERROR]: Audio system failed to be initialized\n");
     return;
   }
@@ -72,23 +98,48 @@ void engine_init(const AppDesc& desc) {
     fprintf(stderr, "[ERROR]: Could not initialize app\n");
     return;
   }
+
+  // NOTE: The app's own shaders might still be compiling. Their time only gets counted once they are done.
+  ShaderCacheStats cache_stats;
+  u32 compiling_count = 0;
+  render_thread_call([&cache_stats, &compiling_count]() {
+    cache_stats     = shader_cache_get_stats();
+    compiling_count = shader_get_compiling_count();
+  });
+
+  printf("[INFO]: Shader cache: %i hits, %i misses (%i still compiling). Cached programs loaded in %.2fms (saved %.2fms), compiled programs took %.2fms\n", 
+         cache_stats.hits, 
+         cache_stats.misses, 
+         compiling_count,
+         cache_stats.load_time * 1000.0, 
+         cache_stats.saved_time * 1000.0, 
+         cache_stats.compile_time * 1000.0);
 }
 
 void engine_shutdown(AppDesc& desc) {
   desc.shutdown_func(desc.user_data); 
 
+  // No more loading jobs should finish once the resources start going away
+  thread_pool_shutdown();
+
   physics_world_destroy();
 
   audio_system_shutdown();
 
+  render_graph_shutdown();
   renderer2d_destroy();
   renderer_destroy();
   
   resources_shutdown();
+
+  // Everything above only recorded its GL cleanup. This runs it all before the context goes away.
+  render_thread_shutdown();
   window_destroy();
 }
 
 void engine_run(AppDesc& desc) {
+  u64 frames = 0;
+
   while(!window_should_close()) {
     if(input_key_pressed(window_get_exit_key())) {
       event_dispatch(EVENT_GAME_QUIT, EventDesc{});
@@ -103,6 +154,22 @@ void engine_run(AppDesc& desc) {
     desc.render_func(desc.user_data);
 
     window_poll_events();
+
+    // Benchmarks run for a fixed amount of frames
+    frames++;
+    if(desc.max_frames != 0 && frames >= desc.max_frames) {
+      RendererStats stats = renderer_get_stats();
+      printf("[INFO]: Ran %llu frames. Last frame: %u draw calls, %u triangles, %u visible (%u culled), %zu bytes uploaded, %.3fms fence waits\n", 
+             (unsigned long long)frames, 
+             stats.draw_calls, 
+             stats.triangles, 
+             stats.visible_count, 
+             stats.culled_count, 
+             stats.bytes_uploaded, 
+             stats.fence_wait_time);
+
+      event_dispatch(EVENT_GAME_QUIT, EventDesc{});
+    }
   }
 }
 /////////////////////////////////////////////////////////////////////////////////
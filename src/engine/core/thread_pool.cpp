@@ -0,0 +1,166 @@
+#include "thread_pool.h"
+#include "defines.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+// The game and render threads are always busy, so they get their own cores
+#define RESERVED_THREADS 2
+/////////////////////////////////////////////////////////////////////////////////
+
+// ThreadPoolEntry
+/////////////////////////////////////////////////////////////////////////////////
+struct ThreadPoolEntry {
+  ThreadPoolJob job;
+  std::atomic<u32>* counter;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// ThreadPool
+/////////////////////////////////////////////////////////////////////////////////
+struct ThreadPool {
+  std::vector<std::thread> threads;
+  bool is_running = false;
+
+  std::mutex mutex;
+  std::condition_variable cond;
+
+  std::deque<ThreadPoolEntry> queue;
+
+  bool should_quit = false;
+};
+
+static ThreadPool s_pool;
+/////////////////////////////////////////////////////////////////////////////////
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static void run_entry(ThreadPoolEntry& entry) {
+  entry.job();
+
+  if(entry.counter) {
+    entry.counter->fetch_sub(1);
+  }
+}
+
+static void thread_loop() {
+  std::unique_lock<std::mutex> lock(s_pool.mutex);
+  while(true) {
+    s_pool.cond.wait(lock, []() {
+      return !s_pool.queue.empty() || s_pool.should_quit;
+    });
+
+    if(s_pool.should_quit) {
+      break;
+    }
+
+    ThreadPoolEntry entry = s_pool.queue.front();
+    s_pool.queue.pop_front();
+
+    lock.unlock();
+    run_entry(entry);
+    lock.lock();
+  }
+}
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+const bool thread_pool_init(const u32 threads_count) {
+  u32 count = threads_count;
+  if(count == 0) {
+    // 'hardware_concurrency' can be 0 if it is not known
+    u32 cores = std::thread::hardware_concurrency();
+    count     = cores > RESERVED_THREADS ? cores - RESERVED_THREADS : 1;
+  }
+
+  s_pool.should_quit = false;
+  s_pool.is_running  = true;
+
+  for(u32 i = 0; i < count; i++) {
+    s_pool.threads.push_back(std::thread(thread_loop));
+  }
+
+  printf("[INFO]: Thread pool started with %u workers\n", count);
+  return true;
+}
+
+void thread_pool_shutdown() {
+  if(!s_pool.is_running) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(s_pool.mutex);
+    s_pool.should_quit = true;
+
+    // Nobody should be left waiting on a job that is never going to run
+    for(auto& entry : s_pool.queue) {
+      if(entry.counter) {
+        entry.counter->fetch_sub(1);
+      }
+    }
+    s_pool.queue.clear();
+  }
+  s_pool.cond.notify_all();
+
+  for(auto& thread : s_pool.threads) {
+    thread.join();
+  }
+
+  s_pool.threads.clear();
+  s_pool.is_running = false;
+}
+
+void thread_pool_push(const ThreadPoolJob& job, std::atomic<u32>* counter) {
+  if(counter) {
+    counter->fetch_add(1);
+  }
+
+  ThreadPoolEntry entry = {job, counter};
+  if(!s_pool.is_running) {
+    run_entry(entry);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(s_pool.mutex);
+    s_pool.queue.push_back(entry);
+  }
+  s_pool.cond.notify_one();
+}
+
+void thread_pool_wait(std::atomic<u32>* counter) {
+  while(counter->load() > 0) {
+    ThreadPoolEntry entry;
+    bool has_entry = false;
+
+    {
+      std::lock_guard<std::mutex> lock(s_pool.mutex);
+      if(!s_pool.queue.empty()) {
+        entry = s_pool.queue.front();
+        s_pool.queue.pop_front();
+        has_entry = true;
+      }
+    }
+
+    // Nothing left to help with. The last jobs are already running on the workers.
+    if(!has_entry) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    run_entry(entry);
+  }
+}
+
+const u32 thread_pool_get_threads_count() {
+  return s_pool.threads.size();
+}
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "defines.h"
+
+#include <atomic>
+#include <functional>
+
+// Callbacks
+/////////////////////////////////////////////////////////////////////////////////
+typedef std::function<void()> ThreadPoolJob;
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// A few worker threads for work that does not touch OpenGL, like decoding images 
+// while loading. Jobs are picked up in the order they were pushed.
+//
+// NOTE: Every job runs right away (on the calling thread) if the pool was never started.
+
+// Start 'threads_count' workers. If 'threads_count' is 0, there will be one worker per core, 
+// minus the ones the game and render threads already take.
+const bool thread_pool_init(const u32 threads_count = 0);
+
+// Jobs that are already running get finished. Jobs that never started get dropped.
+void thread_pool_shutdown();
+
+// Queue up the job for the next free worker. If 'counter' is given, it is incremented 
+// right away and decremented once the job is done (see 'thread_pool_wait').
+void thread_pool_push(const ThreadPoolJob& job, std::atomic<u32>* counter = nullptr);
+
+// Wait until 'counter' reaches 0. The calling thread helps out with the queued 
+// jobs in the meantime, instead of just sitting there.
+void thread_pool_wait(std::atomic<u32>* counter);
+
+// How many workers are running
+const u32 thread_pool_get_threads_count();
+/////////////////////////////////////////////////////////////////////////////////
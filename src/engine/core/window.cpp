@@ -2,6 +2,7 @@
 #include "defines.h"
 #include "core/event.h"
 #include "core/input.h"
+#include "graphics/render_thread.h"
 #include "resources/texture.h"
 
 #include <glad/gl.h>
@@ -22,6 +23,7 @@ struct Window {
   glm::vec2 mouse_offset; // How much the mouse moved this frame
 
   bool is_focused, is_fullscreen;
+  bool is_headless;
   KeyCode exit_key;
 
   f32 sensitivity = 0.1f;
@@ -55,7 +57,10 @@ void mouse_callback(GLFWwindow* win, f64 x_pos, f64 y_pos) {
 
 void frame_buffer_resize_callback(GLFWwindow* win, i32 width, i32 height) {
   window.size = glm::vec2(width, height);
-  glViewport(0, 0, width, height);
+
+  render_thread_push([width, height]() {
+    glViewport(0, 0, width, height);
+  });
 }
 
 void key_callback(GLFWwindow* win, i32 key, i32 scancode, i32 action, i32 mods) {
@@ -120,19 +125,34 @@ bool cursor_mode_change_callback(const EventType type, const EventDesc& desc) {
 
 // Priavte functions
 /////////////////////////////////////////////////////////////////////////////////
-static void glfw_init() {
-  glfwInit();
+static bool glfw_init(const bool headless) {
+  // The null platform never talks to a display server
+  if(headless) {
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+  }
+
+  glfwSetErrorCallback(error_callback);
+  if(!glfwInit()) {
+    return false;
+  }
+
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
   glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
   glfwWindowHint(GLFW_SAMPLES, 4);
 
-  glfwSetErrorCallback(error_callback);
+  // A surfaceless EGL context. Rendering goes into the renderer's own framebuffer instead.
+  if(headless) {
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+  }
+
+  return true;
 }
 
-static bool create_handle(i32 width, i32 height, const char* title) {
-  window.handle = glfwCreateWindow(width, height, title, glfwGetPrimaryMonitor(), nullptr);
+static bool create_handle(i32 width, i32 height, const char* title, GLFWmonitor* monitor) {
+  window.handle = glfwCreateWindow(width, height, title, monitor, nullptr);
 
   if(!window.handle) {
     printf("[ERROR]: Failed to create GLFW window\n");
@@ -159,13 +179,25 @@ static void set_callbacks() {
 
 // Public functions
 /////////////////////////////////////////////////////////////////////////////////
-const bool window_create(const i32 width, const i32 height, const char* title) {
+const bool window_create(const i32 width, const i32 height, const char* title, const bool headless) {
   // GLFW init 
   ////////////////////////////////////////// 
-  glfw_init();
+  if(!glfw_init(headless)) {
+    printf("[ERROR]: Failed to initialize GLFW\n");
+    return false;
+  }
   
-  const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
-  if(!create_handle(mode->width, mode->height, title)) {
+  // Headless windows keep the size they were given, since there is no monitor to fill
+  glm::vec2 size(width, height);
+  GLFWmonitor* monitor = nullptr;
+  if(!headless) {
+    monitor = glfwGetPrimaryMonitor();
+
+    const GLFWvidmode* mode = glfwGetVideoMode(monitor);
+    size = glm::vec2(mode->width, mode->height);
+  }
+
+  if(!create_handle(size.x, size.y, title, monitor)) {
     return false;
   }
   set_callbacks();
@@ -173,13 +205,14 @@ const bool window_create(const i32 width, const i32 height, const char* title) {
 
   // Window init
   ////////////////////////////////////////// 
-  window.size = glm::vec2(mode->width, mode->height);
+  window.size = size;
   window.old_size = window.size;
   window.last_mouse_pos = glm::vec2(0.0f);
   window.mouse_pos = window.last_mouse_pos; 
   window.mouse_offset = glm::vec2(0.0f);
   window.is_focused = false;
   window.is_fullscreen = false;
+  window.is_headless = headless;
   window.exit_key = KEY_ESCAPE;
 
   event_listen(EVENT_CURSOR_CHANGED, cursor_mode_change_callback);
@@ -231,6 +264,10 @@ const bool window_get_fullscreen() {
   return window.is_fullscreen;
 }
 
+const bool window_is_headless() {
+  return window.is_headless;
+}
+
 void window_set_size(const glm::vec2& size) {
   window.old_size = window.size; 
   window.size = size;
@@ -242,11 +279,23 @@ void window_set_current_context() {
   glfwMakeContextCurrent(window.handle);
 }
 
+void window_release_current_context() {
+  glfwMakeContextCurrent(nullptr);
+}
+
 void window_set_vsync(const bool vsync) {
-  glfwSwapInterval(vsync);
+  // Only affects the context that is current on the calling thread
+  render_thread_call([vsync]() {
+    glfwSwapInterval(vsync);
+  });
 }
 
 void window_set_fullscreen(const bool fullscreen) {
+  // There is no monitor to go fullscreen on
+  if(window.is_headless) {
+    return;
+  }
+
   window.is_fullscreen = fullscreen;
   const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
 
@@ -271,6 +320,11 @@ void window_set_sensitivity(const f32 sens) {
 }
 
 void window_set_icon(const Texture* icon) {
+  if(!icon->pixels) {
+    fprintf(stderr, "[WARNING]: Window icon texture did not keep its pixels\n");
+    return;
+  }
+
   GLFWimage img = {
     .width = icon->width, 
     .height = icon->height, 
@@ -281,6 +335,11 @@ void window_set_icon(const Texture* icon) {
 }
 
 void window_set_cursor_image(const Texture* img) {
+  if(!img->pixels) {
+    fprintf(stderr, "[WARNING]: Cursor texture did not keep its pixels\n");
+    return;
+  }
+
   GLFWimage image = {
     .width = img->width, 
     .height = img->height, 
@@ -10,7 +10,10 @@ struct GLFWwindow;
 
 // Public functions
 /////////////////////////////////////////////////////////////////////////////////
-const bool window_create(const i32 width, const i32 height, const char* title); 
+// NOTE: A headless window is never shown and does not need a display. Its OpenGL context
+// is created through EGL without any surface (which works with Mesa's llvmpipe), 
+// and it stays at the given size instead of covering the whole monitor.
+const bool window_create(const i32 width, const i32 height, const char* title, const bool headless = false); 
 void window_destroy();
 void window_poll_events();
 void window_swap_buffers();
@@ -22,9 +25,11 @@ const f32 window_get_aspect_ratio();
 GLFWwindow* window_get_handle(); 
 const KeyCode window_get_exit_key();
 const bool window_get_fullscreen();
+const bool window_is_headless();
 
 void window_set_size(const glm::vec2& size);
 void window_set_current_context();
+void window_release_current_context();
 void window_set_vsync(const bool vsync);
 void window_set_fullscreen(const bool fullscreen);
 void window_set_close(const bool close);
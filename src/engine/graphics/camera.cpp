@@ -3,6 +3,7 @@
 #include "defines.h"
 #include "core/input.h"
 #include "core/window.h"
+#include "math/frustum.h"
 
 #include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
@@ -41,6 +42,7 @@ Camera camera_create(const glm::vec3& position, const glm::vec3& target) {
   cam.view = glm::mat4(1.0f);
   cam.projection = glm::mat4(1.0f);
   cam.view_projection = glm::mat4(1.0f);
+  cam.frustum = frustum_create(cam.view_projection);
 
   cam.can_move = true;
 
@@ -53,6 +55,7 @@ void camera_update(Camera* camera) {
   camera->view = glm::lookAt(camera->position, camera->position + camera->front, camera->up);
   camera->projection = glm::perspective(glm::radians(camera->zoom), aspect_ratio, 0.1f, 100.0f);
   camera->view_projection = camera->projection * camera->view;
+  camera->frustum = frustum_create(camera->view_projection);
 
   if(camera->can_move) {
     glm::vec2 mouse_offset = input_mouse_offset();  
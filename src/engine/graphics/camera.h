@@ -1,6 +1,7 @@
 #pragma once
 
 #include "defines.h"
+#include "math/frustum.h"
 
 #include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
@@ -21,6 +22,7 @@ struct Camera {
 
   glm::vec3 position, up, direction, front;
   glm::mat4 view, projection, view_projection;
+  Frustum frustum; // Extracted from 'view_projection' on every update
 
   bool can_move;
 };
@@ -0,0 +1,354 @@
+#include "geometry_arena.h"
+#include "defines.h"
+#include "graphics/gl_state.h"
+#include "graphics/gpu_memory.h"
+#include "math/vertex.h"
+#include "resources/mesh.h"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+// ArenaBuffer
+/////////////////////////////////////////////////////////////////////////////////
+struct ArenaBuffer {
+  u32 id       = 0;
+  u32 capacity = 0; // In elements
+  u32 used     = 0; // In elements
+  usizei element_size;
+
+  // Sorted by offset and never adjacent to each other
+  std::vector<GeometryRange> free_ranges;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// GeometryArena
+/////////////////////////////////////////////////////////////////////////////////
+struct GeometryArena {
+  u32 vao = 0;
+
+  ArenaBuffer vertices;
+  ArenaBuffer indices;
+};
+
+static GeometryArena s_arena;
+/////////////////////////////////////////////////////////////////////////////////
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static void setup_vertex_attributes() {
+  gl_state_bind_vertex_array(s_arena.vao);
+  gl_state_bind_buffer(GL_ARRAY_BUFFER, s_arena.vertices.id);
+
+#if GEOMETRY_ARENA_PACKED_VERTICES
+  // Position
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, true, sizeof(PackedVertex3D), (void*)offsetof(PackedVertex3D, position));
+
+  // Normal
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, true, sizeof(PackedVertex3D), (void*)offsetof(PackedVertex3D, normal));
+
+  // Texture coords
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(2, 2, GL_HALF_FLOAT, false, sizeof(PackedVertex3D), (void*)offsetof(PackedVertex3D, texture_coords));
+#else
+  // Position
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(Vertex3D), 0);
+
+  // Normal
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 3, GL_FLOAT, false, sizeof(Vertex3D), (void*)offsetof(Vertex3D, normal));
+
+  // Texture coords
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(2, 2, GL_FLOAT, false, sizeof(Vertex3D), (void*)offsetof(Vertex3D, texture_coords));
+#endif
+
+  // Indices
+  gl_state_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, s_arena.indices.id);
+
+  gl_state_bind_vertex_array(0);
+}
+
+static void release_range(ArenaBuffer* buffer, const GeometryRange& range) {
+  if(range.count == 0) {
+    return;
+  }
+
+  // Find where the range goes to keep the list sorted
+  u32 i = 0;
+  while(i < buffer->free_ranges.size() && buffer->free_ranges[i].offset < range.offset) {
+    i++;
+  }
+  buffer->free_ranges.insert(buffer->free_ranges.begin() + i, range);
+
+  // Merge with the next range
+  if(i + 1 < buffer->free_ranges.size()) {
+    GeometryRange& curr = buffer->free_ranges[i];
+    GeometryRange& next = buffer->free_ranges[i + 1];
+
+    if(curr.offset + curr.count == next.offset) {
+      curr.count += next.count;
+      buffer->free_ranges.erase(buffer->free_ranges.begin() + i + 1);
+    }
+  }
+
+  // Merge with the previous range
+  if(i > 0) {
+    GeometryRange& prev = buffer->free_ranges[i - 1];
+    GeometryRange& curr = buffer->free_ranges[i];
+
+    if(prev.offset + prev.count == curr.offset) {
+      prev.count += curr.count;
+      buffer->free_ranges.erase(buffer->free_ranges.begin() + i);
+    }
+  }
+}
+
+static void create_buffer(ArenaBuffer* buffer, const u32 capacity, const usizei element_size) {
+  buffer->capacity     = capacity;
+  buffer->used         = 0;
+  buffer->element_size = element_size;
+  buffer->free_ranges.clear();
+  buffer->free_ranges.push_back(GeometryRange{0, capacity});
+
+  glGenBuffers(1, &buffer->id);
+  gl_state_bind_buffer(GL_COPY_WRITE_BUFFER, buffer->id);
+  glBufferData(GL_COPY_WRITE_BUFFER, element_size * capacity, nullptr, GL_STATIC_DRAW);
+  gl_state_bind_buffer(GL_COPY_WRITE_BUFFER, 0);
+
+  gpu_memory_alloc(GPU_MEMORY_GEOMETRY, element_size * capacity);
+}
+
+static void grow_buffer(ArenaBuffer* buffer, const u32 min_capacity) {
+  u32 new_capacity = buffer->capacity * 2;
+  while(new_capacity < min_capacity) {
+    new_capacity *= 2;
+  }
+
+  // Copy everything over to a bigger buffer
+  u32 new_id = 0;
+  glGenBuffers(1, &new_id);
+
+  gl_state_bind_buffer(GL_COPY_READ_BUFFER, buffer->id);
+  gl_state_bind_buffer(GL_COPY_WRITE_BUFFER, new_id);
+  glBufferData(GL_COPY_WRITE_BUFFER, buffer->element_size * new_capacity, nullptr, GL_STATIC_DRAW);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, buffer->element_size * buffer->capacity);
+  gl_state_bind_buffer(GL_COPY_READ_BUFFER, 0);
+  gl_state_bind_buffer(GL_COPY_WRITE_BUFFER, 0);
+
+  gl_state_forget_buffer(buffer->id);
+  glDeleteBuffers(1, &buffer->id);
+  buffer->id = new_id;
+
+  gpu_memory_free(GPU_MEMORY_GEOMETRY, buffer->element_size * buffer->capacity);
+  gpu_memory_alloc(GPU_MEMORY_GEOMETRY, buffer->element_size * new_capacity);
+
+  release_range(buffer, GeometryRange{buffer->capacity, new_capacity - buffer->capacity});
+  buffer->capacity = new_capacity;
+
+  // The VAO still points to the old buffers
+  setup_vertex_attributes();
+}
+
+// 'size' is how many bytes to copy from 'data', which can be less than 'count' elements
+static GeometryRange add_range(ArenaBuffer* buffer, const void* data, const u32 count, const usizei size) {
+  if(count == 0) {
+    return GeometryRange{0, 0};
+  }
+
+  // First fit
+  u32 index = buffer->free_ranges.size();
+  for(u32 i = 0; i < buffer->free_ranges.size(); i++) {
+    if(buffer->free_ranges[i].count >= count) {
+      index = i;
+      break;
+    }
+  }
+
+  // Nothing fits. Make some room at the end of the buffer.
+  if(index == buffer->free_ranges.size()) {
+    u32 free_at_end = 0;
+    if(!buffer->free_ranges.empty()) {
+      const GeometryRange& last = buffer->free_ranges.back();
+      free_at_end = (last.offset + last.count == buffer->capacity) ? last.count : 0;
+    }
+
+    grow_buffer(buffer, buffer->capacity + (count - free_at_end));
+    index = buffer->free_ranges.size() - 1;
+  }
+
+  GeometryRange& free_range = buffer->free_ranges[index];
+  GeometryRange range       = GeometryRange{free_range.offset, count};
+
+  free_range.offset += count;
+  free_range.count  -= count;
+  if(free_range.count == 0) {
+    buffer->free_ranges.erase(buffer->free_ranges.begin() + index);
+  }
+  buffer->used += count;
+
+  gl_state_bind_buffer(GL_COPY_WRITE_BUFFER, buffer->id);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, buffer->element_size * range.offset, size, data);
+  gl_state_bind_buffer(GL_COPY_WRITE_BUFFER, 0);
+
+  return range;
+}
+
+// The index buffer is made of 16-bit elements. Every range takes an even amount of them, 
+// so they all start at an offset that 32-bit indices can be drawn from.
+static u32 get_index_units(const u32 count, const u32 index_size) {
+  u32 units = count * (index_size / sizeof(u16));
+  return (units + 1) & ~1u;
+}
+
+static GeometryRange add_indices(const void* indices, const u32 count, const u32 index_size) {
+  GeometryRange range = add_range(&s_arena.indices, indices, get_index_units(count, index_size), count * index_size);
+  
+  // Back into the units of the indices themselves
+  return GeometryRange{range.offset / (index_size / (u32)sizeof(u16)), count};
+}
+
+static PackedVertex3D pack_vertex(const Vertex3D& vertex, const glm::vec3& min, const glm::vec3& extent) {
+  glm::vec3 inv_extent = glm::vec3(extent.x > 0.0f ? 1.0f / extent.x : 0.0f, 
+                                   extent.y > 0.0f ? 1.0f / extent.y : 0.0f, 
+                                   extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+  glm::vec3 position   = glm::clamp((vertex.position - min) * inv_extent, 0.0f, 1.0f);
+
+  PackedVertex3D packed;
+  packed.position       = glm::u16vec3(glm::round(position * 65535.0f));
+  packed.padding        = 0;
+  packed.normal         = glm::packSnorm3x10_1x2(glm::vec4(vertex.normal, 0.0f));
+  packed.texture_coords = glm::packHalf2x16(vertex.texture_coords);
+
+  return packed;
+}
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+const bool geometry_arena_init() {
+  glGenVertexArrays(1, &s_arena.vao);
+  if(!s_arena.vao) {
+    fprintf(stderr, "[ERROR]: Failed to create the geometry arena\n");
+    return false;
+  }
+
+#if GEOMETRY_ARENA_PACKED_VERTICES
+  create_buffer(&s_arena.vertices, GEOMETRY_ARENA_VERTICES, sizeof(PackedVertex3D));
+#else
+  create_buffer(&s_arena.vertices, GEOMETRY_ARENA_VERTICES, sizeof(Vertex3D));
+#endif
+  create_buffer(&s_arena.indices, GEOMETRY_ARENA_INDICES, sizeof(u16));
+  setup_vertex_attributes();
+
+  // Instance attributes
+  gl_state_bind_vertex_array(s_arena.vao);
+  for(u32 i = 3; i <= 6; i++) {
+    glEnableVertexAttribArray(i);
+    glVertexAttribDivisor(i, 1);
+  }
+  gl_state_bind_vertex_array(0);
+
+  return true;
+}
+
+void geometry_arena_shutdown() {
+  gl_state_forget_buffer(s_arena.vertices.id);
+  gl_state_forget_buffer(s_arena.indices.id);
+  gl_state_forget_vertex_array(s_arena.vao);
+
+  glDeleteBuffers(1, &s_arena.vertices.id);
+  glDeleteBuffers(1, &s_arena.indices.id);
+  glDeleteVertexArrays(1, &s_arena.vao);
+
+  gpu_memory_free(GPU_MEMORY_GEOMETRY, s_arena.vertices.element_size * s_arena.vertices.capacity);
+  gpu_memory_free(GPU_MEMORY_GEOMETRY, s_arena.indices.element_size * s_arena.indices.capacity);
+
+  // Meshes might still give their ranges back after this. There is no harm in that.
+  s_arena.vertices.id = 0;
+  s_arena.indices.id  = 0;
+  s_arena.vao         = 0;
+}
+
+const GeometryRange geometry_arena_add_vertices(const Vertex3D* vertices, const u32 count, const glm::vec3& min, const glm::vec3& max) {
+#if GEOMETRY_ARENA_PACKED_VERTICES
+  std::vector<PackedVertex3D> packed(count);
+  for(u32 i = 0; i < count; i++) {
+    packed[i] = pack_vertex(vertices[i], min, max - min);
+  }
+
+  return add_range(&s_arena.vertices, packed.data(), count, sizeof(PackedVertex3D) * count);
+#else
+  return add_range(&s_arena.vertices, vertices, count, sizeof(Vertex3D) * count);
+#endif
+}
+
+const GeometryRange geometry_arena_add_indices(const u32* indices, const u32 count) {
+  return add_indices(indices, count, sizeof(u32));
+}
+
+const GeometryRange geometry_arena_add_indices(const u16* indices, const u32 count) {
+  return add_indices(indices, count, sizeof(u16));
+}
+
+void geometry_arena_remove_vertices(const GeometryRange& range) {
+  release_range(&s_arena.vertices, range);
+  s_arena.vertices.used -= range.count;
+}
+
+void geometry_arena_remove_indices(const GeometryRange& range, const u32 index_size) {
+  u32 scale = index_size / sizeof(u16);
+  GeometryRange units = GeometryRange{range.offset * scale, get_index_units(range.count, index_size)};
+
+  release_range(&s_arena.indices, units);
+  s_arena.indices.used -= units.count;
+}
+
+void geometry_arena_get_dequantize(const glm::vec3& min, const glm::vec3& max, glm::vec3* offset, glm::vec3* scale) {
+#if GEOMETRY_ARENA_PACKED_VERTICES
+  *offset = min;
+  *scale  = max - min;
+#else
+  *offset = glm::vec3(0.0f);
+  *scale  = glm::vec3(1.0f);
+#endif
+}
+
+void geometry_arena_bind() {
+  gl_state_bind_vertex_array(s_arena.vao);
+}
+
+void geometry_arena_set_instance_buffer(const u32 buffer, const usizei offset) {
+  gl_state_bind_vertex_array(s_arena.vao);
+  gl_state_bind_buffer(GL_ARRAY_BUFFER, buffer);
+
+  // Position
+  glVertexAttribPointer(3, 3, GL_FLOAT, false, sizeof(MeshInstance), (void*)(offset + offsetof(MeshInstance, position)));
+
+  // Color
+  glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, true, sizeof(MeshInstance), (void*)(offset + offsetof(MeshInstance, color)));
+
+  // Rotation
+  glVertexAttribPointer(5, 4, GL_SHORT, true, sizeof(MeshInstance), (void*)(offset + offsetof(MeshInstance, rotation)));
+
+  // Scale
+  glVertexAttribPointer(6, 3, GL_FLOAT, false, sizeof(MeshInstance), (void*)(offset + offsetof(MeshInstance, scale)));
+}
+
+const GeometryArenaStats geometry_arena_get_stats() {
+  GeometryArenaStats stats;
+  stats.vertices_used     = s_arena.vertices.element_size * s_arena.vertices.used;
+  stats.vertices_capacity = s_arena.vertices.element_size * s_arena.vertices.capacity;
+  stats.indices_used      = s_arena.indices.element_size * s_arena.indices.used;
+  stats.indices_capacity  = s_arena.indices.element_size * s_arena.indices.capacity;
+
+  return stats;
+}
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "defines.h"
+#include "math/vertex.h"
+
+#include <glm/vec3.hpp>
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+// The initial capacity of the arena. It will grow if more is needed.
+#define GEOMETRY_ARENA_VERTICES (64 * 1024)
+#define GEOMETRY_ARENA_INDICES  (192 * 1024) // In 16-bit indices
+
+// Store the vertices as 'PackedVertex3D's, at half the size of a 'Vertex3D'. 
+// Set to 0 to keep the full precision vertices on the GPU instead.
+#define GEOMETRY_ARENA_PACKED_VERTICES 1
+/////////////////////////////////////////////////////////////////////////////////
+
+// GeometryRange
+/////////////////////////////////////////////////////////////////////////////////
+// A range of vertices or indices (in elements, not bytes) inside the arena. 
+// Index ranges are in the size of the indices they were added with.
+struct GeometryRange {
+  u32 offset;
+  u32 count;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// GeometryArenaStats
+/////////////////////////////////////////////////////////////////////////////////
+// How much of each buffer is in use by meshes, in bytes
+struct GeometryArenaStats {
+  usizei vertices_used, vertices_capacity;
+  usizei indices_used, indices_capacity;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// The geometry arena holds the vertices and indices of every mesh in one big vertex
+// buffer and one big index buffer, which share a single VAO. A mesh is drawn by
+// giving its ranges as the base vertex and first index of a draw call, so any number
+// of meshes can be drawn without rebinding anything.
+// NOTE: Must be initialized after the OpenGL context.
+const bool geometry_arena_init();
+void geometry_arena_shutdown();
+
+// Copy the given vertices/indices into the arena, returning where they ended up.
+// 
+// Packed vertex positions are quantized between 'min' and 'max' (the bounds of the mesh), 
+// so they come out of the vertex shader between 0 and 1 and have to be scaled back by whoever 
+// draws them. 'geometry_arena_get_dequantize' gives the transform that does that.
+//
+// NOTE: The indices are relative to the mesh's own vertices. The base vertex gets
+// applied when drawing. 16-bit and 32-bit indices can live side by side in the arena, 
+// but every draw call can only use one of them.
+const GeometryRange geometry_arena_add_vertices(const Vertex3D* vertices, const u32 count, const glm::vec3& min, const glm::vec3& max);
+const GeometryRange geometry_arena_add_indices(const u32* indices, const u32 count);
+const GeometryRange geometry_arena_add_indices(const u16* indices, const u32 count);
+
+// Give the ranges back to the arena, so other meshes can reuse the space
+// NOTE: 'index_size' has to be the size (in bytes) of the indices the range was added with.
+void geometry_arena_remove_vertices(const GeometryRange& range);
+void geometry_arena_remove_indices(const GeometryRange& range, const u32 index_size);
+
+// The offset and scale that take the positions stored in the arena (for vertices added 
+// with the given bounds) back to model space (position * scale + offset)
+void geometry_arena_get_dequantize(const glm::vec3& min, const glm::vec3& max, glm::vec3* offset, glm::vec3* scale);
+
+// Bind the VAO of the arena
+void geometry_arena_bind();
+
+// Points the instance attributes of the arena's VAO at 'offset' bytes into the given buffer.
+// The buffer is expected to hold tightly packed 'MeshInstance' data.
+// NOTE: This will leave the arena's VAO bound.
+void geometry_arena_set_instance_buffer(const u32 buffer, const usizei offset);
+
+// NOTE: Must be called from the render thread.
+const GeometryArenaStats geometry_arena_get_stats();
+/////////////////////////////////////////////////////////////////////////////////
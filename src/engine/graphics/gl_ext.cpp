@@ -0,0 +1,116 @@
+#include "gl_ext.h"
+#include "defines.h"
+
+#include <glad/gl.h>
+#include <GLFW/glfw3.h>
+
+#include <cstring>
+#include <cstdio>
+
+// Function pointers
+/////////////////////////////////////////////////////////////////////////////////
+PFNGLBUFFERSTORAGEPROC glext_BufferStorage = nullptr;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glext_MultiDrawElementsIndirect = nullptr;
+PFNGLGETPROGRAMBINARYPROC glext_GetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYPROC glext_ProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIPROC glext_ProgramParameteri = nullptr;
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glext_MaxShaderCompilerThreadsKHR = nullptr;
+/////////////////////////////////////////////////////////////////////////////////
+
+// GLExtensions
+/////////////////////////////////////////////////////////////////////////////////
+struct GLExtensions {
+  i32 major_version, minor_version;
+  bool supported[GLEXT_MAX];
+};
+
+static GLExtensions s_ext;
+/////////////////////////////////////////////////////////////////////////////////
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static bool has_version(const i32 major, const i32 minor) {
+  return s_ext.major_version > major || (s_ext.major_version == major && s_ext.minor_version >= minor);
+}
+
+static bool has_extension(const char* name) {
+  i32 count = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+  for(i32 i = 0; i < count; i++) {
+    const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
+    if(ext && strcmp(ext, name) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+void gl_ext_init() {
+  glGetIntegerv(GL_MAJOR_VERSION, &s_ext.major_version);
+  glGetIntegerv(GL_MINOR_VERSION, &s_ext.minor_version);
+
+  // Buffer storage
+  glext_BufferStorage = (PFNGLBUFFERSTORAGEPROC)glfwGetProcAddress("glBufferStorage");
+  s_ext.supported[GLEXT_BUFFER_STORAGE] = glext_BufferStorage &&
+                                          (has_version(4, 4) || has_extension("GL_ARB_buffer_storage"));
+
+  // Multi draw indirect
+  glext_MultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)glfwGetProcAddress("glMultiDrawElementsIndirect");
+  s_ext.supported[GLEXT_MULTI_DRAW_INDIRECT] = glext_MultiDrawElementsIndirect &&
+                                               (has_version(4, 3) || 
+                                               (has_extension("GL_ARB_multi_draw_indirect") && has_extension("GL_ARB_base_instance")));
+
+  // Program binaries
+  glext_GetProgramBinary  = (PFNGLGETPROGRAMBINARYPROC)glfwGetProcAddress("glGetProgramBinary");
+  glext_ProgramBinary     = (PFNGLPROGRAMBINARYPROC)glfwGetProcAddress("glProgramBinary");
+  glext_ProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)glfwGetProcAddress("glProgramParameteri");
+
+  // Some drivers expose the functions but do not support a single binary format
+  i32 binary_formats = 0;
+  if(has_version(4, 1) || has_extension("GL_ARB_get_program_binary")) {
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binary_formats);
+  }
+  s_ext.supported[GLEXT_PROGRAM_BINARY] = glext_GetProgramBinary && 
+                                          glext_ProgramBinary && 
+                                          glext_ProgramParameteri && 
+                                          binary_formats > 0;
+
+  // Parallel shader compilation (the ARB version has the same enums and signature)
+  if(has_extension("GL_KHR_parallel_shader_compile")) {
+    glext_MaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+  }
+  else if(has_extension("GL_ARB_parallel_shader_compile")) {
+    glext_MaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+  }
+  s_ext.supported[GLEXT_PARALLEL_SHADER_COMPILE] = glext_MaxShaderCompilerThreadsKHR != nullptr;
+
+  // Let the driver use as many threads as it wants
+  if(s_ext.supported[GLEXT_PARALLEL_SHADER_COMPILE]) {
+    glMaxShaderCompilerThreadsKHR(0xffffffff);
+  }
+
+  // Texture compression. These only add enums, so there is nothing to load.
+  // NOTE: S3TC was never made core because of its (now expired) patent, but every desktop driver has it.
+  s_ext.supported[GLEXT_TEXTURE_COMPRESSION_S3TC] = has_extension("GL_EXT_texture_compression_s3tc");
+  s_ext.supported[GLEXT_TEXTURE_COMPRESSION_BPTC] = has_version(4, 2) || has_extension("GL_ARB_texture_compression_bptc");
+
+  printf("[INFO]: OpenGL %i.%i loaded. Buffer storage = %s, Multi draw indirect = %s, Program binary = %s, Parallel shader compile = %s, S3TC = %s, BPTC = %s\n",
+         s_ext.major_version,
+         s_ext.minor_version,
+         s_ext.supported[GLEXT_BUFFER_STORAGE] ? "yes" : "no", 
+         s_ext.supported[GLEXT_MULTI_DRAW_INDIRECT] ? "yes" : "no", 
+         s_ext.supported[GLEXT_PROGRAM_BINARY] ? "yes" : "no", 
+         s_ext.supported[GLEXT_PARALLEL_SHADER_COMPILE] ? "yes" : "no", 
+         s_ext.supported[GLEXT_TEXTURE_COMPRESSION_S3TC] ? "yes" : "no", 
+         s_ext.supported[GLEXT_TEXTURE_COMPRESSION_BPTC] ? "yes" : "no");
+}
+
+const bool gl_ext_supported(const GLExtension ext) {
+  return s_ext.supported[ext];
+}
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "defines.h"
+
+#include <glad/gl.h>
+
+/*
+ * NOTE: The GLAD loader that ships with the engine is generated for a core 3.3 context.
+ * Anything newer than that is declared and loaded here instead, after GLAD has been
+ * initialized. Always check 'gl_ext_supported' before using any of these functions, since
+ * they will be a 'nullptr' on drivers that do not expose them.
+ */
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+// ARB_buffer_storage (core in 4.4)
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT  0x0040
+#define GL_MAP_COHERENT_BIT    0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT  0x0200
+#endif
+
+// ARB_get_program_binary (core in 4.1)
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH           0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS      0x87FE
+#endif
+
+// KHR_parallel_shader_compile
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR           0x91B1
+#endif
+
+// ARB_draw_indirect (core in 4.0)
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+// ARB_shader_storage_buffer_object (core in 4.3)
+// NOTE: Every shader the engine builds already asks for 4.6, so this is not checked for.
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+
+// EXT_texture_compression_s3tc (BC1 and BC3)
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT  0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// ARB_texture_compression_bptc (BC7, core in 4.2)
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+/////////////////////////////////////////////////////////////////////////////////
+
+// GLExtension
+/////////////////////////////////////////////////////////////////////////////////
+enum GLExtension {
+  GLEXT_BUFFER_STORAGE = 0,
+  GLEXT_MULTI_DRAW_INDIRECT, // Includes a non-zero 'baseInstance' in the indirect commands
+  GLEXT_PROGRAM_BINARY,
+  GLEXT_PARALLEL_SHADER_COMPILE,
+  GLEXT_TEXTURE_COMPRESSION_S3TC,
+  GLEXT_TEXTURE_COMPRESSION_BPTC,
+
+  GLEXT_MAX,
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// Function pointers
+/////////////////////////////////////////////////////////////////////////////////
+typedef void (GLAD_API_PTR *PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+extern PFNGLBUFFERSTORAGEPROC glext_BufferStorage;
+#define glBufferStorage glext_BufferStorage
+
+typedef void (GLAD_API_PTR *PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+
+extern PFNGLMULTIDRAWELEMENTSINDIRECTPROC glext_MultiDrawElementsIndirect;
+#define glMultiDrawElementsIndirect glext_MultiDrawElementsIndirect
+
+typedef void (GLAD_API_PTR *PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei buf_size, GLsizei* length, GLenum* binary_format, void* binary);
+typedef void (GLAD_API_PTR *PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binary_format, const void* binary, GLsizei length);
+typedef void (GLAD_API_PTR *PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+
+extern PFNGLGETPROGRAMBINARYPROC glext_GetProgramBinary;
+extern PFNGLPROGRAMBINARYPROC glext_ProgramBinary;
+extern PFNGLPROGRAMPARAMETERIPROC glext_ProgramParameteri;
+#define glGetProgramBinary  glext_GetProgramBinary
+#define glProgramBinary     glext_ProgramBinary
+#define glProgramParameteri glext_ProgramParameteri
+
+typedef void (GLAD_API_PTR *PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+extern PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glext_MaxShaderCompilerThreadsKHR;
+#define glMaxShaderCompilerThreadsKHR glext_MaxShaderCompilerThreadsKHR
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// Load every extension function the engine uses.
+// NOTE: This must be called AFTER GLAD has been loaded and the context is current.
+void gl_ext_init();
+
+// Returns 'true' if the given extension (or the GL version it was promoted to) is available.
+const bool gl_ext_supported(const GLExtension ext);
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,294 @@
+#include "gl_state.h"
+#include "defines.h"
+#include "graphics/gl_ext.h"
+
+#include <glad/gl.h>
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+enum BufferTarget {
+  BUFFER_TARGET_ARRAY,
+  BUFFER_TARGET_COPY_READ,
+  BUFFER_TARGET_COPY_WRITE,
+  BUFFER_TARGET_UNIFORM,
+  BUFFER_TARGET_DRAW_INDIRECT,
+  BUFFER_TARGET_PIXEL_UNPACK,
+  BUFFER_TARGET_SHADER_STORAGE,
+  BUFFER_TARGETS_MAX,
+};
+
+enum TextureTarget {
+  TEXTURE_TARGET_2D,
+  TEXTURE_TARGET_CUBE_MAP,
+  TEXTURE_TARGETS_MAX,
+};
+
+#define UNTRACKED -1
+/////////////////////////////////////////////////////////////////////////////////
+
+// GLState
+/////////////////////////////////////////////////////////////////////////////////
+struct GLState {
+  u32 program;
+  u32 vao;
+  u32 buffers[BUFFER_TARGETS_MAX];
+
+  u32 active_unit;
+  u32 textures[GL_STATE_MAX_TEXTURE_UNITS][TEXTURE_TARGETS_MAX];
+  u32 samplers[GL_STATE_MAX_TEXTURE_UNITS];
+
+  bool blend, depth_test, depth_mask;
+
+  GLStateStats frame_stats, last_stats;
+};
+
+static GLState s_state;
+/////////////////////////////////////////////////////////////////////////////////
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static i32 get_buffer_target(const u32 target) {
+  switch(target) {
+    case GL_ARRAY_BUFFER:
+      return BUFFER_TARGET_ARRAY;
+    case GL_COPY_READ_BUFFER:
+      return BUFFER_TARGET_COPY_READ;
+    case GL_COPY_WRITE_BUFFER:
+      return BUFFER_TARGET_COPY_WRITE;
+    case GL_UNIFORM_BUFFER:
+      return BUFFER_TARGET_UNIFORM;
+    case GL_DRAW_INDIRECT_BUFFER:
+      return BUFFER_TARGET_DRAW_INDIRECT;
+    case GL_PIXEL_UNPACK_BUFFER:
+      return BUFFER_TARGET_PIXEL_UNPACK;
+    case GL_SHADER_STORAGE_BUFFER:
+      return BUFFER_TARGET_SHADER_STORAGE;
+    default:
+      return UNTRACKED;
+  }
+}
+
+static i32 get_texture_target(const u32 target) {
+  switch(target) {
+    case GL_TEXTURE_2D:
+      return TEXTURE_TARGET_2D;
+    case GL_TEXTURE_CUBE_MAP:
+      return TEXTURE_TARGET_CUBE_MAP;
+    default:
+      return UNTRACKED;
+  }
+}
+
+// Returns 'true' if the call has to go through to OpenGL
+static bool check_state(const bool changed) {
+  if(changed) {
+    s_state.frame_stats.issued_calls++;
+  }
+  else {
+    s_state.frame_stats.skipped_calls++;
+  }
+
+  return changed;
+}
+
+static void set_capability(bool* current, const u32 cap, const bool enabled) {
+  if(!check_state(*current != enabled)) {
+    return;
+  }
+
+  if(enabled) {
+    glEnable(cap);
+  }
+  else {
+    glDisable(cap);
+  }
+
+  *current = enabled;
+}
+
+static void active_texture(const u32 unit) {
+  if(!check_state(s_state.active_unit != unit)) {
+    return;
+  }
+
+  glActiveTexture(GL_TEXTURE0 + unit);
+  s_state.active_unit = unit;
+}
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+void gl_state_reset() {
+  s_state = GLState{};
+
+  // Everything is disabled by default, besides the depth mask
+  s_state.depth_mask = true;
+}
+
+void gl_state_use_program(const u32 program) {
+  if(!check_state(s_state.program != program)) {
+    return;
+  }
+
+  glUseProgram(program);
+  s_state.program = program;
+}
+
+void gl_state_bind_vertex_array(const u32 vao) {
+  if(!check_state(s_state.vao != vao)) {
+    return;
+  }
+
+  glBindVertexArray(vao);
+  s_state.vao = vao;
+}
+
+void gl_state_bind_buffer(const u32 target, const u32 buffer) {
+  i32 index = get_buffer_target(target);
+  if(index == UNTRACKED) {
+    check_state(true);
+    glBindBuffer(target, buffer);
+
+    return;
+  }
+
+  if(!check_state(s_state.buffers[index] != buffer)) {
+    return;
+  }
+
+  glBindBuffer(target, buffer);
+  s_state.buffers[index] = buffer;
+}
+
+void gl_state_bind_buffer_base(const u32 target, const u32 index, const u32 buffer) {
+  // Indexed bindings are not tracked
+  check_state(true);
+  glBindBufferBase(target, index, buffer);
+
+  i32 target_index = get_buffer_target(target);
+  if(target_index != UNTRACKED) {
+    s_state.buffers[target_index] = buffer;
+  }
+}
+
+void gl_state_bind_texture(const u32 unit, const u32 target, const u32 texture) {
+  i32 index = get_texture_target(target);
+  if(unit >= GL_STATE_MAX_TEXTURE_UNITS || index == UNTRACKED) {
+    check_state(true);
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(target, texture);
+    s_state.frame_stats.texture_binds++;
+
+    // Who knows which unit is active now if it was not tracked
+    s_state.active_unit = unit < GL_STATE_MAX_TEXTURE_UNITS ? unit : (u32)UNTRACKED;
+    return;
+  }
+
+  if(!check_state(s_state.textures[unit][index] != texture)) {
+    return;
+  }
+
+  active_texture(unit);
+  glBindTexture(target, texture);
+  s_state.textures[unit][index] = texture;
+  s_state.frame_stats.texture_binds++;
+}
+
+void gl_state_bind_texture(const u32 target, const u32 texture) {
+  // The active unit is not known. Bind it to the first unit to keep the cache correct.
+  if(s_state.active_unit >= GL_STATE_MAX_TEXTURE_UNITS) {
+    active_texture(0);
+  }
+
+  gl_state_bind_texture(s_state.active_unit, target, texture);
+}
+
+const u32 gl_state_get_texture(const u32 unit, const u32 target) {
+  i32 index = get_texture_target(target);
+  if(unit >= GL_STATE_MAX_TEXTURE_UNITS || index == UNTRACKED) {
+    return 0;
+  }
+
+  return s_state.textures[unit][index];
+}
+
+void gl_state_bind_sampler(const u32 unit, const u32 sampler) {
+  // Samplers are bound by unit, so the active unit does not matter
+  if(unit >= GL_STATE_MAX_TEXTURE_UNITS) {
+    check_state(true);
+    glBindSampler(unit, sampler);
+    return;
+  }
+
+  if(!check_state(s_state.samplers[unit] != sampler)) {
+    return;
+  }
+
+  glBindSampler(unit, sampler);
+  s_state.samplers[unit] = sampler;
+}
+
+void gl_state_set_blend(const bool enabled) {
+  set_capability(&s_state.blend, GL_BLEND, enabled);
+}
+
+void gl_state_set_depth_test(const bool enabled) {
+  set_capability(&s_state.depth_test, GL_DEPTH_TEST, enabled);
+}
+
+void gl_state_set_depth_mask(const bool enabled) {
+  if(!check_state(s_state.depth_mask != enabled)) {
+    return;
+  }
+
+  glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+  s_state.depth_mask = enabled;
+}
+
+void gl_state_forget_program(const u32 program) {
+  if(s_state.program == program) {
+    s_state.program = 0;
+  }
+}
+
+void gl_state_forget_vertex_array(const u32 vao) {
+  if(s_state.vao == vao) {
+    s_state.vao = 0;
+  }
+}
+
+void gl_state_forget_buffer(const u32 buffer) {
+  for(u32 i = 0; i < BUFFER_TARGETS_MAX; i++) {
+    if(s_state.buffers[i] == buffer) {
+      s_state.buffers[i] = 0;
+    }
+  }
+}
+
+void gl_state_forget_texture(const u32 texture) {
+  for(u32 i = 0; i < GL_STATE_MAX_TEXTURE_UNITS; i++) {
+    for(u32 j = 0; j < TEXTURE_TARGETS_MAX; j++) {
+      if(s_state.textures[i][j] == texture) {
+        s_state.textures[i][j] = 0;
+      }
+    }
+  }
+}
+
+void gl_state_forget_sampler(const u32 sampler) {
+  for(u32 i = 0; i < GL_STATE_MAX_TEXTURE_UNITS; i++) {
+    if(s_state.samplers[i] == sampler) {
+      s_state.samplers[i] = 0;
+    }
+  }
+}
+
+void gl_state_end_frame() {
+  s_state.last_stats  = s_state.frame_stats;
+  s_state.frame_stats = GLStateStats{};
+}
+
+const GLStateStats gl_state_get_stats() {
+  return s_state.last_stats;
+}
+/////////////////////////////////////////////////////////////////////////////////
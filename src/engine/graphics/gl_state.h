@@ -0,0 +1,73 @@
+#pragma once
+
+#include "defines.h"
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+// Texture units past this are not tracked and always get bound
+#define GL_STATE_MAX_TEXTURE_UNITS 32
+/////////////////////////////////////////////////////////////////////////////////
+
+// GLStateStats
+/////////////////////////////////////////////////////////////////////////////////
+struct GLStateStats {
+  u32 issued_calls;  // Calls that actually reached OpenGL last frame
+  u32 skipped_calls; // Calls that would not have changed anything last frame
+  u32 texture_binds; // Textures that were actually bound last frame
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// A shadow copy of the OpenGL state the engine touches the most. Every function
+// here only calls into OpenGL if the state would actually change.
+//
+// NOTE: Anything that changes the state below has to go through these functions,
+// otherwise the cache will go out of sync with OpenGL. If that can not be helped,
+// call 'gl_state_reset' afterwards.
+
+// Set every tracked state back to what OpenGL starts with, and forget everything
+// that was bound.
+// NOTE: Must be called once the context is created.
+void gl_state_reset();
+
+void gl_state_use_program(const u32 program);
+void gl_state_bind_vertex_array(const u32 vao);
+
+// NOTE: 'GL_ELEMENT_ARRAY_BUFFER' is part of the VAO's state, so it is never skipped.
+void gl_state_bind_buffer(const u32 target, const u32 buffer);
+
+// Binds to both the indexed binding point and the generic 'target' binding
+void gl_state_bind_buffer_base(const u32 target, const u32 index, const u32 buffer);
+
+// Binds the texture to the given unit, switching the active unit if needed
+void gl_state_bind_texture(const u32 unit, const u32 target, const u32 texture);
+
+// Binds the texture to whatever unit is currently active. Useful when
+// creating textures, where the unit does not matter.
+void gl_state_bind_texture(const u32 target, const u32 texture);
+
+// The texture that is bound to the given unit and target, as far as the cache knows.
+// Returns 0 for units that are not tracked.
+const u32 gl_state_get_texture(const u32 unit, const u32 target);
+
+void gl_state_bind_sampler(const u32 unit, const u32 sampler);
+
+void gl_state_set_blend(const bool enabled);
+void gl_state_set_depth_test(const bool enabled);
+void gl_state_set_depth_mask(const bool enabled);
+
+// OpenGL unbinds objects when they get deleted. These make sure the cache
+// does too, so a new object that reuses the same ID still gets bound.
+void gl_state_forget_program(const u32 program);
+void gl_state_forget_vertex_array(const u32 vao);
+void gl_state_forget_buffer(const u32 buffer);
+void gl_state_forget_texture(const u32 texture);
+void gl_state_forget_sampler(const u32 sampler);
+
+// Should be called once per frame, right before swapping the buffers.
+void gl_state_end_frame();
+
+// The stats of the last finished frame
+const GLStateStats gl_state_get_stats();
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,79 @@
+#include "gpu_memory.h"
+#include "defines.h"
+
+#include <atomic>
+
+// GPUMemory
+/////////////////////////////////////////////////////////////////////////////////
+struct GPUMemory {
+  std::atomic<usizei> used[GPU_MEMORY_TYPES_MAX];
+  std::atomic<usizei> total;
+  std::atomic<usizei> peak;
+};
+
+static GPUMemory s_memory;
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+void gpu_memory_alloc(const GPUMemoryType type, const usizei bytes) {
+  s_memory.used[type] += bytes;
+  usizei total = s_memory.total += bytes;
+
+  // Only ever raise the peak
+  usizei peak = s_memory.peak.load();
+  while(total > peak && !s_memory.peak.compare_exchange_weak(peak, total)) {}
+}
+
+void gpu_memory_free(const GPUMemoryType type, const usizei bytes) {
+  s_memory.used[type] -= bytes;
+  s_memory.total      -= bytes;
+}
+
+const usizei gpu_memory_get(const GPUMemoryType type) {
+  return s_memory.used[type].load();
+}
+
+const usizei gpu_memory_get_total() {
+  return s_memory.total.load();
+}
+
+const usizei gpu_memory_get_peak() {
+  return s_memory.peak.load();
+}
+
+const char* gpu_memory_type_str(const GPUMemoryType type) {
+  switch(type) {
+    case GPU_MEMORY_GEOMETRY:
+      return "Geometry";
+    case GPU_MEMORY_TEXTURES:
+      return "Textures";
+    case GPU_MEMORY_RENDER_TARGETS:
+      return "Render targets";
+    case GPU_MEMORY_STREAMING:
+      return "Streaming";
+    case GPU_MEMORY_UNIFORMS:
+      return "Uniforms";
+    default:
+      return "Unknown";
+  }
+}
+
+const usizei gpu_memory_texture_size(const i32 width, const i32 height, const u32 pixel_size, const bool has_mipmaps) {
+  usizei size = (usizei)width * height * pixel_size;
+  if(!has_mipmaps) {
+    return size;
+  }
+
+  // Every level is a quarter of the one before it
+  i32 w = width, h = height;
+  while(w > 1 || h > 1) {
+    w = w > 1 ? w / 2 : 1;
+    h = h > 1 ? h / 2 : 1;
+
+    size += (usizei)w * h * pixel_size;
+  }
+
+  return size;
+}
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "defines.h"
+
+// GPUMemoryType
+/////////////////////////////////////////////////////////////////////////////////
+enum GPUMemoryType {
+  GPU_MEMORY_GEOMETRY = 0,   // Vertex and index buffers
+  GPU_MEMORY_TEXTURES,       // Textures and cubemaps (with their mipmaps)
+  GPU_MEMORY_RENDER_TARGETS, // Framebuffer attachments
+  GPU_MEMORY_STREAMING,      // Buffers that get rewritten every frame
+  GPU_MEMORY_UNIFORMS,       
+
+  GPU_MEMORY_TYPES_MAX,
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// Keeps count of how many bytes every buffer and texture takes on the GPU, by type. 
+// Whoever allocates GPU memory reports it here, and frees it here once it is deleted.
+// NOTE: Safe to call from any thread.
+void gpu_memory_alloc(const GPUMemoryType type, const usizei bytes);
+void gpu_memory_free(const GPUMemoryType type, const usizei bytes);
+
+// How many bytes are currently allocated for the given type
+const usizei gpu_memory_get(const GPUMemoryType type);
+
+// How many bytes are currently allocated across every type
+const usizei gpu_memory_get_total();
+
+// The most bytes that were ever allocated at once, across every type
+const usizei gpu_memory_get_peak();
+
+// A readable name for the given type
+const char* gpu_memory_type_str(const GPUMemoryType type);
+
+// How many bytes a 2D texture with the given size and bytes per pixel takes, 
+// counting every level of its mipmap if it has one
+const usizei gpu_memory_texture_size(const i32 width, const i32 height, const u32 pixel_size, const bool has_mipmaps);
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,140 @@
+#include "gpu_timer.h"
+#include "defines.h"
+
+#include <glad/gl.h>
+
+#include <vector>
+
+// GPUTimerFrame
+/////////////////////////////////////////////////////////////////////////////////
+// Every query issued in a frame, in the order they were issued
+struct GPUTimerFrame {
+  std::vector<u32> queries;
+  std::vector<GPUTimerPass> passes;
+  u32 used = 0;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// GPUTimer
+/////////////////////////////////////////////////////////////////////////////////
+struct GPUTimer {
+  bool is_init = false;
+
+  GPUTimerFrame frames[GPU_TIMER_FRAMES];
+  u32 frame_index = 0;
+
+  i32 active_pass = -1;
+
+  f64 times[GPU_TIMER_PASSES_MAX];
+};
+
+static GPUTimer s_timer;
+/////////////////////////////////////////////////////////////////////////////////
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static void read_frame(GPUTimerFrame* frame) {
+  if(frame->used == 0) {
+    return;
+  }
+
+  // Queries finish in the order they were issued, so the last one being done means they all are.
+  // If it's not done yet, this frame's results are dropped rather than waiting on them.
+  i32 available = 0;
+  glGetQueryObjectiv(frame->queries[frame->used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+  if(!available) {
+    frame->used = 0;
+    return;
+  }
+
+  f64 times[GPU_TIMER_PASSES_MAX] = {0.0};
+  for(u32 i = 0; i < frame->used; i++) {
+    u64 elapsed = 0;
+    glGetQueryObjectui64v(frame->queries[i], GL_QUERY_RESULT, &elapsed);
+
+    // Nanoseconds to milliseconds
+    times[frame->passes[i]] += (f64)elapsed / 1000000.0;
+  }
+
+  for(u32 i = 0; i < GPU_TIMER_PASSES_MAX; i++) {
+    s_timer.times[i] = times[i];
+  }
+
+  frame->used = 0;
+}
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+const bool gpu_timer_init() {
+  s_timer = GPUTimer{};
+  s_timer.is_init = true;
+
+  return true;
+}
+
+void gpu_timer_shutdown() {
+  gpu_timer_end();
+
+  for(auto& frame : s_timer.frames) {
+    if(!frame.queries.empty()) {
+      glDeleteQueries(frame.queries.size(), frame.queries.data());
+    }
+
+    frame.queries.clear();
+    frame.passes.clear();
+    frame.used = 0;
+  }
+
+  s_timer.is_init = false;
+}
+
+void gpu_timer_begin(const GPUTimerPass pass) {
+  if(!s_timer.is_init || s_timer.active_pass == pass) {
+    return;
+  }
+
+  gpu_timer_end();
+
+  // The pool of each frame grows to however many queries the frame needs
+  GPUTimerFrame* frame = &s_timer.frames[s_timer.frame_index];
+  if(frame->used == frame->queries.size()) {
+    u32 query;
+    glGenQueries(1, &query);
+
+    frame->queries.push_back(query);
+    frame->passes.push_back(pass);
+  }
+
+  frame->passes[frame->used] = pass;
+  glBeginQuery(GL_TIME_ELAPSED, frame->queries[frame->used]);
+  frame->used++;
+
+  s_timer.active_pass = pass;
+}
+
+void gpu_timer_end() {
+  if(s_timer.active_pass == -1) {
+    return;
+  }
+
+  glEndQuery(GL_TIME_ELAPSED);
+  s_timer.active_pass = -1;
+}
+
+void gpu_timer_end_frame() {
+  if(!s_timer.is_init) {
+    return;
+  }
+
+  gpu_timer_end();
+
+  // The next frame in the ring is the oldest one, so it's the most likely to be done
+  s_timer.frame_index = (s_timer.frame_index + 1) % GPU_TIMER_FRAMES;
+  read_frame(&s_timer.frames[s_timer.frame_index]);
+}
+
+const f64 gpu_timer_get_time(const GPUTimerPass pass) {
+  return s_timer.times[pass];
+}
+/////////////////////////////////////////////////////////////////////////////////
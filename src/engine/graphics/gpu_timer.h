@@ -0,0 +1,49 @@
+#pragma once
+
+#include "defines.h"
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+// How many frames of queries are kept in flight. Results are read this many frames
+// after they were issued, by which point the GPU is (almost always) done with them.
+#define GPU_TIMER_FRAMES 4
+/////////////////////////////////////////////////////////////////////////////////
+
+// GPUTimerPass
+/////////////////////////////////////////////////////////////////////////////////
+enum GPUTimerPass {
+  GPU_TIMER_SKYBOX = 0,
+  GPU_TIMER_3D,
+  GPU_TIMER_INSTANCED,
+  GPU_TIMER_2D,
+
+  GPU_TIMER_PASSES_MAX,
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// Measures how long the GPU spends on each pass with 'GL_TIME_ELAPSED' queries. 
+// The queries of each frame are kept in a ring and only read back once they are 
+// done, so timing a pass never makes the CPU wait on the GPU.
+// NOTE: Everything here has to be called on the render thread.
+const bool gpu_timer_init();
+void gpu_timer_shutdown();
+
+// Start timing the given pass. A pass can be timed more than once per frame, and
+// all of its times get added up.
+// NOTE: Only one pass can be timed at a time. Beginning a pass ends the one 
+// that is currently being timed, and does nothing if it is the same pass.
+void gpu_timer_begin(const GPUTimerPass pass);
+
+// Stop timing the current pass (if any)
+void gpu_timer_end();
+
+// Close off the queries of this frame and read back the oldest frame, if the GPU is done with it.
+// NOTE: Should be called once per frame, before swapping the buffers.
+void gpu_timer_end_frame();
+
+// How long (in milliseconds) the GPU spent on the given pass in the 
+// latest frame that was read back
+const f64 gpu_timer_get_time(const GPUTimerPass pass);
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,614 @@
+#include "render_graph.h"
+#include "defines.h"
+#include "core/window.h"
+#include "graphics/gl_state.h"
+#include "graphics/gpu_memory.h"
+#include "graphics/renderer.h"
+#include "graphics/render_thread.h"
+#include "graphics/texture_units.h"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <cstdio>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+#define NO_TEXTURE -1
+
+// The bit of 'PassTargets::clear_mask' for the depth target. The bits below it are the color targets.
+#define CLEAR_DEPTH_BIT (1 << RENDER_GRAPH_MAX_COLOR_TARGETS)
+/////////////////////////////////////////////////////////////////////////////////
+
+// GraphTarget
+/////////////////////////////////////////////////////////////////////////////////
+struct GraphTarget {
+  std::string name;
+  RenderTargetFormat format;
+  glm::ivec2 size; // Follows the window if 0
+
+  // Where the target is used in the compiled order. Both are -1 if the target is not used.
+  i32 first_use, last_use;
+
+  // The texture the target lives in. Always 'NO_TEXTURE' for the backbuffer.
+  i32 texture;
+};
+
+// Everything a pass needs bound before it runs. Worked out when the graph gets compiled.
+struct PassTargets {
+  bool is_backbuffer;
+
+  i32 colors[RENDER_GRAPH_MAX_COLOR_TARGETS];
+  u32 colors_count;
+  i32 depth;
+
+  u32 clear_mask; // Which targets are written for the first time this frame
+  glm::ivec2 size;
+};
+
+struct GraphPass {
+  std::string name;
+  render_pass_func func;
+  void* user_data;
+
+  std::vector<u32> reads, writes;
+
+  bool is_kept;
+  PassTargets targets;
+};
+
+// A texture that backs one or more targets
+struct GraphTexture {
+  RenderTargetFormat format;
+  glm::ivec2 size;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// RenderGraph
+/////////////////////////////////////////////////////////////////////////////////
+struct RenderGraph {
+  // The first target is always the backbuffer
+  std::vector<GraphTarget> targets;
+  std::unordered_map<std::string, u32> targets_lookup;
+
+  std::vector<GraphPass> passes;
+
+  // Compiled state
+  bool is_dirty = true;
+  glm::ivec2 window_size;
+  std::vector<u32> order; // Only the passes that were kept
+  std::vector<GraphTexture> textures;
+  RenderGraphStats stats;
+
+  // Only ever touched by the render thread
+  std::vector<u32> gl_textures;
+  std::vector<GraphTexture> gl_textures_desc;
+  std::map<std::vector<u32>, u32> framebuffers; // Keyed by the textures attached to them
+};
+
+static RenderGraph s_graph;
+/////////////////////////////////////////////////////////////////////////////////
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static void add_backbuffer() {
+  if(!s_graph.targets.empty()) {
+    return;
+  }
+
+  s_graph.targets.push_back(GraphTarget{RENDER_GRAPH_BACKBUFFER, RENDER_TARGET_RGBA8, glm::ivec2(0), -1, -1, NO_TEXTURE});
+  s_graph.targets_lookup[RENDER_GRAPH_BACKBUFFER] = 0;
+}
+
+static i32 find_target(const std::string& name) {
+  add_backbuffer();
+
+  auto it = s_graph.targets_lookup.find(name);
+  if(it == s_graph.targets_lookup.end()) {
+    fprintf(stderr, "[ERROR]: Render target \'%s\' does not exist\n", name.c_str());
+    return -1;
+  }
+
+  return it->second;
+}
+
+static bool is_depth_format(const RenderTargetFormat format) {
+  return format == RENDER_TARGET_DEPTH24_STENCIL8;
+}
+
+static usizei get_texture_size(const GraphTexture& texture) {
+  usizei pixel_size = texture.format == RENDER_TARGET_RGBA16F ? 8 : 4;
+  return pixel_size * texture.size.x * texture.size.y;
+}
+
+static bool sort_passes() {
+  u32 count = s_graph.passes.size();
+
+  std::vector<std::vector<u32>> edges(count);
+  std::vector<u32> incoming(count, 0);
+  auto add_edge = [&](const u32 from, const u32 to) {
+    if(from != to) {
+      edges[from].push_back(to);
+      incoming[to]++;
+    }
+  };
+
+  std::vector<u32> writers;
+  for(u32 t = 0; t < s_graph.targets.size(); t++) {
+    writers.clear();
+    for(u32 p = 0; p < count; p++) {
+      const std::vector<u32>& writes = s_graph.passes[p].writes;
+      if(std::find(writes.begin(), writes.end(), t) != writes.end()) {
+        writers.push_back(p);
+      }
+    }
+
+    // Writers of the same target keep the order they were added in
+    for(u32 i = 1; i < writers.size(); i++) {
+      add_edge(writers[i - 1], writers[i]);
+    }
+
+    // Readers see everything that was written to the target. If they also
+    // write to it themselves, they're already ordered with the writers above.
+    for(u32 p = 0; p < count; p++) {
+      const std::vector<u32>& reads = s_graph.passes[p].reads;
+      if(std::find(reads.begin(), reads.end(), t) == reads.end()) {
+        continue;
+      }
+
+      if(std::find(writers.begin(), writers.end(), p) != writers.end()) {
+        continue;
+      }
+
+      for(auto& writer : writers) {
+        add_edge(writer, p);
+      }
+    }
+  }
+
+  // Passes that do not depend on each other keep the order they were added in
+  std::priority_queue<u32, std::vector<u32>, std::greater<u32>> ready;
+  for(u32 p = 0; p < count; p++) {
+    if(incoming[p] == 0) {
+      ready.push(p);
+    }
+  }
+
+  s_graph.order.clear();
+  while(!ready.empty()) {
+    u32 p = ready.top();
+    ready.pop();
+    s_graph.order.push_back(p);
+
+    for(auto& next : edges[p]) {
+      if(--incoming[next] == 0) {
+        ready.push(next);
+      }
+    }
+  }
+
+  if(s_graph.order.size() != count) {
+    fprintf(stderr, "[ERROR]: The render graph has a cycle. Running the passes in the order they were added\n");
+
+    s_graph.order.clear();
+    for(u32 p = 0; p < count; p++) {
+      s_graph.order.push_back(p);
+    }
+
+    return false;
+  }
+
+  return true;
+}
+
+static void cull_passes() {
+  // Walk back from the backbuffer and keep every pass that writes something a later kept pass needs
+  std::vector<u8> needed(s_graph.targets.size(), 0);
+  needed[0] = 1;
+
+  for(i32 i = s_graph.order.size() - 1; i >= 0; i--) {
+    GraphPass& pass = s_graph.passes[s_graph.order[i]];
+
+    pass.is_kept = false;
+    for(auto& target : pass.writes) {
+      pass.is_kept = pass.is_kept || needed[target];
+    }
+
+    if(!pass.is_kept) {
+      continue;
+    }
+
+    for(auto& target : pass.reads) {
+      needed[target] = 1;
+    }
+  }
+
+  u32 last = 0;
+  for(u32 i = 0; i < s_graph.order.size(); i++) {
+    if(s_graph.passes[s_graph.order[i]].is_kept) {
+      s_graph.order[last++] = s_graph.order[i];
+    }
+  }
+
+  s_graph.stats.passes_count = last;
+  s_graph.stats.culled_count = s_graph.order.size() - last;
+  s_graph.order.resize(last);
+}
+
+static void alias_targets() {
+  for(auto& target : s_graph.targets) {
+    target.first_use = -1;
+    target.last_use  = -1;
+    target.texture   = NO_TEXTURE;
+  }
+
+  // Find out how long each target lives for
+  for(u32 i = 0; i < s_graph.order.size(); i++) {
+    const GraphPass& pass = s_graph.passes[s_graph.order[i]];
+
+    auto use = [i](const u32 index) {
+      GraphTarget& target = s_graph.targets[index];
+      target.first_use    = target.first_use == -1 ? i : target.first_use;
+      target.last_use     = i;
+    };
+
+    for(auto& target : pass.reads) {
+      use(target);
+    }
+    for(auto& target : pass.writes) {
+      use(target);
+    }
+  }
+
+  // Hand out the textures in the order the targets start living
+  std::vector<u32> sorted;
+  for(u32 t = 1; t < s_graph.targets.size(); t++) {
+    if(s_graph.targets[t].first_use != -1) {
+      sorted.push_back(t);
+    }
+  }
+  std::sort(sorted.begin(), sorted.end(), [](const u32 a, const u32 b) {
+    return s_graph.targets[a].first_use < s_graph.targets[b].first_use;
+  });
+
+  s_graph.textures.clear();
+  std::vector<i32> texture_last_use;
+  s_graph.stats.unaliased_memory = 0;
+
+  for(auto& index : sorted) {
+    GraphTarget& target = s_graph.targets[index];
+
+    GraphTexture desc;
+    desc.format = target.format;
+    desc.size   = target.size == glm::ivec2(0) ? s_graph.window_size : target.size;
+    s_graph.stats.unaliased_memory += get_texture_size(desc);
+
+    // Any texture of the same kind that nobody uses anymore will do
+    for(u32 i = 0; i < s_graph.textures.size(); i++) {
+      const GraphTexture& texture = s_graph.textures[i];
+      if(texture.format == desc.format && texture.size == desc.size && texture_last_use[i] < target.first_use) {
+        target.texture = i;
+        break;
+      }
+    }
+
+    if(target.texture == NO_TEXTURE) {
+      target.texture = s_graph.textures.size();
+      s_graph.textures.push_back(desc);
+      texture_last_use.push_back(-1);
+    }
+
+    texture_last_use[target.texture] = target.last_use;
+  }
+
+  s_graph.stats.targets_count  = sorted.size();
+  s_graph.stats.textures_count = s_graph.textures.size();
+  s_graph.stats.memory         = 0;
+  for(auto& texture : s_graph.textures) {
+    s_graph.stats.memory += get_texture_size(texture);
+  }
+}
+
+static void build_pass_targets() {
+  for(u32 i = 0; i < s_graph.order.size(); i++) {
+    GraphPass& pass = s_graph.passes[s_graph.order[i]];
+
+    PassTargets& targets  = pass.targets;
+    targets.is_backbuffer = false;
+    targets.colors_count  = 0;
+    targets.depth         = NO_TEXTURE;
+    targets.clear_mask    = 0;
+    targets.size          = s_graph.window_size;
+
+    for(auto& index : pass.writes) {
+      const GraphTarget& target = s_graph.targets[index];
+
+      if(index == 0) {
+        targets.is_backbuffer = true;
+        continue;
+      }
+
+      targets.size    = s_graph.textures[target.texture].size;
+      bool first_time = target.first_use == (i32)i;
+
+      if(is_depth_format(target.format)) {
+        targets.depth       = target.texture;
+        targets.clear_mask |= first_time ? CLEAR_DEPTH_BIT : 0;
+      }
+      else if(targets.colors_count < RENDER_GRAPH_MAX_COLOR_TARGETS) {
+        targets.clear_mask |= first_time ? (1 << targets.colors_count) : 0;
+        targets.colors[targets.colors_count++] = target.texture;
+      }
+    }
+
+    if(targets.is_backbuffer && (targets.colors_count > 0 || targets.depth != NO_TEXTURE)) {
+      printf("[WARNING]: Render pass \'%s\' writes to the backbuffer and other targets. Only the backbuffer will be written\n", pass.name.c_str());
+    }
+  }
+}
+
+static void compile() {
+  s_graph.window_size = window_get_size();
+
+  add_backbuffer();
+  sort_passes();
+  cull_passes();
+  alias_targets();
+  build_pass_targets();
+
+  s_graph.is_dirty = false;
+}
+
+static void destroy_framebuffers() {
+  for(auto& [textures, fbo] : s_graph.framebuffers) {
+    glDeleteFramebuffers(1, &fbo);
+  }
+
+  s_graph.framebuffers.clear();
+}
+
+static void update_textures(const std::vector<GraphTexture>& textures) {
+  bool changed = s_graph.gl_textures.size() != textures.size();
+
+  // Textures that are not needed anymore
+  for(u32 i = textures.size(); i < s_graph.gl_textures.size(); i++) {
+    gl_state_forget_texture(s_graph.gl_textures[i]);
+    glDeleteTextures(1, &s_graph.gl_textures[i]);
+    gpu_memory_free(GPU_MEMORY_RENDER_TARGETS, get_texture_size(s_graph.gl_textures_desc[i]));
+  }
+  s_graph.gl_textures.resize(textures.size(), 0);
+  s_graph.gl_textures_desc.resize(textures.size(), GraphTexture{RENDER_TARGET_RGBA8, glm::ivec2(0)});
+
+  for(u32 i = 0; i < textures.size(); i++) {
+    const GraphTexture& desc = textures[i];
+    const GraphTexture& old  = s_graph.gl_textures_desc[i];
+    if(s_graph.gl_textures[i] != 0 && old.format == desc.format && old.size == desc.size) {
+      continue;
+    }
+
+    if(s_graph.gl_textures[i] != 0) {
+      gl_state_forget_texture(s_graph.gl_textures[i]);
+      glDeleteTextures(1, &s_graph.gl_textures[i]);
+      gpu_memory_free(GPU_MEMORY_RENDER_TARGETS, get_texture_size(old));
+    }
+
+    u32 internal_format = GL_RGBA8, format = GL_RGBA, type = GL_UNSIGNED_BYTE;
+    if(desc.format == RENDER_TARGET_RGBA16F) {
+      internal_format = GL_RGBA16F;
+      type            = GL_HALF_FLOAT;
+    }
+    else if(desc.format == RENDER_TARGET_DEPTH24_STENCIL8) {
+      internal_format = GL_DEPTH24_STENCIL8;
+      format          = GL_DEPTH_STENCIL;
+      type            = GL_UNSIGNED_INT_24_8;
+    }
+
+    glGenTextures(1, &s_graph.gl_textures[i]);
+    gl_state_bind_texture(GL_TEXTURE_2D, s_graph.gl_textures[i]);
+    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, desc.size.x, desc.size.y, 0, format, type, nullptr);
+
+    s_graph.gl_textures_desc[i] = desc;
+    gpu_memory_alloc(GPU_MEMORY_RENDER_TARGETS, get_texture_size(desc));
+    changed = true;
+  }
+
+  // Framebuffers are keyed by the texture IDs, which can get reused by new textures
+  if(changed) {
+    destroy_framebuffers();
+  }
+}
+
+static void bind_pass_targets(const PassTargets& targets) {
+  if(targets.is_backbuffer) {
+    glBindFramebuffer(GL_FRAMEBUFFER, renderer_get_framebuffer());
+    glViewport(0, 0, targets.size.x, targets.size.y);
+
+    return;
+  }
+
+  std::vector<u32> key;
+  for(u32 i = 0; i < targets.colors_count; i++) {
+    key.push_back(s_graph.gl_textures[targets.colors[i]]);
+  }
+  key.push_back(targets.depth != NO_TEXTURE ? s_graph.gl_textures[targets.depth] : 0);
+
+  auto it = s_graph.framebuffers.find(key);
+  if(it != s_graph.framebuffers.end()) {
+    glBindFramebuffer(GL_FRAMEBUFFER, it->second);
+  }
+  else {
+    u32 fbo;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+    u32 draw_buffers[RENDER_GRAPH_MAX_COLOR_TARGETS];
+    for(u32 i = 0; i < targets.colors_count; i++) {
+      glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, key[i], 0);
+      draw_buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+    }
+
+    if(targets.depth != NO_TEXTURE) {
+      glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, key.back(), 0);
+    }
+
+    // Depth only passes have nothing to draw into
+    if(targets.colors_count > 0) {
+      glDrawBuffers(targets.colors_count, draw_buffers);
+    }
+    else {
+      glDrawBuffer(GL_NONE);
+      glReadBuffer(GL_NONE);
+    }
+
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+      fprintf(stderr, "[ERROR]: Render graph framebuffer is not complete\n");
+    }
+
+    s_graph.framebuffers[key] = fbo;
+  }
+
+  glViewport(0, 0, targets.size.x, targets.size.y);
+
+  // Whatever is in there belongs to another target (or another frame)
+  const f32 black[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  for(u32 i = 0; i < targets.colors_count; i++) {
+    if(targets.clear_mask & (1 << i)) {
+      glClearBufferfv(GL_COLOR, i, black);
+    }
+  }
+
+  if(targets.clear_mask & CLEAR_DEPTH_BIT) {
+    gl_state_set_depth_mask(true);
+    glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
+  }
+}
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+const u32 render_graph_add_target(const std::string& name, const RenderTargetFormat format, const glm::ivec2& size) {
+  add_backbuffer();
+
+  auto it = s_graph.targets_lookup.find(name);
+  if(it != s_graph.targets_lookup.end()) {
+    printf("[WARNING]: Render target \'%s\' already exists\n", name.c_str());
+    return it->second;
+  }
+
+  u32 index = s_graph.targets.size();
+  s_graph.targets.push_back(GraphTarget{name, format, size, -1, -1, NO_TEXTURE});
+  s_graph.targets_lookup[name] = index;
+  s_graph.is_dirty = true;
+
+  return index;
+}
+
+const u32 render_graph_add_pass(const std::string& name, render_pass_func func, void* user_data) {
+  GraphPass pass;
+  pass.name      = name;
+  pass.func      = func;
+  pass.user_data = user_data;
+  pass.is_kept   = false;
+
+  s_graph.passes.push_back(pass);
+  s_graph.is_dirty = true;
+
+  return s_graph.passes.size() - 1;
+}
+
+void render_graph_read(const u32 pass, const std::string& target) {
+  i32 index = find_target(target);
+  if(index == -1) {
+    return;
+  }
+
+  s_graph.passes[pass].reads.push_back(index);
+  s_graph.is_dirty = true;
+}
+
+void render_graph_write(const u32 pass, const std::string& target) {
+  i32 index = find_target(target);
+  if(index == -1) {
+    return;
+  }
+
+  s_graph.passes[pass].writes.push_back(index);
+  s_graph.is_dirty = true;
+}
+
+void render_graph_execute() {
+  // Window-sized targets have to follow the window
+  if(s_graph.is_dirty || s_graph.window_size != glm::ivec2(window_get_size())) {
+    compile();
+  }
+
+  std::vector<GraphTexture> textures = s_graph.textures;
+  render_thread_push([textures]() {
+    update_textures(textures);
+  });
+
+  for(auto& index : s_graph.order) {
+    GraphPass& pass = s_graph.passes[index];
+
+    PassTargets targets = pass.targets;
+    render_thread_push([targets]() {
+      bind_pass_targets(targets);
+    });
+
+    pass.func(pass.user_data);
+  }
+
+  // Anything drawn after the graph goes straight to the backbuffer
+  glm::ivec2 size = s_graph.window_size;
+  render_thread_push([size]() {
+    glBindFramebuffer(GL_FRAMEBUFFER, renderer_get_framebuffer());
+    glViewport(0, 0, size.x, size.y);
+  });
+}
+
+void render_graph_bind_target(const std::string& target, const u32 unit) {
+  i32 index = find_target(target);
+  if(index <= 0 || s_graph.targets[index].texture == NO_TEXTURE) {
+    return;
+  }
+
+  i32 texture = s_graph.targets[index].texture;
+  render_thread_push([texture, unit]() {
+    gl_state_bind_texture(unit, GL_TEXTURE_2D, s_graph.gl_textures[texture]);
+    gl_state_bind_sampler(unit, texture_units_get_sampler(SAMPLER_LINEAR_CLAMP));
+  });
+}
+
+void render_graph_clear() {
+  s_graph.passes.clear();
+  s_graph.targets.clear();
+  s_graph.targets_lookup.clear();
+  s_graph.order.clear();
+  s_graph.textures.clear();
+  s_graph.stats    = RenderGraphStats{};
+  s_graph.is_dirty = true;
+
+  render_thread_push([]() {
+    update_textures(std::vector<GraphTexture>());
+  });
+}
+
+void render_graph_shutdown() {
+  render_graph_clear();
+
+  render_thread_push([]() {
+    destroy_framebuffers();
+  });
+}
+
+const RenderGraphStats render_graph_get_stats() {
+  return s_graph.stats;
+}
+/////////////////////////////////////////////////////////////////////////////////
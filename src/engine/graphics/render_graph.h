@@ -0,0 +1,84 @@
+#pragma once
+
+#include "defines.h"
+
+#include <glm/vec2.hpp>
+
+#include <string>
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+// The name of the framebuffer that ends up on screen (color and depth).
+// Always exists, and passes that write to it are never culled.
+#define RENDER_GRAPH_BACKBUFFER "backbuffer"
+
+// How many color targets a single pass can write to
+#define RENDER_GRAPH_MAX_COLOR_TARGETS 4
+/////////////////////////////////////////////////////////////////////////////////
+
+// Callbacks
+/////////////////////////////////////////////////////////////////////////////////
+typedef void (*render_pass_func)(void* user_data);
+/////////////////////////////////////////////////////////////////////////////////
+
+// RenderTargetFormat
+/////////////////////////////////////////////////////////////////////////////////
+enum RenderTargetFormat {
+  RENDER_TARGET_RGBA8 = 0,
+  RENDER_TARGET_RGBA16F,
+  RENDER_TARGET_DEPTH24_STENCIL8,
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// RenderGraphStats
+/////////////////////////////////////////////////////////////////////////////////
+struct RenderGraphStats {
+  u32 passes_count;   // Passes that actually run
+  u32 culled_count;   // Passes that were culled since nothing used what they wrote
+  u32 targets_count;  // Transient targets in use
+  u32 textures_count; // Textures backing the transient targets
+
+  usizei memory;          // Bytes taken by the transient textures
+  usizei unaliased_memory; // Bytes they would take if no two targets shared a texture
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// A graph of render passes that read and write named targets. Passes are added once
+// (usually at startup) and run every frame with 'render_graph_execute', which:
+//
+//  - Orders them, so every pass runs after the passes that write what it reads.
+//    Passes that write the same target run in the order they were added.
+//  - Culls every pass that does not (eventually) contribute to the backbuffer.
+//  - Lets transient targets whose lifetimes do not overlap share the same texture.
+//
+// NOTE: The contents of a transient target only live for one frame. Each one is cleared
+// by the first pass that writes to it, since its texture could have been used by another
+// target right before. The backbuffer is never cleared by the graph.
+
+// Declare a transient target. A 'size' of 0 follows the size of the window.
+const u32 render_graph_add_target(const std::string& name, const RenderTargetFormat format, const glm::ivec2& size = glm::ivec2(0));
+
+// Add a pass that calls 'func' every frame. The pass is bound to a framebuffer with every
+// target it writes attached before 'func' gets called.
+// NOTE: 'func' is called on the game thread, just like the rest of the rendering.
+const u32 render_graph_add_pass(const std::string& name, render_pass_func func, void* user_data = nullptr);
+
+// Declare what the given pass reads and writes
+void render_graph_read(const u32 pass, const std::string& target);
+void render_graph_write(const u32 pass, const std::string& target);
+
+// Run every pass that was not culled, in order
+void render_graph_execute();
+
+// Bind the texture of a target that the current pass reads to the given unit
+void render_graph_bind_target(const std::string& target, const u32 unit);
+
+// Remove every pass and target, and free the textures
+void render_graph_clear();
+void render_graph_shutdown();
+
+// The stats of the last compiled graph
+const RenderGraphStats render_graph_get_stats();
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,124 @@
+#include "render_queue.h"
+#include "defines.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+#define KEY_PASS_SHIFT 62
+
+#define KEY_SHADER_BITS   8
+#define KEY_MATERIAL_BITS 16
+#define KEY_MESH_BITS     16
+#define KEY_DEPTH_BITS    22
+
+#define KEY_MASK(bits) ((((u64)1) << (bits)) - 1)
+
+#define RADIX_BITS    8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+/////////////////////////////////////////////////////////////////////////////////
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static u64 quantize_depth(const f32 depth) {
+  f32 clamped = glm::clamp(depth, 0.0f, 1.0f);
+  return (u64)(clamped * (f32)KEY_MASK(KEY_DEPTH_BITS));
+}
+
+static void radix_sort(std::vector<RenderSortEntry>& entries, std::vector<RenderSortEntry>& scratch) {
+  scratch.resize(entries.size());
+
+  RenderSortEntry* src = entries.data();
+  RenderSortEntry* dst = scratch.data();
+
+  // LSD radix sort. One pass per byte of the key.
+  for(u32 shift = 0; shift < 64; shift += RADIX_BITS) {
+    usizei counts[RADIX_BUCKETS] = {0};
+    for(usizei i = 0; i < entries.size(); i++) {
+      counts[(src[i].key >> shift) & (RADIX_BUCKETS - 1)]++;
+    }
+
+    // Every key has the same byte here. Nothing to sort in this pass.
+    if(counts[(src[0].key >> shift) & (RADIX_BUCKETS - 1)] == entries.size()) {
+      continue;
+    }
+
+    // Turn the counts into starting offsets
+    usizei offset = 0;
+    for(u32 i = 0; i < RADIX_BUCKETS; i++) {
+      usizei count = counts[i];
+      counts[i] = offset;
+      offset += count;
+    }
+
+    for(usizei i = 0; i < entries.size(); i++) {
+      dst[counts[(src[i].key >> shift) & (RADIX_BUCKETS - 1)]++] = src[i];
+    }
+
+    RenderSortEntry* temp = src;
+    src = dst;
+    dst = temp;
+  }
+
+  // Make sure the sorted result ends up in 'entries'
+  if(src != entries.data()) {
+    entries.swap(scratch);
+  }
+}
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+const u64 render_queue_make_key(const RenderPass pass, const u32 shader, const u32 material, const u32 mesh, const f32 depth) {
+  u64 key = ((u64)pass) << KEY_PASS_SHIFT;
+
+  u64 shader_bits   = shader & KEY_MASK(KEY_SHADER_BITS);
+  u64 material_bits = material & KEY_MASK(KEY_MATERIAL_BITS);
+  u64 mesh_bits     = mesh & KEY_MASK(KEY_MESH_BITS);
+
+  // Opaque: state first, then front to back
+  if(pass == RENDER_PASS_OPAQUE) {
+    key |= shader_bits   << (KEY_MATERIAL_BITS + KEY_MESH_BITS + KEY_DEPTH_BITS);
+    key |= material_bits << (KEY_MESH_BITS + KEY_DEPTH_BITS);
+    key |= mesh_bits     << KEY_DEPTH_BITS;
+    key |= quantize_depth(depth);
+  }
+  // Transparent: back to front first, then state
+  else {
+    key |= (KEY_MASK(KEY_DEPTH_BITS) - quantize_depth(depth)) << (KEY_SHADER_BITS + KEY_MATERIAL_BITS + KEY_MESH_BITS);
+    key |= shader_bits   << (KEY_MATERIAL_BITS + KEY_MESH_BITS);
+    key |= material_bits << KEY_MESH_BITS;
+    key |= mesh_bits;
+  }
+
+  return key;
+}
+
+const RenderPass render_queue_key_pass(const u64 key) {
+  return (RenderPass)(key >> KEY_PASS_SHIFT);
+}
+
+void render_queue_push(RenderQueue* queue, const RenderCommand& cmd) {
+  queue->commands.push_back(cmd);
+}
+
+void render_queue_sort(RenderQueue* queue) {
+  queue->entries.resize(queue->commands.size());
+  if(queue->entries.empty()) {
+    return;
+  }
+
+  for(u32 i = 0; i < queue->commands.size(); i++) {
+    queue->entries[i] = RenderSortEntry{queue->commands[i].key, i};
+  }
+
+  radix_sort(queue->entries, queue->scratch);
+}
+
+void render_queue_clear(RenderQueue* queue) {
+  queue->commands.clear();
+  queue->entries.clear();
+}
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "defines.h"
+#include "resources/mesh.h"
+#include "resources/material.h"
+
+#include <vector>
+
+// RenderPass
+/////////////////////////////////////////////////////////////////////////////////
+// The pass is stored in the top bits of the sort key, so every opaque draw
+// gets executed before any transparent draw.
+enum RenderPass {
+  RENDER_PASS_OPAQUE      = 0,
+  RENDER_PASS_TRANSPARENT = 1,
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// RenderCommand
+/////////////////////////////////////////////////////////////////////////////////
+struct RenderCommand {
+  u64 key;
+
+  Mesh* mesh;
+  Material* material;
+  MeshInstance instance;
+
+  u8 lod; // Which of 'mesh->lods' gets drawn
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// RenderQueue
+/////////////////////////////////////////////////////////////////////////////////
+struct RenderSortEntry {
+  u64 key;
+  u32 index; // Index into 'RenderQueue::commands'
+};
+
+struct RenderQueue {
+  std::vector<RenderCommand> commands;
+
+  // The order the commands should be executed in after 'render_queue_sort'
+  std::vector<RenderSortEntry> entries;
+  std::vector<RenderSortEntry> scratch;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// Build a 64-bit sort key out of the given draw state.
+//
+// Opaque draws are keyed as (pass | shader | material | mesh | depth), so draws that share
+// state end up next to each other and are ordered front to back within each group.
+// Transparent draws are keyed as (pass | inverted depth | shader | material | mesh), so
+// they get ordered back to front regardless of their state.
+//
+// NOTE: 'depth' is expected to be normalized between 0 and 1. The IDs are truncated
+// to fit the key, which can only make sorting less optimal. It can never make it wrong.
+const u64 render_queue_make_key(const RenderPass pass, const u32 shader, const u32 material, const u32 mesh, const f32 depth);
+
+// Extract the pass out of a key created with 'render_queue_make_key'
+const RenderPass render_queue_key_pass(const u64 key);
+
+void render_queue_push(RenderQueue* queue, const RenderCommand& cmd);
+
+// Radix sort all of the commands by their keys. The result is written into 'queue->entries'.
+void render_queue_sort(RenderQueue* queue);
+
+// Remove all the commands but keep the memory around for the next frame
+void render_queue_clear(RenderQueue* queue);
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,198 @@
+#include "render_thread.h"
+#include "defines.h"
+#include "core/window.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+// RenderThread
+/////////////////////////////////////////////////////////////////////////////////
+struct RenderThread {
+  std::thread handle;
+  std::thread::id id;
+  bool is_running = false;
+
+  std::mutex mutex;
+  std::condition_variable cond;
+
+  // The game thread records into 'lists[frame_index]' while the render
+  // thread replays the other one
+  std::vector<RenderCommandFunc> lists[2];
+  u32 frame_index = 0;
+  bool has_frame  = false; // The other list was submitted and is not done replaying yet
+
+  // The command of the 'render_thread_call' that is currently waiting
+  const RenderCommandFunc* call = nullptr;
+
+  bool should_quit = false;
+};
+
+static RenderThread s_thread;
+/////////////////////////////////////////////////////////////////////////////////
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static void replay_list(std::vector<RenderCommandFunc>& list) {
+  for(auto& cmd : list) {
+    cmd();
+  }
+
+  // Keep the memory around for the next time this list gets recorded
+  list.clear();
+}
+
+static void thread_loop() {
+  window_set_current_context();
+
+  std::unique_lock<std::mutex> lock(s_thread.mutex);
+  while(true) {
+    s_thread.cond.wait(lock, []() {
+      return s_thread.has_frame || s_thread.call || s_thread.should_quit;
+    });
+
+    // The submitted frame always goes first. Calls only ever run between two frames,
+    // so they never see the GL state of a half-replayed one.
+    if(s_thread.has_frame) {
+      std::vector<RenderCommandFunc>& list = s_thread.lists[s_thread.frame_index ^ 1];
+
+      lock.unlock();
+      replay_list(list);
+      lock.lock();
+
+      s_thread.has_frame = false;
+      s_thread.cond.notify_all();
+      continue;
+    }
+
+    if(s_thread.call) {
+      lock.unlock();
+      (*s_thread.call)();
+      lock.lock();
+
+      s_thread.call = nullptr;
+      s_thread.cond.notify_all();
+      continue;
+    }
+
+    if(s_thread.should_quit) {
+      break;
+    }
+  }
+
+  window_release_current_context();
+}
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+const bool render_thread_init() {
+  if(s_thread.is_running) {
+    return true;
+  }
+
+  // A context can only be current on one thread at a time
+  window_release_current_context();
+
+  s_thread.should_quit = false;
+  s_thread.has_frame   = false;
+  s_thread.frame_index = 0;
+  s_thread.is_running  = true;
+
+  s_thread.handle = std::thread(thread_loop);
+  s_thread.id     = s_thread.handle.get_id();
+
+  return true;
+}
+
+void render_thread_shutdown() {
+  if(!s_thread.is_running) {
+    return;
+  }
+
+  // Anything that was recorded since the last frame (usually resources being freed)
+  render_thread_submit();
+  render_thread_wait();
+
+  {
+    std::lock_guard<std::mutex> lock(s_thread.mutex);
+    s_thread.should_quit = true;
+  }
+  s_thread.cond.notify_all();
+
+  s_thread.handle.join();
+  s_thread.is_running = false;
+
+  window_set_current_context();
+}
+
+void render_thread_push(const RenderCommandFunc& cmd) {
+  if(render_thread_is_current()) {
+    cmd();
+    return;
+  }
+
+  // Only the game thread ever touches the list being recorded
+  s_thread.lists[s_thread.frame_index].push_back(cmd);
+}
+
+void render_thread_call(const RenderCommandFunc& cmd) {
+  if(render_thread_is_current()) {
+    cmd();
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(s_thread.mutex);
+
+  // Only one call at a time
+  s_thread.cond.wait(lock, []() {
+    return s_thread.call == nullptr;
+  });
+
+  s_thread.call = &cmd;
+  s_thread.cond.notify_all();
+
+  s_thread.cond.wait(lock, [&cmd]() {
+    return s_thread.call != &cmd;
+  });
+}
+
+void render_thread_wait() {
+  if(!s_thread.is_running) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(s_thread.mutex);
+  s_thread.cond.wait(lock, []() {
+    return !s_thread.has_frame;
+  });
+}
+
+void render_thread_submit() {
+  if(!s_thread.is_running) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(s_thread.mutex);
+  s_thread.cond.wait(lock, []() {
+    return !s_thread.has_frame;
+  });
+
+  s_thread.frame_index ^= 1;
+  s_thread.has_frame    = true;
+  s_thread.cond.notify_all();
+}
+
+const u32 render_thread_get_frame_index() {
+  return s_thread.frame_index;
+}
+
+const bool render_thread_is_current() {
+  if(!s_thread.is_running) {
+    return true;
+  }
+
+  return std::this_thread::get_id() == s_thread.id;
+}
+/////////////////////////////////////////////////////////////////////////////////
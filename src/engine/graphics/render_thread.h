@@ -0,0 +1,54 @@
+#pragma once
+
+#include "defines.h"
+
+#include <functional>
+
+// Callbacks
+/////////////////////////////////////////////////////////////////////////////////
+typedef std::function<void()> RenderCommandFunc;
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// A dedicated thread that owns the OpenGL context. The game thread records a frame
+// worth of commands into one list while the render thread replays the list of the
+// previous frame, so the simulation of frame N overlaps the GPU submission of frame N - 1.
+//
+// NOTE: Every function here runs the command right away (on the calling thread) if the render
+// thread was never started, or if it is called from the render thread itself. That makes it
+// safe to nest them, and keeps everything working when the engine runs on one thread.
+
+// Releases the current context from the calling thread and gives it to a new render thread.
+// NOTE: Must be called right after the window is created, before anything touches OpenGL.
+const bool render_thread_init();
+
+// Replays whatever was still recorded, then joins the thread and hands the context back.
+void render_thread_shutdown();
+
+// Record a command into the current frame's list. It runs once the frame gets submitted,
+// after everything that was recorded before it.
+// NOTE: Anything the command references must stay alive until it runs. That is why
+// resources record their destruction with this function instead of freeing right away.
+void render_thread_push(const RenderCommandFunc& cmd);
+
+// Run the command on the render thread and wait for it to finish. Used for work that has
+// to happen right now, like creating GL objects while loading resources.
+// NOTE: This skips ahead of the commands that were recorded but not submitted yet.
+void render_thread_call(const RenderCommandFunc& cmd);
+
+// Wait until the render thread is done replaying the last submitted frame
+void render_thread_wait();
+
+// Wait on the last submitted frame, then hand the recorded list over to the render thread.
+// NOTE: Should be called once per frame, after everything was recorded.
+void render_thread_submit();
+
+// Which of the two lists is being recorded (either 0 or 1). Anything a recorded command
+// reads can be double buffered with this, since the render thread is done with a
+// list by the time the game thread records into it again.
+const u32 render_thread_get_frame_index();
+
+// Returns 'true' if called from the thread that owns the OpenGL context
+const bool render_thread_is_current();
+/////////////////////////////////////////////////////////////////////////////////
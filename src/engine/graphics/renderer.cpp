@@ -3,7 +3,18 @@
 #include "defines.h"
 #include "graphics/camera.h"
 #include "graphics/shader.h"
+#include "graphics/gl_ext.h"
+#include "graphics/gl_state.h"
+#include "graphics/geometry_arena.h"
+#include "graphics/gpu_timer.h"
+#include "graphics/gpu_memory.h"
+#include "graphics/render_queue.h"
+#include "graphics/render_thread.h"
+#include "graphics/stream_buffer.h"
+#include "graphics/texture_units.h"
+#include "graphics/texture_residency.h"
 #include "math/vertex.h"
+#include "math/frustum.h"
 #include "resources/cubemap.h"
 #include "resources/material.h"
 #include "resources/mesh.h"
@@ -18,9 +29,12 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/ext/matrix_clip_space.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #include <string>
 #include <cstdio>
+#include <cstring>
 #include <vector>
 
 // ShaderType
@@ -33,6 +47,68 @@ enum ShaderType {
 };
 /////////////////////////////////////////////////////////////////////////////////
 
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+// Should match the far plane of the camera's projection
+#define RENDER_DEPTH_RANGE 100.0f
+
+// How far (in pixels) a LOD can stray from the full mesh on screen before a finer one is picked
+#define LOD_ERROR_THRESHOLD 1.0f
+
+// A LOD only gets coarser once its error is this much below the threshold, and only gets finer 
+// once it is this much above it. Keeps models that sit right on the threshold from popping.
+#define LOD_HYSTERESIS 0.25f
+
+// The size of the uniform buffer with the camera matrices
+#define UBO_SIZE (sizeof(f32) * 1024)
+/////////////////////////////////////////////////////////////////////////////////
+
+// DrawIndirectCommand
+/////////////////////////////////////////////////////////////////////////////////
+// The layout 'glMultiDrawElementsIndirect' expects. One per run of instances of the same mesh.
+struct DrawIndirectCommand {
+  u32 count;
+  u32 instance_count;
+  u32 first_index;
+  i32 base_vertex;
+  u32 base_instance; // Relative to the start of the instances of the current chunk
+};
+
+// A range of draw commands that share the same material, pass, and index type, and so can be
+// issued with one multi draw call
+struct DrawGroup {
+  Material* material;
+  RenderPass pass;
+  bool has_short_indices;
+
+  u32 first_command;
+  u32 commands_count;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// RenderBatch
+/////////////////////////////////////////////////////////////////////////////////
+// Everything submitted between a 'renderer_begin' and a 'renderer_end'. Recorded by 
+// the game thread and flushed by the render thread.
+struct RenderBatch {
+  RenderQueue queue;
+
+  // The world-space box of each queued command, in the same order as 'queue.commands'
+  AABBBatch cull_boxes;
+  Frustum frustum;
+
+  // Used to find how big each texture is on screen
+  glm::vec3 cam_position;
+  f32 lod_scale;
+};
+
+// Every batch recorded in a frame. Kept around between frames so their memory gets reused.
+struct RenderFrame {
+  std::vector<RenderBatch> batches;
+  u32 batches_count = 0;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
 // Renderer
 /////////////////////////////////////////////////////////////////////////////////
 struct Renderer {
@@ -40,12 +116,40 @@ struct Renderer {
   Shader* current_shader = nullptr;
 
   u32 ubo; // Uniform buffer
-  u32 instance_count = 0;
-  glm::mat4* transforms = nullptr;
+
+  // Everything gets rendered in here instead of the default framebuffer 
+  // when the window is headless, since it has none
+  u32 offscreen_fbo = 0, offscreen_color = 0, offscreen_depth = 0;
+  usizei offscreen_memory = 0;
+
+  // One frame for each command list of the render thread, so the game thread 
+  // can record a frame while the render thread flushes the previous one
+  RenderFrame frames[2];
+  RenderBatch* current_batch = nullptr;
+
+  // Used to compute the depth of each draw
+  glm::vec3 cam_position, cam_front;
+
+  // Turns a size at a distance of 1 into pixels on screen
+  f32 lod_scale;
+
+  // Only ever touched by the render thread while flushing
+  std::vector<MeshInstance> sorted_instances;
+  std::vector<DrawIndirectCommand> draw_commands;
+  std::vector<DrawGroup> draw_groups;
+  std::vector<u8> cull_results;
+
+  // The material that was last used while flushing
+  Material* bound_material = nullptr;
+
+  // 'stats' is filled by the render thread and saved in 'presented_stats' once a frame 
+  // gets presented. 'last_stats' is the copy the game thread reads.
+  RendererStats stats, presented_stats, last_stats;
 
   Mesh* cube_mesh = nullptr;
   Mesh* skybox_mesh = nullptr;
   Material* default_material = nullptr;
+  Material* cube_material = nullptr;
 };
 
 static Renderer renderer;
@@ -53,6 +157,35 @@ static Renderer renderer;
 
 // Private functions
 /////////////////////////////////////////////////////////////////////////////////
+static bool create_offscreen_target() {
+  glm::vec2 size = window_get_size();
+
+  glGenRenderbuffers(1, &renderer.offscreen_color);
+  glBindRenderbuffer(GL_RENDERBUFFER, renderer.offscreen_color);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.x, size.y);
+
+  glGenRenderbuffers(1, &renderer.offscreen_depth);
+  glBindRenderbuffer(GL_RENDERBUFFER, renderer.offscreen_depth);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size.x, size.y);
+
+  // 4 bytes per pixel for each of them
+  renderer.offscreen_memory = (usizei)size.x * size.y * 4 * 2;
+  gpu_memory_alloc(GPU_MEMORY_RENDER_TARGETS, renderer.offscreen_memory);
+
+  glGenFramebuffers(1, &renderer.offscreen_fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, renderer.offscreen_fbo);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderer.offscreen_color);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderer.offscreen_depth);
+
+  if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    printf("[ERROR]: Failed to create the offscreen framebuffer\n");
+    return false;
+  }
+
+  // Stays bound for the rest of the program
+  return true;
+}
+
 bool gl_init() {
   // Loading GLAD
   if(!gladLoadGL(glfwGetProcAddress)) {
@@ -63,18 +196,26 @@ bool gl_init() {
     window_set_current_context();
   }
 
+  // Load everything newer than what GLAD gives us
+  gl_ext_init();
+
   // Setting the GL viewport size
   glm::vec2 win_size = window_get_size();
   glViewport(0, 0, win_size.x, win_size.y);
+
+  if(window_is_headless() && !create_offscreen_target()) {
+    return false;
+  }
  
   // Setting options
   glEnable(GL_STENCIL_TEST);
   glEnable(GL_MULTISAMPLE); 
   
-  glEnable(GL_DEPTH_TEST);
+  gl_state_reset();
+  gl_state_set_depth_test(true);
   glDepthFunc(GL_LEQUAL); // Need this to enable back to front rendering for 2D 
 
-  glEnable(GL_BLEND);
+  gl_state_set_blend(true);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
   return true;
@@ -90,6 +231,10 @@ static void load_shaders() {
     "layout (location = 0) in vec3 aPos;\n"
     "layout (location = 1) in vec3 aNormal;\n"
     "layout (location = 2) in vec2 aTextureCoords;\n"
+    "layout (location = 3) in vec3 aInstancePos;\n"
+    "layout (location = 4) in vec4 aColor;\n"
+    "layout (location = 5) in vec4 aRotation;\n"
+    "layout (location = 6) in vec3 aScale;\n"
     "\n"
     "// Uniform block\n"
     "layout(std140, binding = 0) uniform matrices {\n"
@@ -100,15 +245,20 @@ static void load_shaders() {
     "out VS_OUT {\n"
     "  vec3 normal;\n"
     "  vec2 texture_coords;\n"
+    "  vec4 color;\n"
     "} vs_out;\n"
     "\n"
-    "uniform mat4 u_model;\n"
+    "vec3 rotate(vec4 q, vec3 v) {\n"
+    "  return v + 2.0f * cross(q.xyz, cross(q.xyz, v) + q.w * v);\n"
+    "}\n"
     "\n"
     "void main() {\n"
-    "  gl_Position = u_view_projection * u_model * vec4(aPos, 1.0f);\n"
+    "  vec3 world_pos = aInstancePos + rotate(aRotation, aPos * aScale);\n"
+    "  gl_Position = u_view_projection * vec4(world_pos, 1.0f);\n"
 
     "  vs_out.normal = aNormal;\n"
     "  vs_out.texture_coords = aTextureCoords;\n"
+    "  vs_out.color = aColor;\n"
     "}\n"
     "\n"
     "@type fragment\n"
@@ -118,17 +268,27 @@ static void load_shaders() {
     "in VS_OUT {\n"
     "  vec3 normal;\n"
     "  vec2 texture_coords;\n"
+    "  vec4 color;\n"
     "} fs_in;\n"
     "\n"
     "// Outputs\n"
     "out vec4 frag_color;\n"
     "\n"
     "// Uniforms\n"
-    "uniform vec4 u_color;\n"
     "uniform sampler2D u_diffuse, u_specular;\n"
+    "uniform int u_material_index;\n"
+    "\n"
+    "// Materials\n"
+    "struct MaterialData {\n"
+    "  vec4 color;\n"
+    "};\n"
+    "\n"
+    "layout(std430, binding = 1) readonly buffer materials {\n"
+    "  MaterialData u_materials[];\n"
+    "};\n"
     "\n"
     "void main() {\n"
-    "  frag_color = texture(u_diffuse, fs_in.texture_coords) * u_color;\n"
+    "  frag_color = texture(u_diffuse, fs_in.texture_coords) * fs_in.color * u_materials[u_material_index].color;\n"
     "}\n";
 
   std::string inst_code = 
@@ -139,8 +299,10 @@ static void load_shaders() {
     "layout (location = 0) in vec3 aPos;\n"
     "layout (location = 1) in vec3 aNormal;\n"
     "layout (location = 2) in vec2 aTexCoords;\n"
-    "layout (location = 3) in mat4 aModel;\n"
-    "// layout (location = 4) in vec4 aColor;\n"
+    "layout (location = 3) in vec3 aInstancePos;\n"
+    "layout (location = 4) in vec4 aColor;\n"
+    "layout (location = 5) in vec4 aRotation;\n"
+    "layout (location = 6) in vec3 aScale;\n"
     "\n"
     "// Uniform block\n"
     "layout(std140, binding = 0) uniform matrices {\n"
@@ -154,12 +316,17 @@ static void load_shaders() {
     "  vec4 color;\n"
     "} vs_out;\n"
     "\n"
+    "vec3 rotate(vec4 q, vec3 v) {\n"
+    "  return v + 2.0f * cross(q.xyz, cross(q.xyz, v) + q.w * v);\n"
+    "}\n"
+    "\n"
     "void main() {\n"
-    "  gl_Position = u_view_projection * aModel * vec4(aPos, 1.0f);\n"
+    "  vec3 world_pos = aInstancePos + rotate(aRotation, aPos * aScale);\n"
+    "  gl_Position = u_view_projection * vec4(world_pos, 1.0f);\n"
     "\n"
     "  vs_out.normal = aNormal;\n"
     "  vs_out.texture_coords = aTexCoords;\n"
-    "  // vs_out.color = aColor;\n"
+    "  vs_out.color = aColor;\n"
     "}\n"
     "\n"
     "@type fragment\n"
@@ -176,10 +343,19 @@ static void load_shaders() {
     "out vec4 frag_color;\n"
     "\n"
     "// Uniforms\n"
-    "uniform vec4 u_color;\n"
+    "uniform int u_material_index;\n"
+    "\n"
+    "// Materials\n"
+    "struct MaterialData {\n"
+    "  vec4 color;\n"
+    "};\n"
+    "\n"
+    "layout(std430, binding = 1) readonly buffer materials {\n"
+    "  MaterialData u_materials[];\n"
+    "};\n"
     "\n"
     "void main() {\n"
-    "  frag_color = vec4(0.4f, 0.4f, 0.4f, 1.0f);\n"
+    "  frag_color = fs_in.color * u_materials[u_material_index].color;\n"
     "}";
 
   std::string cubemap_shader_code = 
@@ -194,10 +370,12 @@ static void load_shaders() {
     "} vs_out;\n"
     "// Uniforms\n"
     "uniform mat4 u_view, u_projection;"
+    "uniform vec3 u_mesh_min, u_mesh_extent;\n"
     "\n"
     "void main() {\n"
-    " vs_out.texture_coords = aPos; // The local position of the cubemap is actually its texture coords\n"
-    " vec4 pos = u_projection * u_view * vec4(aPos, 1.0f);\n"
+    " vec3 local_pos = u_mesh_min + aPos * u_mesh_extent; // Back from the quantized position\n"
+    " vs_out.texture_coords = local_pos; // The local position of the cubemap is actually its texture coords\n"
+    " vec4 pos = u_projection * u_view * vec4(local_pos, 1.0f);\n"
     " gl_Position = pos.xyww;\n"
     "}\n"
     "\n"
@@ -269,23 +447,340 @@ static void build_skybox_mesh() {
   vertices.push_back({glm::vec3(-1.0f, -1.0f,  1.0f), glm::vec3(0.0f), glm::vec3(0.0f)});
   vertices.push_back({glm::vec3( 1.0f, -1.0f,  1.0f), glm::vec3(0.0f), glm::vec3(0.0f)});
 
-  renderer.skybox_mesh = mesh_create(vertices, std::vector<u32>());
+  renderer.skybox_mesh = resources_acquire_mesh(vertices, std::vector<u32>());
+}
+
+// A zeroed quaternion is treated as "no rotation" by the transforms 
+static glm::quat get_rotation(const glm::quat& rotation) {
+  return glm::length(rotation) > 0.0f ? glm::normalize(rotation) : glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+}
+
+static MeshInstance pack_instance(const Mesh* mesh, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale, const glm::vec4& color) {
+  glm::quat rot = get_rotation(rotation);
+  glm::vec4 rot_snorm = glm::round(glm::clamp(glm::vec4(rot.x, rot.y, rot.z, rot.w), -1.0f, 1.0f) * 32767.0f);
+
+  // The positions in the arena might be quantized within the bounds of the mesh. 
+  // Scaling and offsetting them back is folded into the instance transform, so the 
+  // shaders never have to know about it.
+  MeshInstance instance; 
+  instance.position = position + rot * (scale * mesh->dequantize_offset); 
+  instance.color    = glm::packUnorm4x8(color);
+  instance.rotation = glm::i16vec4(rot_snorm);
+  instance.scale    = scale * mesh->dequantize_scale;
+
+  return instance;
+}
+
+static void submit_instance(Mesh* mesh, Material* mat, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale, const glm::vec4& color, const u32 lod = 0) {
+  // Nothing gets drawn outside of 'renderer_begin' and 'renderer_end'
+  RenderBatch* batch = renderer.current_batch;
+  if(!batch) {
+    return;
+  }
+
+  // The material's own color gets applied by the shader, but still decides the pass
+  f32 depth       = glm::dot(position - renderer.cam_position, renderer.cam_front) / RENDER_DEPTH_RANGE;
+  RenderPass pass = (color.a < 1.0f || mat->color.a < 1.0f) ? RENDER_PASS_TRANSPARENT : RENDER_PASS_OPAQUE;
+
+  RenderCommand cmd;
+  u32 lod_index = glm::min(lod, mesh->lods_count - 1);
+
+  // Each LOD sorts as its own mesh, so instances of the same LOD end up in the same draw
+  cmd.key      = render_queue_make_key(pass, mat->shader ? mat->shader->id : 0, mat->id, mesh->id * MESH_MAX_LODS + lod_index, depth);
+  cmd.mesh     = mesh;
+  cmd.material = mat;
+  cmd.instance = pack_instance(mesh, position, rotation, scale, color);
+  cmd.lod      = (u8)lod_index;
+
+  render_queue_push(&batch->queue, cmd);
+  aabb_batch_push(&batch->cull_boxes, mesh->min, mesh->max, position, rotation, scale);
+}
+
+static u32 select_model_lod(const Transform& transform, const Model* model, const u32 current) {
+  if(model->meshes.empty()) {
+    return 0;
+  }
+
+  // The bounding sphere of the whole model in world space
+  glm::vec3 min = model->meshes[0]->min;
+  glm::vec3 max = model->meshes[0]->max;
+  u32 lods_count = 1;
+  for(auto& mesh : model->meshes) {
+    min = glm::min(min, mesh->min);
+    max = glm::max(max, mesh->max);
+    lods_count = glm::max(lods_count, mesh->lods_count);
+  }
+
+  f32 max_scale    = glm::max(glm::abs(transform.scale.x), glm::max(glm::abs(transform.scale.y), glm::abs(transform.scale.z)));
+  glm::vec3 center = transform.position + get_rotation(transform.rotation) * (((min + max) * 0.5f) * transform.scale);
+  f32 radius       = glm::length(max - min) * 0.5f * max_scale;
+
+  // The camera is inside the model. Nothing but the full model will do.
+  f32 distance = glm::length(center - renderer.cam_position);
+  if(distance <= radius) {
+    return 0;
+  }
+
+  // Every mesh of the model switches LODs together, so it is only as good as its worst mesh
+  auto projected_error = [&](const u32 lod) {
+    f32 error = 0.0f;
+    for(auto& mesh : model->meshes) {
+      error = glm::max(error, mesh->lods[glm::min(lod, mesh->lods_count - 1)].error);
+    }
+
+    return error * max_scale * renderer.lod_scale / distance;
+  };
+
+  u32 lod = glm::min(current, lods_count - 1);
+  
+  // Go finer while the current LOD is visibly off...
+  while(lod > 0 && projected_error(lod) > LOD_ERROR_THRESHOLD * (1.0f + LOD_HYSTERESIS)) {
+    lod--;
+  }
+
+  // ...and coarser while the next one would still look the same
+  while(lod + 1 < lods_count && projected_error(lod + 1) <= LOD_ERROR_THRESHOLD * (1.0f - LOD_HYSTERESIS)) {
+    lod++;
+  }
+
+  return lod;
+}
+
+static void cull_queue(RenderBatch* batch) {
+  RenderQueue* queue = &batch->queue;
+
+  renderer.cull_results.resize(queue->commands.size());
+  u32 visible = frustum_cull(batch->frustum, batch->cull_boxes, renderer.cull_results.data());
+
+  renderer.stats.visible_count += visible;
+  renderer.stats.culled_count  += queue->commands.size() - visible;
+
+  // Only keep the commands that can actually be seen
+  if(visible != queue->commands.size()) {
+    u32 last = 0;
+    for(u32 i = 0; i < queue->commands.size(); i++) {
+      if(renderer.cull_results[i]) {
+        queue->commands[last++] = queue->commands[i];
+      }
+    }
+
+    queue->commands.resize(last);
+  }
+}
+
+static GLenum get_index_type(const bool is_short) {
+  return is_short ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+static usizei get_index_size(const bool is_short) {
+  return is_short ? sizeof(u16) : sizeof(u32);
+}
+
+static void bind_group_state(const DrawGroup& group) {
+  // Instanced cubes and regular meshes are timed separately
+  bool is_instanced = group.material->shader == renderer.shaders[SHADER_INSTANCE];
+  gpu_timer_begin(is_instanced ? GPU_TIMER_INSTANCED : GPU_TIMER_3D);
+
+  // Transparent draws should not occlude each other
+  gl_state_set_depth_mask(group.pass == RENDER_PASS_OPAQUE);
+
+  // Only rebind the shader and textures if they actually changed
+  if(group.material != renderer.bound_material) {
+    material_use(group.material);
+    renderer.bound_material = group.material;
+  }
+}
+
+static void build_draw_commands(const RenderQueue* queue, const u32 first, const u32 count) {
+  renderer.draw_commands.clear();
+  renderer.draw_groups.clear();
+
+  u32 run = first;
+  while(run < first + count) {
+    const RenderCommand& cmd = queue->commands[queue->entries[run].index];
+    RenderPass pass = render_queue_key_pass(cmd.key);
+
+    // Find the end of the run of instances of the same mesh
+    u32 run_end = run + 1;
+    for(; run_end < first + count; run_end++) {
+      const RenderCommand& next = queue->commands[queue->entries[run_end].index];
+      if(next.mesh != cmd.mesh || next.lod != cmd.lod || next.material != cmd.material || render_queue_key_pass(next.key) != pass) {
+        break;
+      }
+    }
+
+    DrawIndirectCommand draw;
+    draw.count          = cmd.mesh->lods[cmd.lod].index_range.count;
+    draw.instance_count = run_end - run;
+    draw.first_index    = cmd.mesh->lods[cmd.lod].index_range.offset;
+    draw.base_vertex    = (i32)cmd.mesh->vertex_range.offset;
+    draw.base_instance  = run - first;
+
+    // Different meshes with the same state can all go in the same group
+    bool new_group = renderer.draw_groups.empty() || 
+                     renderer.draw_groups.back().material != cmd.material || 
+                     renderer.draw_groups.back().pass != pass || 
+                     renderer.draw_groups.back().has_short_indices != cmd.mesh->has_short_indices;
+    if(new_group) {
+      renderer.draw_groups.push_back(DrawGroup{cmd.material, pass, cmd.mesh->has_short_indices, (u32)renderer.draw_commands.size(), 0});
+    }
+
+    renderer.draw_commands.push_back(draw);
+    renderer.draw_groups.back().commands_count++;
+
+    run = run_end;
+  }
+}
+
+static void execute_draw_commands(const usizei instances_offset) {
+  const u32 stream_id = stream_buffer_get_id();
+
+  // One call per group, with every command read straight from the GPU
+  if(gl_ext_supported(GLEXT_MULTI_DRAW_INDIRECT)) {
+    usizei size = sizeof(DrawIndirectCommand) * renderer.draw_commands.size();
+    void* data  = stream_buffer_map(size, sizeof(u32));
+    if(!data) {
+      return;
+    }
+
+    memcpy(data, renderer.draw_commands.data(), size);
+    usizei commands_offset = stream_buffer_unmap(size);
+
+    gl_state_bind_buffer(GL_DRAW_INDIRECT_BUFFER, stream_id);
+    for(auto& group : renderer.draw_groups) {
+      bind_group_state(group);
+
+      void* indirect = (void*)(commands_offset + sizeof(DrawIndirectCommand) * group.first_command);
+      glMultiDrawElementsIndirect(GL_TRIANGLES, get_index_type(group.has_short_indices), indirect, group.commands_count, sizeof(DrawIndirectCommand));
+
+      renderer.stats.draw_calls++;
+      for(u32 i = 0; i < group.commands_count; i++) {
+        const DrawIndirectCommand& draw = renderer.draw_commands[group.first_command + i];
+        renderer.stats.triangles += (draw.count / 3) * draw.instance_count;
+      }
+    }
+    gl_state_bind_buffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    return;
+  }
+
+  // No multi draw. Issue every command on its own, moving the instance 
+  // attributes to where its instances start instead of using a base instance.
+  for(auto& group : renderer.draw_groups) {
+    bind_group_state(group);
+
+    for(u32 i = 0; i < group.commands_count; i++) {
+      const DrawIndirectCommand& draw = renderer.draw_commands[group.first_command + i];
+      geometry_arena_set_instance_buffer(stream_id, instances_offset + sizeof(MeshInstance) * draw.base_instance);
+
+      void* indices = (void*)(get_index_size(group.has_short_indices) * draw.first_index);
+      glDrawElementsInstancedBaseVertex(GL_TRIANGLES, draw.count, get_index_type(group.has_short_indices), indices, draw.instance_count, draw.base_vertex);
+
+      renderer.stats.draw_calls++;
+      renderer.stats.triangles += (draw.count / 3) * draw.instance_count;
+    }
+  }
+}
+
+// Let the residency manager know how big the textures of everything that is about to be drawn are on screen
+static void touch_textures(const RenderBatch* batch) {
+  for(auto& cmd : batch->queue.commands) {
+    Texture* texture = cmd.material->diffuse_map;
+    if(!texture) {
+      continue;
+    }
+
+    // The instance's scale already covers the whole box of the mesh
+    f32 diameter = glm::length(glm::vec3(cmd.instance.scale));
+    f32 distance = glm::length(cmd.instance.position - batch->cam_position);
+
+    texture_residency_touch(texture, diameter * batch->lod_scale / glm::max(distance, diameter * 0.5f));
+  }
+}
+
+static void flush_queue(RenderBatch* batch) {
+  RenderQueue* queue = &batch->queue;
+
+  // Only the materials that changed since the last batch get uploaded
+  renderer.stats.bytes_uploaded += material_flush_buffer();
+
+  // Get rid of everything outside the camera's view before doing any more work
+  cull_queue(batch);
+  touch_textures(batch);
+  render_queue_sort(queue);
+
+  // Lay the instances out in the sorted order, so each run of draws that
+  // share the same state can be drawn straight out of one contiguous range
+  renderer.sorted_instances.resize(queue->entries.size());
+  for(u32 i = 0; i < queue->entries.size(); i++) {
+    renderer.sorted_instances[i] = queue->commands[queue->entries[i].index].instance;
+  }
+
+  renderer.bound_material = nullptr;
+
+  // A single mapping can only hold so much. Draw the instances in chunks if there are too many.
+  // NOTE: Aligning the start of a region can take up to 'sizeof(MeshInstance) - 1' bytes of it.
+  const u32 max_instances = (STREAM_BUFFER_REGION_SIZE - (sizeof(MeshInstance) - 1)) / sizeof(MeshInstance);
+  for(u32 first = 0; first < renderer.sorted_instances.size(); first += max_instances) {
+    u32 count   = glm::min<u32>(renderer.sorted_instances.size() - first, max_instances);
+    usizei size = sizeof(MeshInstance) * count;
+
+    // Write the instances into the stream buffer and point the arena at them
+    void* data = stream_buffer_map(size, sizeof(MeshInstance));
+    if(!data) {
+      break;
+    }
+
+    memcpy(data, &renderer.sorted_instances[first], size);
+    usizei offset = stream_buffer_unmap(size);
+    geometry_arena_set_instance_buffer(stream_buffer_get_id(), offset);
+
+    build_draw_commands(queue, first, count);
+    execute_draw_commands(offset);
+  }
+
+  gpu_timer_end();
+  gl_state_set_depth_mask(true);
+}
+
+static bool create_buffers() {
+  // Every renderer streams its per-frame data through this buffer
+  if(!stream_buffer_init()) {
+    return false;
+  }
+
+  // Every mesh lives in this arena
+  if(!geometry_arena_init()) {
+    return false;
+  }
+
+  // Give the instance attributes a valid buffer until the first instances get streamed in
+  geometry_arena_set_instance_buffer(stream_buffer_get_id(), 0);
+
+  // Creating uniform buffer  
+  glGenBuffers(1, &renderer.ubo);
+  gl_state_bind_buffer(GL_UNIFORM_BUFFER, renderer.ubo);
+  glBufferData(GL_UNIFORM_BUFFER, UBO_SIZE, nullptr, GL_DYNAMIC_DRAW);
+  gl_state_bind_buffer_base(GL_UNIFORM_BUFFER, 0, renderer.ubo);
+  gpu_memory_alloc(GPU_MEMORY_UNIFORMS, UBO_SIZE);
+
+  return true;
 }
 /////////////////////////////////////////////////////////////////////////////////
 
 // Public functions
 /////////////////////////////////////////////////////////////////////////////////
 const bool renderer_create() {
-  if(!gl_init()) {
+  // Everything here touches OpenGL directly, so it has to happen on the render thread
+  bool success = false;
+  render_thread_call([&success]() {
+    success = gl_init() && create_buffers() && gpu_timer_init() && texture_units_init();
+  });
+
+  if(!success) {
     return false;
   }
 
-  // Creating uniform buffer  
-  glGenBuffers(1, &renderer.ubo);
-  glBindBuffer(GL_UNIFORM_BUFFER, renderer.ubo);
-  glBufferData(GL_UNIFORM_BUFFER, sizeof(f32) * 1024, nullptr, GL_DYNAMIC_DRAW);
-  glBindBufferBase(GL_UNIFORM_BUFFER, 0, renderer.ubo);
-
   // Load all the default shaders
   load_shaders();
 
@@ -293,117 +788,186 @@ const bool renderer_create() {
   build_skybox_mesh();
 
   // Creating the instance mesh
-  renderer.cube_mesh = mesh_create();
+  renderer.cube_mesh = resources_acquire_mesh(RESOURCES_MESH_CUBE);
 
   // Load the default material
   u32 pixels = 0xffffffff;
   Texture* diffuse = texture_load(1, 1, TEXTURE_FORMAT_RGBA, &pixels); 
   renderer.default_material = resources_add_material("default_material", diffuse, nullptr, renderer.shaders[SHADER_DEFAULT]);
 
-  // Allocate the transforms array
-  renderer.transforms = new glm::mat4[MAX_MESH_INSTANCES];
-
-  // Cube Mesh model matrix layout 
-  glBindVertexArray(renderer.cube_mesh->vao); 
-  glBindBuffer(GL_ARRAY_BUFFER, renderer.cube_mesh->ibo);
-  
-  // 1st colomn
-  glEnableVertexAttribArray(3);
-  glVertexAttribPointer(3, 4, GL_FLOAT, false, sizeof(glm::mat4), 0);
-  glVertexAttribDivisor(3, 1); // Enabling instancing for the mesh
-  
-  // 2nd colomn
-  glEnableVertexAttribArray(4);
-  glVertexAttribPointer(4, 4, GL_FLOAT, false, sizeof(glm::mat4), (void*)(sizeof(f32) * 4));
-  glVertexAttribDivisor(4, 1);
-  
-  // 3rd colomn
-  glEnableVertexAttribArray(5);
-  glVertexAttribPointer(5, 4, GL_FLOAT, false, sizeof(glm::mat4), (void*)(sizeof(f32) * 8));
-  glVertexAttribDivisor(5, 1);
-  
-  // 4th colomn
-  glEnableVertexAttribArray(6);
-  glVertexAttribPointer(6, 4, GL_FLOAT, false, sizeof(glm::mat4), (void*)(sizeof(f32) * 12));
-  glVertexAttribDivisor(6, 1);
+  // The cubes are not textured. They only use the color of each instance
+  renderer.cube_material = resources_add_material("cube_material", nullptr, nullptr, renderer.shaders[SHADER_INSTANCE]);
 
   return true;
 }
 
 void renderer_destroy() {
-  delete[] renderer.transforms;
- 
-  mesh_destroy(renderer.cube_mesh);
+  resources_release_mesh(renderer.cube_mesh);
+  resources_release_mesh(renderer.skybox_mesh);
+
+  // The render thread might still be flushing the last frame
+  render_thread_push([]() {
+    for(auto& frame : renderer.frames) {
+      frame.batches.clear();
+      frame.batches_count = 0;
+    }
+    renderer.sorted_instances.clear();
+
+    gpu_timer_shutdown();
+    texture_units_shutdown();
+    texture_shutdown_uploads();
+    texture_residency_shutdown();
+    material_shutdown_buffer();
+    geometry_arena_shutdown();
+    stream_buffer_shutdown();
+
+    gl_state_forget_buffer(renderer.ubo);
+    glDeleteBuffers(1, &renderer.ubo);
+    gpu_memory_free(GPU_MEMORY_UNIFORMS, UBO_SIZE);
+
+    if(renderer.offscreen_fbo) {
+      glDeleteFramebuffers(1, &renderer.offscreen_fbo);
+      glDeleteRenderbuffers(1, &renderer.offscreen_color);
+      glDeleteRenderbuffers(1, &renderer.offscreen_depth);
+
+      gpu_memory_free(GPU_MEMORY_RENDER_TARGETS, renderer.offscreen_memory);
+    }
+  });
 }
 
 void renderer_clear(const glm::vec4& color) {
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-  glClearColor(color.r, color.g, color.b, color.a);
+  render_thread_push([color]() {
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glClearColor(color.r, color.g, color.b, color.a);
+  });
 }
 
 void renderer_begin(const Camera* cam) {
+  // Start a new batch in the frame that is being recorded
+  RenderFrame* frame = &renderer.frames[render_thread_get_frame_index()];
+  if(frame->batches_count == frame->batches.size()) {
+    frame->batches.emplace_back();
+  }
+
+  RenderBatch* batch = &frame->batches[frame->batches_count++];
+  render_queue_clear(&batch->queue);
+  aabb_batch_clear(&batch->cull_boxes);
+  batch->frustum = cam->frustum;
+
+  renderer.current_batch = batch;
+  renderer.cam_position  = cam->position;
+  renderer.cam_front     = cam->front;
+  renderer.lod_scale     = cam->projection[1][1] * window_get_size().y * 0.5f;
+
+  batch->cam_position = renderer.cam_position;
+  batch->lod_scale    = renderer.lod_scale;
+
   // Upload the view projection matrices through the uniform buffer 
-  glBindBuffer(GL_UNIFORM_BUFFER, renderer.ubo);
-  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), glm::value_ptr(cam->view_projection));
+  glm::mat4 view_projection = cam->view_projection;
+  render_thread_push([view_projection]() {
+    gl_state_bind_buffer(GL_UNIFORM_BUFFER, renderer.ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), glm::value_ptr(view_projection));
+    renderer.stats.bytes_uploaded += sizeof(glm::mat4);
+  });
 }
 
 void renderer_end() {
-  shader_bind(renderer.shaders[SHADER_INSTANCE]);
-
-  // Upload the transform matrices to the instance buffer to be renderer 
-  glBindBuffer(GL_ARRAY_BUFFER, renderer.cube_mesh->ibo); 
-  glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(glm::mat4) * renderer.instance_count, renderer.transforms);
+  if(!renderer.current_batch) {
+    return;
+  }
 
-  // Render all of the instances of the mesh
-  glBindVertexArray(renderer.cube_mesh->vao);
-  glDrawElementsInstanced(GL_TRIANGLES, renderer.cube_mesh->indices.size(), GL_UNSIGNED_INT, 0, renderer.instance_count);
+  // Sort and flush all of the draws that were queued since 'renderer_begin'. 
+  // The batch is found by its index since the frame's array can still grow.
+  u32 frame_index = render_thread_get_frame_index();
+  u32 batch_index = renderer.frames[frame_index].batches_count - 1;
+  render_thread_push([frame_index, batch_index]() {
+    flush_queue(&renderer.frames[frame_index].batches[batch_index]);
+  });
 
-  // Clear the instances 
-  renderer.instance_count = 0; 
+  renderer.current_batch = nullptr;
 }
 
 void renderer_present() {
-  window_swap_buffers();
+  render_thread_push([]() {
+    // Shaders the driver is done compiling
+    shader_poll_compiles();
+
+    // Textures that finished loading, or streamed in a new mip. They get sampled from the next frame on.
+    texture_residency_update();
+    renderer.stats.bytes_uploaded += texture_flush_uploads();
+
+    gl_state_end_frame();
+    gpu_timer_end_frame();
+    texture_units_end_frame();
+    stream_buffer_end_frame();
+
+    // Fold in the stats the other modules kept for this frame
+    GLStateStats state_stats = gl_state_get_stats();
+    renderer.stats.state_changes = state_stats.issued_calls;
+    renderer.stats.texture_binds = state_stats.texture_binds;
+
+    // Everything streamed this frame, on top of the buffer and texture uploads
+    StreamBufferStats stream_stats = stream_buffer_get_stats();
+    renderer.stats.bytes_uploaded += stream_stats.bytes_streamed;
+    renderer.stats.fence_wait_time = stream_stats.fence_wait_time * 1000.0;
+
+    for(u32 i = 0; i < GPU_TIMER_PASSES_MAX; i++) {
+      renderer.stats.gpu_times[i] = gpu_timer_get_time((GPUTimerPass)i);
+    }
+
+    renderer.presented_stats = renderer.stats;
+    renderer.stats           = RendererStats{};
+
+    window_swap_buffers();
+  });
+
+  // The render thread sits idle between these two, so its stats can be read safely
+  render_thread_wait();
+  renderer.last_stats = renderer.presented_stats;
+
+  // Start replaying this frame, and record the next one over the frame that just finished
+  render_thread_submit();
+  renderer.frames[render_thread_get_frame_index()].batches_count = 0;
 }
 
-void render_mesh(const Transform& transform, Mesh* mesh, Material* mat) {
-  if(mat) {
-    material_use(mat); 
-    material_set_color(mat, mat->color);
-    material_set_model(mat, transform.transform);
-  }
+const RendererStats renderer_get_stats() {
+  return renderer.last_stats;
+}
 
-  glBindVertexArray(mesh->vao);
+const u32 renderer_get_framebuffer() {
+  return renderer.offscreen_fbo;
+}
 
-  if(mesh->indices.size() > 0) {
-    glDrawElements(GL_TRIANGLES, mesh->indices.size(), GL_UNSIGNED_INT, 0);
-  }
-  else if(mesh->vertices.size() > 0) {
-    glDrawArrays(GL_TRIANGLES, 0, mesh->vertices.size());
-  }
-  else {
+void renderer_count_draws(const u32 draw_calls, const u32 triangles) {
+  renderer.stats.draw_calls += draw_calls;
+  renderer.stats.triangles  += triangles;
+}
+
+void render_mesh(const Transform& transform, Mesh* mesh, Material* mat) {
+  if(mesh->lods[0].index_range.count == 0) {
     fprintf(stderr, "[WARNING]: Cannot render mesh. Can't find vertices or indices");
+    return;
+  }
+
+  if(!mat) {
+    mat = renderer.default_material;
   }
+
+  submit_instance(mesh, mat, transform.position, transform.rotation, transform.scale, glm::vec4(1.0f));
 }
 
 void render_mesh(const Transform& transform, Mesh* mesh, const glm::vec4& color) {
-  renderer.default_material->color = color;
-  render_mesh(transform, mesh, renderer.default_material);
+  if(mesh->lods[0].index_range.count == 0) {
+    fprintf(stderr, "[WARNING]: Cannot render mesh. Can't find vertices or indices");
+    return;
+  }
+
+  submit_instance(mesh, renderer.default_material, transform.position, transform.rotation, transform.scale, color);
 }
 
 void render_cube(const glm::vec3& position, const glm::vec3& scale, const f32& rotation, const glm::vec4& color) {
-  // Empty the instance buffer and refill it again since we reached the max
-  if(renderer.instance_count >= MAX_MESH_INSTANCES) {
-    renderer_end();
-  }
-
-  glm::mat4 model(1.0f);
-  model = glm::translate(model, position) * 
-          glm::rotate(model, rotation, glm::vec3(1.0f)) *
-          glm::scale(model, scale);
-  
-  renderer.transforms[renderer.instance_count] = model;
-  renderer.instance_count++;
+  glm::quat rot = glm::angleAxis(rotation, glm::normalize(glm::vec3(1.0f)));
+  submit_instance(renderer.cube_mesh, renderer.cube_material, position, rot, scale, color);
 }
 
 void render_cube(const glm::vec3& position, const glm::vec3& scale, const glm::vec4& color) {
@@ -411,13 +975,32 @@ void render_cube(const glm::vec3& position, const glm::vec3& scale, const glm::v
 }
 
 void render_model(const Transform& transform, Model* model) {
+  u32 lod = 0;
+  render_model(transform, model, &lod);
+}
+
+void render_model(const Transform& transform, Model* model, u32* lod) {
   if(!model) {
     // @TODO: Warn logger or assert here???? 
     return;
   }
 
+  *lod = select_model_lod(transform, model, *lod);
+
   for(u32 i = 0; i < model->meshes.size(); i++) {
-    render_mesh(transform, model->meshes[i], model->materials[model->material_ids[i]]); 
+    Mesh* mesh    = model->meshes[i];
+    Material* mat = model->materials[model->material_ids[i]];
+
+    if(mesh->lods[0].index_range.count == 0) {
+      fprintf(stderr, "[WARNING]: Cannot render mesh. Can't find vertices or indices");
+      continue;
+    }
+
+    if(!mat) {
+      mat = renderer.default_material;
+    }
+
+    submit_instance(mesh, mat, transform.position, transform.rotation, transform.scale, glm::vec4(1.0f), *lod);
   }
 }
 
@@ -426,16 +1009,30 @@ void render_cubemap(CubeMap* cm, const Camera* cam) {
     return;
   }
 
-  glDepthMask(GL_FALSE);
+  glm::mat4 view       = glm::mat4(glm::mat3(cam->view));
+  glm::mat4 projection = cam->projection;
+
+  render_thread_push([cm, view, projection]() {
+    gpu_timer_begin(GPU_TIMER_SKYBOX);
+    gl_state_set_depth_mask(false);
+
+    Mesh* mesh = renderer.skybox_mesh;
 
-  shader_bind(renderer.shaders[SHADER_CUBEMAP]);
-  shader_upload_mat4(renderer.shaders[SHADER_CUBEMAP], "u_view", glm::mat4(glm::mat3(cam->view)));
-  shader_upload_mat4(renderer.shaders[SHADER_CUBEMAP], "u_projection", cam->projection);
+    shader_bind(renderer.shaders[SHADER_CUBEMAP]);
+    shader_upload_mat4(renderer.shaders[SHADER_CUBEMAP], "u_view", view);
+    shader_upload_mat4(renderer.shaders[SHADER_CUBEMAP], "u_projection", projection);
+    shader_upload_vec3(renderer.shaders[SHADER_CUBEMAP], "u_mesh_min", mesh->dequantize_offset);
+    shader_upload_vec3(renderer.shaders[SHADER_CUBEMAP], "u_mesh_extent", mesh->dequantize_scale);
 
-  glBindVertexArray(renderer.skybox_mesh->vao); 
-  cubemap_use(cm);
-  glDrawArrays(GL_TRIANGLES, 0, renderer.skybox_mesh->vertices.size());
+    geometry_arena_bind();
+    shader_upload_int(renderer.shaders[SHADER_CUBEMAP], "u_cubemap", cubemap_use(cm));
+    const GeometryRange& indices = mesh->lods[0].index_range;
+    void* offset = (void*)(get_index_size(mesh->has_short_indices) * indices.offset);
+    glDrawElementsBaseVertex(GL_TRIANGLES, indices.count, get_index_type(mesh->has_short_indices), offset, mesh->vertex_range.offset);
+    renderer_count_draws(1, indices.count / 3);
 
-  glDepthMask(GL_TRUE);
+    gl_state_set_depth_mask(true);
+    gpu_timer_end();
+  });
 }
 /////////////////////////////////////////////////////////////////////////////////
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "graphics/camera.h"
+#include "graphics/gpu_timer.h"
 #include "resources/cubemap.h"
 #include "resources/material.h"
 #include "resources/mesh.h"
@@ -10,17 +11,61 @@
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 
+// RendererStats
+/////////////////////////////////////////////////////////////////////////////////
+struct RendererStats {
+  u32 visible_count; // Draws that passed frustum culling 
+  u32 culled_count;  // Draws that were outside the camera's view and never reached GL
+
+  u32 draw_calls;        // Every 'glDraw*' call. A multi draw counts as one.
+  u32 triangles;         // Across every instance that was drawn
+  u32 state_changes;     // State calls that got past the state cache and reached GL
+  u32 texture_binds;     
+  usizei bytes_uploaded; // Streamed vertices, instances, and draw commands, plus buffer and texture uploads
+  f64 fence_wait_time;   // How long (in milliseconds) the CPU waited on the GPU to free up stream buffer regions
+
+  // How long (in milliseconds) the GPU spent on each pass. These are a few
+  // frames older than the rest of the stats, so the CPU never waits on them.
+  f64 gpu_times[GPU_TIMER_PASSES_MAX];
+};
+/////////////////////////////////////////////////////////////////////////////////
+
 // Public functions
 /////////////////////////////////////////////////////////////////////////////////
+// NOTE: None of the functions below draw anything right away. They are recorded on the 
+// calling (game) thread and replayed by the render thread once 'renderer_present' submits 
+// the frame, while the game thread moves on to the next frame.
+
 const bool renderer_create();
 void renderer_destroy();
 
 void renderer_clear(const glm::vec4& color);
 void renderer_begin(const Camera* cam);
+// Flushes every mesh and cube that was submitted since 'renderer_begin'
 void renderer_end();
+
+// Submit everything recorded this frame to the render thread. Waits for the 
+// previous frame to be done first, so the game can only ever be one frame ahead.
 void renderer_present();
 
+// The stats of the last presented frame
+const RendererStats renderer_get_stats();
+
+// The framebuffer that ends up on screen. That is 0 (the default framebuffer), 
+// unless the window is headless.
+// NOTE: Must be called from the render thread.
+const u32 renderer_get_framebuffer();
+
+// Add draws that were issued outside of this renderer (like by the 2D renderer) to the stats
+// NOTE: Must be called from the render thread, while replaying the draws.
+void renderer_count_draws(const u32 draw_calls, const u32 triangles);
+
 // Render a mesh using the given material at the given transform
+// NOTE: Meshes are not drawn immediately. They are queued and sorted by their state and 
+// depth in 'renderer_end', where all the meshes that share a material get drawn with 
+// one multi draw indirect call (or one instanced draw per mesh if that is not supported). Colors with an alpha below 1 are drawn after everything else, 
+// back to front. Anything outside the camera's frustum gets culled (using the mesh's 
+// 'min' and 'max') before it reaches GL. If no material is given, the default material will be used.
 void render_mesh(const Transform& transform, Mesh* mesh, Material* mat);
 
 // Render the mesh using the default basic material
@@ -34,6 +79,12 @@ void render_cube(const glm::vec3& position, const glm::vec3& scale, const glm::v
 // NOTE: This function will not render anything if the model is a 'nullptr'
 void render_model(const Transform& transform, Model* model);
 
+// Render a 3D model at the LOD that fits how big it is on screen. The LOD picked is written
+// back to 'lod', and should be passed in again next frame. A model only switches LODs once 
+// it is clearly past the switching distance, so it does not pop back and forth around it.
+// NOTE: Every instance of the model should keep its own 'lod' (starting at 0).
+void render_model(const Transform& transform, Model* model, u32* lod);
+
 // Render the given cubemap
 void render_cubemap(CubeMap* cm, const Camera* cam);
 /////////////////////////////////////////////////////////////////////////////////
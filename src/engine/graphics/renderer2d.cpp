@@ -3,6 +3,13 @@
 #include "defines.h"
 #include "math/vertex.h"
 #include "graphics/shader.h"
+#include "graphics/gl_state.h"
+#include "graphics/gpu_timer.h"
+#include "graphics/gpu_memory.h"
+#include "graphics/renderer.h"
+#include "graphics/render_thread.h"
+#include "graphics/stream_buffer.h"
+#include "graphics/texture_residency.h"
 
 #include "resources/texture.h"
 #include "resources/font.h"
@@ -13,6 +20,8 @@
 #include <glad/gl.h>
 
 #include <cstddef>
+#include <cstring>
+#include <array>
 #include <vector>
 #include <string>
 
@@ -27,10 +36,17 @@
 // Renderer2d
 /////////////////////////////////////////////////////////////////////////////////
 struct Renderer2D {
-  u32 vao, vbo, ebo;
+  u32 vao, ebo;
+
+  // The vertices of every batch recorded in a frame, one array for each command list of 
+  // the render thread. Each batch gets copied into the stream buffer once it is replayed.
+  std::vector<Vertex2D> frames[2];
+  std::vector<Vertex2D>* vertices = nullptr;
+  u32 frame_index = 0;
+  usizei batch_start = 0;
 
-  std::vector<Vertex2D> vertices;
   Texture* textures[MAX_TEXTURES];
+  f32 texture_sizes[MAX_TEXTURES]; // The biggest each texture was drawn in this batch (in pixels)
   glm::vec4 quad_vertices[4];
 
   Shader* batch_shader = nullptr;
@@ -50,7 +66,6 @@ static Renderer2D renderer;
 static void setup_buffers() {
   // Gen buffers
   glGenVertexArrays(1, &renderer.vao);
-  glGenBuffers(1, &renderer.vbo);
   glGenBuffers(1, &renderer.ebo);
 
   // Index buffer data 
@@ -69,15 +84,17 @@ static void setup_buffers() {
   }
 
   // VAO
-  glBindVertexArray(renderer.vao);
+  gl_state_bind_vertex_array(renderer.vao);
 
-  // VBO
-  glBindBuffer(GL_ARRAY_BUFFER, renderer.vbo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex2D) * MAX_VERTICES, nullptr, GL_DYNAMIC_DRAW);
+  // VBO 
+  // The vertices live in the shared stream buffer. Each batch is drawn 
+  // with a base vertex that points to where it was written.
+  gl_state_bind_buffer(GL_ARRAY_BUFFER, stream_buffer_get_id());
 
   // EBO 
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderer.ebo);
+  gl_state_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, renderer.ebo);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(u32) * MAX_INDICES, indices, GL_STATIC_DRAW);
+  gpu_memory_alloc(GPU_MEMORY_GEOMETRY, sizeof(u32) * MAX_INDICES);
 
   // Layout 
   // Position 
@@ -96,7 +113,7 @@ static void setup_buffers() {
   glEnableVertexAttribArray(3);
   glVertexAttribPointer(3, 1, GL_FLOAT, false, sizeof(Vertex2D), (void*)offsetof(Vertex2D, texture_index));
 
-  glBindVertexArray(0);
+  gl_state_bind_vertex_array(0);
 }
 
 static void load_shaders() {
@@ -139,7 +156,7 @@ static void load_shaders() {
     "} fs_in;\n"
     "\n"
     "// Uniforms\n"
-    "uniform sampler2D u_textures[32];\n"
+    "layout (binding = 0) uniform sampler2D u_textures[32]; // Bound to units 0 through 31\n"
     "\n"
     "void main() {\n"
     "  int index = int(fs_in.tex_index);\n"
@@ -147,24 +164,95 @@ static void load_shaders() {
     "}";
 
   // Shader init
-  renderer.batch_shader = shader_load("batch.glsl", batch_code);
+  // NOTE: The samplers get their units from the shader itself, so nothing has to be 
+  // uploaded and the shader does not have to be waited on until the first batch.
+  renderer.batch_shader = shader_load_async("batch.glsl", batch_code);
 
   // Textures init
   u32 pixels = 0xffffffff;
   renderer.textures[0] = texture_load(1, 1, TEXTURE_FORMAT_RGBA, &pixels);
+}
+
+static void push_vertex(const Vertex2D& vertex) {
+  // Nothing is being recorded. Probably called outside of 'renderer2d_begin' and 'renderer2d_end'
+  if(!renderer.vertices) {
+    return;
+  }
+
+  renderer.vertices->push_back(vertex);
+}
+
+// Returns the index the texture has in the current batch, adding it if it is not there yet. 
+// A new batch is started first if there is no room for another quad with this texture.
+static f32 get_texture_index(Texture* texture, const f32 screen_size) {
+  if(renderer.indices_count >= MAX_INDICES) {
+    renderer2d_end();
+    renderer2d_begin();
+  }
+
+  bool found = false;
+  f32 index = 1.0f;
+  
+  // Check to find if the texture already exists in the array
+  for(i32 i = 1; i < renderer.texture_index; i++) {
+    if(texture->id == renderer.textures[i]->id) {
+      found = true; 
+      index = i;
+
+      break;
+    }
+  }
+
+  // Only add unique textures into the array
+  // If the texture is unique, add it to the array and 
+  // increament the amount of textures to render next flush
+  if(!found) {
+    if(renderer.texture_index >= MAX_TEXTURES) {
+      renderer2d_end();
+      renderer2d_begin();
+    }
+
+    renderer.textures[renderer.texture_index]      = texture;
+    renderer.texture_sizes[renderer.texture_index] = 0.0f;
+    index = renderer.texture_index++;
+  }
+
+  // How big the texture gets drawn. Parts of a texture count as the whole texture.
+  f32& size = renderer.texture_sizes[(usizei)index];
+  size      = glm::max(size, screen_size);
 
-  shader_bind(renderer.batch_shader);
-  i32 tex_slots[MAX_TEXTURES];
-  for(u32 i = 0; i < 32; i++)
-    tex_slots[i] = i;
-  shader_upload_int_arr(renderer.batch_shader, "u_textures", tex_slots, MAX_TEXTURES);
+  return index;
+}
+
+// The texture coordinates go top-left, top-right, bottom-right, then bottom-left
+static void push_textured_quad(const Rect& dest, const glm::vec2 uvs[4], const glm::vec4& tint, const f32 index) {
+  glm::mat4 model(1.0f);
+  model = glm::translate(model, glm::vec3(dest.x, dest.y, 0.0f));
+  model = glm::scale(model, glm::vec3(dest.width, dest.height, 0.0f));
+
+  for(u32 i = 0; i < 4; i++) {
+    Vertex2D vertex; 
+    vertex.position       = renderer.ortho * model * renderer.quad_vertices[i]; 
+    vertex.color          = tint;
+    vertex.texture_coords = uvs[i];
+    vertex.texture_index  = index;
+    push_vertex(vertex);
+  }
+
+  renderer.indices_count += 6;
 }
 /////////////////////////////////////////////////////////////////////////////////
 
 // Public functions
 /////////////////////////////////////////////////////////////////////////////////
 const bool renderer2d_create() {
-  setup_buffers();
+  render_thread_call([]() {
+    setup_buffers();
+  });
+
+  // Enough room for a full batch
+  renderer.frames[0].reserve(MAX_VERTICES);
+  renderer.frames[1].reserve(MAX_VERTICES);
 
   // Load the default batch shader
   load_shaders();
@@ -179,37 +267,97 @@ const bool renderer2d_create() {
 }
 
 void renderer2d_destroy() {
-  renderer.vertices.clear();
+  renderer.vertices = nullptr;
+
+  // The render thread might still be drawing the last frame
+  render_thread_push([]() {
+    gl_state_forget_vertex_array(renderer.vao);
+    gl_state_forget_buffer(renderer.ebo);
 
+    glDeleteVertexArrays(1, &renderer.vao);
+    glDeleteBuffers(1, &renderer.ebo);
+    gpu_memory_free(GPU_MEMORY_GEOMETRY, sizeof(u32) * MAX_INDICES);
+
+    renderer.frames[0].clear();
+    renderer.frames[1].clear();
+  });
   shader_unload(renderer.batch_shader);
 }
 
 void renderer2d_flush() {
-  // Render all of the unique textures
-  for(u32 i = 0; i < renderer.texture_index; i++)
-    texture_use(renderer.textures[i], i);
+  if(!renderer.vertices) {
+    return;
+  }
+
+  u32 frame_index       = renderer.frame_index;
+  usizei first          = renderer.batch_start;
+  usizei count          = renderer.vertices->size() - first;
+  usizei indices        = renderer.indices_count;
+  usizei textures_count = renderer.texture_index;
+
+  // The textures array gets reused by the next batch
+  std::array<Texture*, MAX_TEXTURES> textures;
+  std::array<f32, MAX_TEXTURES> texture_sizes;
+  memcpy(textures.data(), renderer.textures, sizeof(Texture*) * textures_count);
+  memcpy(texture_sizes.data(), renderer.texture_sizes, sizeof(f32) * textures_count);
+
+  render_thread_push([frame_index, first, count, indices, textures, texture_sizes, textures_count]() {
+    std::vector<Vertex2D>& vertices = renderer.frames[frame_index];
+
+    // The first texture is the blank one used by quads. It never streams.
+    for(u32 i = 1; i < textures_count; i++) {
+      texture_residency_touch(textures[i], texture_sizes[i]);
+    }
+
+    if(count > 0) {
+      // Copy the batch into the stream buffer and draw it with a base vertex that points to where it was written
+      usizei size = sizeof(Vertex2D) * count;
+      void* data  = stream_buffer_map(size, sizeof(Vertex2D));
+
+      if(data) {
+        gpu_timer_begin(GPU_TIMER_2D);
 
-  // Initiate draw call!
-  glBindVertexArray(renderer.vao); 
-  glDrawElements(GL_TRIANGLES, renderer.indices_count, GL_UNSIGNED_INT, 0);
+        memcpy(data, &vertices[first], size);
+        usizei offset = stream_buffer_unmap(size);
 
+        shader_bind(renderer.batch_shader);
+
+        // Render all of the unique textures
+        for(u32 i = 0; i < textures_count; i++)
+          texture_use(textures[i], i);
+
+        // Initiate draw call!
+        gl_state_bind_vertex_array(renderer.vao); 
+        glDrawElementsBaseVertex(GL_TRIANGLES, indices, GL_UNSIGNED_INT, 0, offset / sizeof(Vertex2D));
+
+        gpu_timer_end();
+        renderer_count_draws(1, indices / 3);
+      }
+    }
+
+    // That was the last batch of the frame. The memory gets recorded over again later.
+    if(first + count == vertices.size()) {
+      vertices.clear();
+    }
+  });
+
+  renderer.batch_start   = renderer.vertices->size();
   renderer.texture_index = 1;
   renderer.indices_count = 0;
 }
 
 void renderer2d_begin() {
-  shader_bind(renderer.batch_shader);
-  renderer.vertices.clear();
+  renderer.frame_index = render_thread_get_frame_index();
+  renderer.vertices    = &renderer.frames[renderer.frame_index];
+  renderer.batch_start = renderer.vertices->size();
 
   glm::vec2 window_size = window_get_size();
   renderer.ortho = glm::ortho(0.0f, window_size.x, window_size.y, 0.0f);
 }
 
 void renderer2d_end() {
-  glBindBuffer(GL_ARRAY_BUFFER, renderer.vbo);
-  glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Vertex2D) * renderer.vertices.size(), renderer.vertices.data());
-
   renderer2d_flush();
+  renderer.vertices = nullptr;
 }
 
 void renderer2d_set_default_font(Font* font) {
@@ -237,7 +385,7 @@ void render_quad(const glm::vec2& position, const glm::vec2& size, const glm::ve
   v1.color          = color;
   v1.texture_coords = glm::vec2(0.0f, 1.0f); 
   v1.texture_index  = 0.0f;
-  renderer.vertices.push_back(v1);
+  push_vertex(v1);
  
   // Top-right
   Vertex2D v2; 
@@ -245,7 +393,7 @@ void render_quad(const glm::vec2& position, const glm::vec2& size, const glm::ve
   v2.color          = color;
   v2.texture_coords = glm::vec2(1.0f, 1.0f); 
   v2.texture_index  = 0.0f;
-  renderer.vertices.push_back(v2);
+  push_vertex(v2);
  
   // Bottom-right
   Vertex2D v3; 
@@ -253,7 +401,7 @@ void render_quad(const glm::vec2& position, const glm::vec2& size, const glm::ve
   v3.color          = color;
   v3.texture_coords = glm::vec2(1.0f, 0.0f); 
   v3.texture_index  = 0.0f;
-  renderer.vertices.push_back(v3);
+  push_vertex(v3);
  
   // Bottom-left
   Vertex2D v4; 
@@ -261,82 +409,33 @@ void render_quad(const glm::vec2& position, const glm::vec2& size, const glm::ve
   v4.color          = color;
   v4.texture_coords = glm::vec2(0.0f, 0.0f); 
   v4.texture_index  = 0.0f;
-  renderer.vertices.push_back(v4);
+  push_vertex(v4);
 
   renderer.indices_count += 6;
 }
 
 void render_texture(Texture* texture, const Rect& src, const Rect& dest, const glm::vec4& tint, const bool flip) {
-  // Restart the renderer once the max quads is reached 
-  if(renderer.indices_count >= MAX_INDICES || renderer.texture_index >= MAX_TEXTURES) {
-    renderer2d_end();
-    renderer2d_begin();
-  }
+  f32 index = get_texture_index(texture, glm::max(dest.width, dest.height));
 
-  bool found = false;
-  f32 index = 1.0f;
-  
-  // Check to find if the texture already exists in the array
-  for(i32 i = 1; i < renderer.texture_index; i++) {
-    if(texture->id == renderer.textures[i]->id) {
-      found = true; 
-      index = i;
-
-      break;
-    }
-  }
-
-  // Only add unique textures into the array
-  // If the texture is unique, add it to the array and 
-  // increament the amount of textures to render next flush
-  if(!found) {
-    renderer.textures[renderer.texture_index] = texture;
-    index = renderer.texture_index++;
-  }
-
-  glm::mat4 model(1.0f);
-  model = glm::translate(model, glm::vec3(dest.x, dest.y, 0.0f));
-  model = glm::scale(model, glm::vec3(dest.width, dest.height, 0.0f));
+  glm::vec2 uvs[4];
 
   // Top-left 
-  Vertex2D v1; 
-  v1.position       = renderer.ortho * model * renderer.quad_vertices[0]; 
-  v1.color          = tint;
-  v1.texture_coords = flip ? glm::vec2(src.x / src.width, src.y / src.height) :
-                             glm::vec2(src.x / src.width, (src.y + src.height) / src.height);
-                              
-  v1.texture_index  = index;
-  renderer.vertices.push_back(v1);
+  uvs[0] = flip ? glm::vec2(src.x / src.width, src.y / src.height) :
+                  glm::vec2(src.x / src.width, (src.y + src.height) / src.height);
  
   // Top-right
-  Vertex2D v2; 
-  v2.position       = renderer.ortho * model * renderer.quad_vertices[1]; 
-  v2.color          = tint;
-  v2.texture_coords = flip ? glm::vec2((src.x + src.width) / src.width, src.y / src.height) :
-                             glm::vec2((src.x + src.width) / src.width, (src.y + src.height) / src.height);
-  v2.texture_index  = index;
-  renderer.vertices.push_back(v2);
+  uvs[1] = flip ? glm::vec2((src.x + src.width) / src.width, src.y / src.height) :
+                  glm::vec2((src.x + src.width) / src.width, (src.y + src.height) / src.height);
  
   // Bottom-right
-  Vertex2D v3; 
-  v3.position       = renderer.ortho * model * renderer.quad_vertices[2]; 
-  v3.color          = tint;
-  v3.texture_coords = flip ? glm::vec2((src.x + src.width) / src.width, (src.y + src.height) / src.height) :
-                             glm::vec2((src.x + src.width) / src.width, src.y / src.height); 
-  v3.texture_index  = index;
-  renderer.vertices.push_back(v3);
+  uvs[2] = flip ? glm::vec2((src.x + src.width) / src.width, (src.y + src.height) / src.height) :
+                  glm::vec2((src.x + src.width) / src.width, src.y / src.height); 
  
   // Bottom-left
-  Vertex2D v4; 
-  v4.position       = renderer.ortho * model * renderer.quad_vertices[3]; 
-  v4.color          = tint;
-  v4.texture_coords = flip ? glm::vec2(src.x / src.width, (src.y + src.height) / src.height) :
-                             glm::vec2(src.x / src.width, src.y / src.height); 
-  v4.texture_index  = index;
-  renderer.vertices.push_back(v4);
+  uvs[3] = flip ? glm::vec2(src.x / src.width, (src.y + src.height) / src.height) :
+                  glm::vec2(src.x / src.width, src.y / src.height); 
 
-  renderer.indices_count += 6;
- 
+  push_textured_quad(dest, uvs, tint, index);
 }
 
 void render_texture(Texture* texture, const glm::vec2& position, const glm::vec2& size, const glm::vec4& tint) {
@@ -346,11 +445,18 @@ void render_texture(Texture* texture, const glm::vec2& position, const glm::vec2
   render_texture(texture, src, dest, tint);
 }
 
-void render_text(const Font* font, const f32 size, const std::string& text, const glm::vec2& position, const glm::vec4& color) {
+void render_text(Font* font, const f32 size, const std::string& text, const glm::vec2& position, const glm::vec4& color) {
   if(!font) {
     return; 
   }  
 
+  // Every glyph is in the font's atlas, so the whole string goes into one batch. Unless 
+  // it does not fit in what is left of the current one, that is.
+  if(renderer.indices_count > 0 && renderer.indices_count + text.size() * 6 > MAX_INDICES) {
+    renderer2d_end();
+    renderer2d_begin();
+  }
+
   f32 off_x = 0.0f;
   f32 off_y = 0.0f;
   f32 scale = size / font->base_size;
@@ -358,7 +464,7 @@ void render_text(const Font* font, const f32 size, const std::string& text, cons
   for(u32 i = 0; i < text.size(); i++) {
     i8 ch = text[i]; 
     i32 index = font_get_glyph_index(font, ch);
-    Glyph glyph = font->glyphs[index];
+    const Glyph& glyph = font->glyphs[index];
 
     if(ch == '\n') {
       off_x = 0.0f;
@@ -369,12 +475,24 @@ void render_text(const Font* font, const f32 size, const std::string& text, cons
       off_x += glyph.advance_x + glyph.kern;
       continue;
     }
+
+    // Glyphs without any pixels still take up space
+    const GlyphRegion& region = font_get_glyph_region(font, index);
+    if(!region.texture) {
+      off_x += glyph.advance_x + glyph.kern;
+      continue;
+    }
    
     glm::vec2 offset((off_x + glyph.x_offset) * scale, (off_y + glyph.y_offset) * scale);
-    Rect src = {0.0f, 0.0f, -(glyph.width * font->glyph_padding), -(glyph.height * font->glyph_padding)};
     Rect dest = {position.x + offset.x, position.y, glyph.width * scale, glyph.height * scale};
 
-    render_texture(glyph.texture, src, dest, color, true);
+    glm::vec2 uvs[4] = {
+      region.uv_min, 
+      glm::vec2(region.uv_max.x, region.uv_min.y), 
+      region.uv_max, 
+      glm::vec2(region.uv_min.x, region.uv_max.y), 
+    };
+    push_textured_quad(dest, uvs, color, get_texture_index(region.texture, glm::max(dest.width, dest.height)));
 
     off_x += glyph.advance_x + glyph.kern;
   }
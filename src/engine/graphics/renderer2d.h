@@ -40,7 +40,7 @@ void render_texture(Texture* texture, const Rect& src, const Rect& dest, const g
 void render_texture(Texture* texture, const glm::vec2& position, const glm::vec2& size, const glm::vec4& tint = glm::vec4(1.0f));
 
 // Renders the text with the given font.
-void render_text(const Font* font, const f32 size, const std::string& text, const glm::vec2& position, const glm::vec4& color);
+void render_text(Font* font, const f32 size, const std::string& text, const glm::vec2& position, const glm::vec4& color);
 
 // Renders the text with the default font. 
 // NOTE: The default font MUST be set with the 'renderer2d_set_default_font' function at the 
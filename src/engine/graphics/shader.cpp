@@ -1,15 +1,33 @@
 #include "shader.h"
 #include "defines.h"
+#include "graphics/gl_ext.h"
+#include "graphics/gl_state.h"
+#include "graphics/shader_cache.h"
+#include "graphics/render_thread.h"
+#include "core/window.h"
 #include "utils/utils_file.h"
+#include "utils/utils_hash.h"
 
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <cstdio>
+#include <vector>
 
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/glm.hpp>
 #include <glad/gl.h>
 
+// ShaderCompiles
+/////////////////////////////////////////////////////////////////////////////////
+struct ShaderCompiles {
+  // Shaders the driver is still compiling on its own threads. Owned by the render thread.
+  std::vector<Shader*> pending;
+};
+
+static ShaderCompiles s_compiles;
+/////////////////////////////////////////////////////////////////////////////////
+
 // Private functions
 /////////////////////////////////////////////////////////////////////////////////
 static void read_shader(const std::string& shader_str, Shader* shader) {
@@ -43,70 +61,221 @@ static void check_compile_error(const u32 shader_id) {
   }
 }
 
-static void check_linker_error(const Shader* shader) {
+static bool check_linker_error(const Shader* shader) {
   int success;
   char log_info[512];
 
-  glGetProgramiv(shader->id, GL_COMPILE_STATUS, &success); 
+  glGetProgramiv(shader->id, GL_LINK_STATUS, &success); 
 
   if(!success) {
     glGetProgramInfoLog(shader->id, 512, nullptr, log_info);
     printf("[SHADER-ERROR]: %s\n", log_info);
   }
+
+  return success;
+}
+
+static void reflect_uniforms(Shader* shader) {
+  i32 count = 0;
+  glGetProgramiv(shader->id, GL_ACTIVE_UNIFORMS, &count);
+
+  for(i32 i = 0; i < count; i++) {
+    char name[256];
+    i32 length = 0, size = 0;
+    u32 type;
+    glGetActiveUniform(shader->id, i, sizeof(name), &length, &size, &type, name);
+
+    // Uniforms inside uniform blocks do not have a location
+    i32 location = glGetUniformLocation(shader->id, name);
+    if(location == -1) {
+      continue;
+    }
+    shader->uniforms[hash_fnv1a(name)] = location;
+
+    // Arrays are reported as "name[0]". Store the array itself and each of its elements.
+    if(length > 3 && strcmp(name + length - 3, "[0]") == 0) {
+      name[length - 3] = '\0';
+
+      u32 hash = hash_fnv1a(name);
+      shader->uniforms[hash] = location;
+
+      for(i32 j = 1; j < size; j++) {
+        char element[256 + 16];
+        snprintf(element, sizeof(element), "%s[%i]", name, j);
+
+        shader->uniforms[hash_fnv1a_index(hash, j)] = glGetUniformLocation(shader->id, element);
+      }
+    }
+  }
 }
 
-static unsigned int get_uniform_location(const Shader* shader, const std::string& name) {
-  u32 uni_loc = 0;
+// Check for errors, grab the uniforms, and store the program in the cache. 'finish_time' is when 
+// the compilation was done (or first noticed to be done), which is what the cache remembers.
+// NOTE: Must be called from the render thread
+static void finish_compile(Shader* shader, const f64 finish_time) {
+  // This is where the driver actually waits on the compilation, if it is still going
+  bool linked = check_linker_error(shader);
+  if(!linked) {
+    check_compile_error(shader->vert_id);
+    check_compile_error(shader->frag_id);
+  }
+  reflect_uniforms(shader);
+
+  // Detaching 
+  glDetachShader(shader->id, shader->vert_id);
+  glDetachShader(shader->id, shader->frag_id);
+  glDeleteShader(shader->vert_id);
+  glDeleteShader(shader->frag_id);
 
-  uni_loc = glGetUniformLocation(shader->id, name.c_str());
-  if(uni_loc == -1) {
-    printf("[SHADER-ERROR]: Could not find variable \'%s\' in shader \'%s\'\n", name.c_str(), shader->name.c_str());
+  if(linked) {
+    shader_cache_store(shader, finish_time - shader->compile_start);
   }
 
-  return uni_loc;
+  shader->is_ready = true;
+}
+
+static void remove_pending(Shader* shader) {
+  auto it = std::find(s_compiles.pending.begin(), s_compiles.pending.end(), shader);
+  if(it != s_compiles.pending.end()) {
+    s_compiles.pending.erase(it);
+  }
+}
+
+static i32 get_uniform_location(Shader* shader, const u32 hash, const char* name) {
+  // The uniforms are only known once the program is linked
+  shader_wait(shader);
+
+  auto it = shader->uniforms.find(hash);
+  if(it != shader->uniforms.end()) {
+    return it->second;
+  }
+
+  // Only complain once. Uploads to a location of -1 are silently ignored by OpenGL.
+  printf("[SHADER-ERROR]: Could not find variable \'%s\' in shader \'%s\'\n", name, shader->name.c_str());
+  shader->uniforms[hash] = -1;
+
+  return -1;
+}
+
+static i32 get_uniform_location(Shader* shader, const ShaderUniform& uniform) {
+  return get_uniform_location(shader, uniform.hash, uniform.name);
+}
+
+static i32 get_uniform_location(Shader* shader, const ShaderUniform& uniform, const u32 index) {
+  return get_uniform_location(shader, hash_fnv1a_index(uniform.hash, index), uniform.name);
 }
 /////////////////////////////////////////////////////////////////////////////////
 
 // Public functions
 /////////////////////////////////////////////////////////////////////////////////
-Shader* shader_load(const std::string& shader_name, const std::string& shader_code) {
+Shader* shader_load_async(const std::string& shader_name, const std::string& shader_code) {
   Shader* shader = new Shader{};
   shader->name = shader_name;
 
   // Read the whole shader code and turn it into two seperate strings for 
   // OpenGL to compile and link
   read_shader(shader_code, shader);
-  
-  // Vertex shader
-  const char* vert_src = shader->vert_src.c_str(); 
-  shader->vert_id = glCreateShader(GL_VERTEX_SHADER);
-  glShaderSource(shader->vert_id, 1, &vert_src, 0);
-  glCompileShader(shader->vert_id);
-  check_compile_error(shader->vert_id);
-  
-  // Fragment shader
-  const char* frag_src = shader->frag_src.c_str();
-  shader->frag_id = glCreateShader(GL_FRAGMENT_SHADER);
-  glShaderSource(shader->frag_id, 1, &frag_src, 0);
-  glCompileShader(shader->frag_id);
-  check_compile_error(shader->frag_id);
-
-  // Linking 
-  shader->id = glCreateProgram();
-  glAttachShader(shader->id, shader->vert_id);
-  glAttachShader(shader->id, shader->frag_id);
-  glLinkProgram(shader->id);
-  check_linker_error(shader);
 
-  // Detaching 
-  glDetachShader(shader->id, shader->vert_id);
-  glDetachShader(shader->id, shader->frag_id);
-  glDeleteShader(shader->vert_id);
-  glDeleteShader(shader->frag_id);
+  render_thread_call([shader]() {
+    // No need to compile anything if the program was cached from a previous run
+    if(shader_cache_load(shader)) {
+      reflect_uniforms(shader);
+      shader->is_ready = true;
+
+      return;
+    }
+
+    shader->compile_start = window_get_time();
+    
+    // Vertex shader
+    const char* vert_src = shader->vert_src.c_str(); 
+    shader->vert_id = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(shader->vert_id, 1, &vert_src, 0);
+    glCompileShader(shader->vert_id);
+    
+    // Fragment shader
+    const char* frag_src = shader->frag_src.c_str();
+    shader->frag_id = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(shader->frag_id, 1, &frag_src, 0);
+    glCompileShader(shader->frag_id);
+
+    // Linking 
+    shader->id = glCreateProgram();
+    glAttachShader(shader->id, shader->vert_id);
+    glAttachShader(shader->id, shader->frag_id);
+    shader_cache_prepare(shader);
+    glLinkProgram(shader->id);
+
+    // Without the extension, the driver does not compile in the background anyway. Finishing 
+    // right away is no slower, and the time that gets cached is just the compilation.
+    if(!gl_ext_supported(GLEXT_PARALLEL_SHADER_COMPILE)) {
+      finish_compile(shader, window_get_time());
+      return;
+    }
+
+    // NOTE: Nothing is checked here since any query would wait on the compilation. 
+    // 'shader_poll_compiles' finishes it once it is done, unless 'shader_wait' needs it first.
+    shader->is_ready = false;
+    s_compiles.pending.push_back(shader);
+  });
+
+  return shader;
+}
+
+Shader* shader_load(const std::string& shader_name, const std::string& shader_code) {
+  Shader* shader = shader_load_async(shader_name, shader_code);
+  shader_wait(shader);
 
   return shader;
 }
 
+void shader_wait(Shader* shader) {
+  if(shader->is_ready) {
+    return;
+  }
+
+  render_thread_call([shader]() {
+    // Another call might have gotten here first
+    if(shader->is_ready) {
+      return;
+    }
+
+    remove_pending(shader);
+    finish_compile(shader, window_get_time());
+  });
+}
+
+void shader_wait_compiles() {
+  render_thread_call([]() {
+    for(auto& shader : s_compiles.pending) {
+      finish_compile(shader, window_get_time());
+    }
+
+    s_compiles.pending.clear();
+  });
+}
+
+void shader_poll_compiles() {
+  f64 now = window_get_time();
+
+  for(auto it = s_compiles.pending.begin(); it != s_compiles.pending.end();) {
+    // Never blocks, unlike every other query on a program that is still compiling
+    i32 completed = 0;
+    glGetProgramiv((*it)->id, GL_COMPLETION_STATUS_KHR, &completed);
+    if(!completed) {
+      it++;
+      continue;
+    }
+
+    finish_compile(*it, now);
+    it = s_compiles.pending.erase(it);
+  }
+}
+
+const u32 shader_get_compiling_count() {
+  return s_compiles.pending.size();
+}
+
 Shader* shader_load(const std::string& path) {
   std::string contents; 
   file_read_string(path, &contents);
@@ -119,57 +288,65 @@ void shader_unload(Shader* shader) {
     return;
   }
 
-  glDeleteProgram(shader->id);
-  delete shader;
+  // Recorded draws might still use the program
+  render_thread_push([shader]() {
+    // Still compiling. Nothing should finish it anymore.
+    if(!shader->is_ready) {
+      remove_pending(shader);
+
+      glDeleteShader(shader->vert_id);
+      glDeleteShader(shader->frag_id);
+    }
+
+    gl_state_forget_program(shader->id);
+    glDeleteProgram(shader->id);
 
-  shader = nullptr;
+    delete shader;
+  });
 }
 
 void shader_bind(Shader* shader) {
-  glUseProgram(shader->id);
+  shader_wait(shader);
+  gl_state_use_program(shader->id);
 }
 
-void shader_upload_int(Shader* shader, const std::string& name, const i32 value) {
-  glUniform1i(get_uniform_location(shader, name), value);
+void shader_upload_int(Shader* shader, const ShaderUniform& uniform, const i32 value) {
+  glUniform1i(get_uniform_location(shader, uniform), value);
 }
 
-void shader_upload_int_index(Shader* shader, const std::string& name, const u32 index, const i32 value) {
-  std::string index_name = std::string(name + "[" + std::to_string(index) + "]");
-  glUniform1i(get_uniform_location(shader, index_name), value);
+void shader_upload_int_index(Shader* shader, const ShaderUniform& uniform, const u32 index, const i32 value) {
+  glUniform1i(get_uniform_location(shader, uniform, index), value);
 }
 
-void shader_upload_int_arr(Shader* shader, const std::string& name, const i32* values, const usizei size) {
-  glUniform1iv(get_uniform_location(shader, name), size, values); 
+void shader_upload_int_arr(Shader* shader, const ShaderUniform& uniform, const i32* values, const usizei size) {
+  glUniform1iv(get_uniform_location(shader, uniform), size, values); 
 }
 
-void shader_upload_float(Shader* shader, const std::string& name, const f32 value) {
-  glUniform1f(get_uniform_location(shader, name), value);
+void shader_upload_float(Shader* shader, const ShaderUniform& uniform, const f32 value) {
+  glUniform1f(get_uniform_location(shader, uniform), value);
 }
 
-void shader_upload_mat4(Shader* shader, const std::string& name, const glm::mat4& value) {
-  glUniformMatrix4fv(get_uniform_location(shader, name), 1, GL_FALSE, glm::value_ptr(value));
+void shader_upload_mat4(Shader* shader, const ShaderUniform& uniform, const glm::mat4& value) {
+  glUniformMatrix4fv(get_uniform_location(shader, uniform), 1, GL_FALSE, glm::value_ptr(value));
 }
 
-void shader_upload_vec4(Shader* shader, const std::string& name, const glm::vec4& value) {
-  glUniform4f(get_uniform_location(shader, name), value.x, value.y, value.z, value.w);
+void shader_upload_vec4(Shader* shader, const ShaderUniform& uniform, const glm::vec4& value) {
+  glUniform4f(get_uniform_location(shader, uniform), value.x, value.y, value.z, value.w);
 }
 
-void shader_upload_vec3(Shader* shader, const std::string& name, const glm::vec3& value) {
-  glUniform3f(get_uniform_location(shader, name), value.x, value.y, value.z);
+void shader_upload_vec3(Shader* shader, const ShaderUniform& uniform, const glm::vec3& value) {
+  glUniform3f(get_uniform_location(shader, uniform), value.x, value.y, value.z);
 }
 
-void shader_upload_mat4_index(Shader* shader, const std::string& name, const i32 index, const glm::mat4& value) {
-  std::string index_name = std::string(name + "[" + std::to_string(index) + "]");
-  glUniformMatrix4fv(get_uniform_location(shader, index_name), 1, GL_FALSE, glm::value_ptr(value));
+void shader_upload_mat4_index(Shader* shader, const ShaderUniform& uniform, const i32 index, const glm::mat4& value) {
+  glUniformMatrix4fv(get_uniform_location(shader, uniform, index), 1, GL_FALSE, glm::value_ptr(value));
 }
 
-void shader_upload_vec4_index(Shader* shader, const std::string& name, const i32 index, const glm::vec4& value) {
-  std::string index_name = std::string(name + "[" + std::to_string(index) + "]");
-  glUniform4f(get_uniform_location(shader, index_name), value.x, value.y, value.z, value.w);
+void shader_upload_vec4_index(Shader* shader, const ShaderUniform& uniform, const i32 index, const glm::vec4& value) {
+  glUniform4f(get_uniform_location(shader, uniform, index), value.x, value.y, value.z, value.w);
 }
 
-void shader_upload_vec3_index(Shader* shader, const std::string& name, const i32 index, const glm::vec3& value) {
-  std::string index_name = std::string(name + "[" + std::to_string(index) + "]");
-  glUniform3f(get_uniform_location(shader, index_name), value.x, value.y, value.z);
+void shader_upload_vec3_index(Shader* shader, const ShaderUniform& uniform, const i32 index, const glm::vec3& value) {
+  glUniform3f(get_uniform_location(shader, uniform, index), value.x, value.y, value.z);
 }
 /////////////////////////////////////////////////////////////////////////////////
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "defines.h"
+#include "utils/utils_hash.h"
 
 #include <string>
+#include <unordered_map>
+#include <atomic>
 
 #include <glm/glm.hpp>
 
@@ -13,27 +16,77 @@ struct Shader {
   std::string vert_src, frag_src; 
 
   u32 id, vert_id, frag_id;
+
+  // 'false' while the program might still be compiling. Set on the render thread.
+  std::atomic<bool> is_ready = false;
+  f64 compile_start;
+
+  // The location of every active uniform, keyed by the hash of its name.
+  // Filled once after linking. Array elements are stored as "name[index]".
+  std::unordered_map<u32, i32> uniforms;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// ShaderUniform
+/////////////////////////////////////////////////////////////////////////////////
+// The name of a uniform. String literals get converted (and hashed) at compile time,
+// so uploading a uniform never has to allocate or ask OpenGL for its location.
+struct ShaderUniform {
+  u32 hash;
+  const char* name; // Only used for error messages
+
+  constexpr ShaderUniform(const char* str) 
+    :hash(hash_fnv1a(str)), name(str) 
+  {}
+
+  ShaderUniform(const std::string& str) 
+    :hash(hash_fnv1a(str.c_str())), name(str.c_str()) 
+  {}
 };
 /////////////////////////////////////////////////////////////////////////////////
 
 // Public functions
 /////////////////////////////////////////////////////////////////////////////////
 Shader* shader_load(const std::string& shader_name, const std::string& shader_code);
+
+// Start compiling the shader without waiting for it to finish. If the driver supports
+// 'GL_KHR_parallel_shader_compile', the compilation happens on the driver's own threads.
+// NOTE: The shader can be used like any other. Binding it or uploading to it will
+// block until the compilation is done, but only if it is not done already.
+Shader* shader_load_async(const std::string& shader_name, const std::string& shader_code);
+
+// Block until the shader is done compiling
+void shader_wait(Shader* shader);
+
+// Block until every shader that is still compiling is done
+void shader_wait_compiles();
+
+// Finish the shaders the driver is done compiling, without ever blocking (through 'GL_COMPLETION_STATUS_KHR').
+// NOTE: Must be called from the render thread, once per frame.
+void shader_poll_compiles();
+
+// How many shaders are still compiling
+// NOTE: Must be called from the render thread.
+const u32 shader_get_compiling_count();
+
 Shader* shader_load(const std::string& path);
 void shader_unload(Shader* shader);
+
+// NOTE: Binding and uploading touch OpenGL directly, so they must run on the 
+// render thread (inside a recorded command).
 void shader_bind(Shader* shader); 
 
-void shader_upload_int(Shader* shader, const std::string& name, const i32 value);
-void shader_upload_int_index(Shader* shader, const std::string& name, const u32 index, const i32 value);
-void shader_upload_int_arr(Shader* shader, const std::string& name, const i32* values, const usizei size);
+void shader_upload_int(Shader* shader, const ShaderUniform& uniform, const i32 value);
+void shader_upload_int_index(Shader* shader, const ShaderUniform& uniform, const u32 index, const i32 value);
+void shader_upload_int_arr(Shader* shader, const ShaderUniform& uniform, const i32* values, const usizei size);
 
-void shader_upload_float(Shader* shader, const std::string& name, const f32 value);
+void shader_upload_float(Shader* shader, const ShaderUniform& uniform, const f32 value);
 
-void shader_upload_mat4(Shader* shader, const std::string& name, const glm::mat4& value);
-void shader_upload_vec4(Shader* shader, const std::string& name, const glm::vec4& value);
-void shader_upload_vec3(Shader* shader, const std::string& name, const glm::vec3& value);
+void shader_upload_mat4(Shader* shader, const ShaderUniform& uniform, const glm::mat4& value);
+void shader_upload_vec4(Shader* shader, const ShaderUniform& uniform, const glm::vec4& value);
+void shader_upload_vec3(Shader* shader, const ShaderUniform& uniform, const glm::vec3& value);
 
-void shader_upload_mat4_index(Shader* shader, const std::string& name, const i32 index, const glm::mat4& value);
-void shader_upload_vec4_index(Shader* shader, const std::string& name, const i32 index, const glm::vec4& value);
-void shader_upload_vec3_index(Shader* shader, const std::string& name, const i32 index, const glm::vec3& value);
+void shader_upload_mat4_index(Shader* shader, const ShaderUniform& uniform, const i32 index, const glm::mat4& value);
+void shader_upload_vec4_index(Shader* shader, const ShaderUniform& uniform, const i32 index, const glm::vec4& value);
+void shader_upload_vec3_index(Shader* shader, const ShaderUniform& uniform, const i32 index, const glm::vec3& value);
 /////////////////////////////////////////////////////////////////////////////////
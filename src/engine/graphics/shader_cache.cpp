@@ -0,0 +1,189 @@
+#include "shader_cache.h"
+#include "defines.h"
+#include "core/window.h"
+#include "graphics/gl_ext.h"
+#include "graphics/shader.h"
+#include "utils/utils_file.h"
+#include "utils/utils_hash.h"
+
+#include <glad/gl.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+#define SHADER_CACHE_MAGIC 0x48435350 // "PSCH"
+/////////////////////////////////////////////////////////////////////////////////
+
+// ShaderCacheHeader
+/////////////////////////////////////////////////////////////////////////////////
+struct ShaderCacheHeader {
+  u32 magic;
+  u32 source_hash;
+  u32 driver_hash;
+
+  u32 format;
+  u32 size;
+  f32 compile_time;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// ShaderCache
+/////////////////////////////////////////////////////////////////////////////////
+struct ShaderCache {
+  bool has_driver_hash = false;
+  u32 driver_hash;
+
+  ShaderCacheStats stats;
+};
+
+static ShaderCache s_cache;
+/////////////////////////////////////////////////////////////////////////////////
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static u32 get_driver_hash() {
+  if(s_cache.has_driver_hash) {
+    return s_cache.driver_hash;
+  }
+
+  const char* vendor   = (const char*)glGetString(GL_VENDOR);
+  const char* renderer = (const char*)glGetString(GL_RENDERER);
+  const char* version  = (const char*)glGetString(GL_VERSION);
+
+  u32 hash = hash_fnv1a(vendor ? vendor : "");
+  hash     = hash_fnv1a(renderer ? renderer : "", hash);
+  hash     = hash_fnv1a(version ? version : "", hash);
+
+  s_cache.driver_hash     = hash;
+  s_cache.has_driver_hash = true;
+
+  return hash;
+}
+
+static u32 get_source_hash(const Shader* shader) {
+  return hash_fnv1a(shader->frag_src.c_str(), hash_fnv1a(shader->vert_src.c_str()));
+}
+
+static std::string get_cache_path(const u32 source_hash) {
+  char name[16];
+  snprintf(name, sizeof(name), "%08x.bin", source_hash);
+
+  return std::string(SHADER_CACHE_DIR) + name;
+}
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+const bool shader_cache_load(Shader* shader) {
+  if(!gl_ext_supported(GLEXT_PROGRAM_BINARY)) {
+    return false;
+  }
+
+  f64 start = window_get_time();
+
+  u32 source_hash = get_source_hash(shader);
+  std::ifstream file(get_cache_path(source_hash), std::ios::binary);
+  if(!file.is_open()) {
+    s_cache.stats.misses++;
+    return false;
+  }
+
+  // Make sure the binary is for these sources and this driver
+  ShaderCacheHeader header;
+  usizei file_size = file_get_size(file);
+  if(file_size < sizeof(ShaderCacheHeader) || !file_read_binary(file, &header, sizeof(ShaderCacheHeader))) {
+    s_cache.stats.misses++;
+    return false;
+  }
+
+  bool is_valid = header.magic == SHADER_CACHE_MAGIC &&
+                  header.source_hash == source_hash &&
+                  header.driver_hash == get_driver_hash() &&
+                  header.size == file_size - sizeof(ShaderCacheHeader);
+  if(!is_valid) {
+    s_cache.stats.misses++;
+    return false;
+  }
+
+  std::vector<u8> binary(header.size);
+  file_read_binary(file, binary.data(), header.size);
+  file.close();
+
+  shader->id = glCreateProgram();
+  glProgramBinary(shader->id, header.format, binary.data(), header.size);
+
+  // The driver can still reject the binary (after an update, for example)
+  i32 success = 0;
+  glGetProgramiv(shader->id, GL_LINK_STATUS, &success);
+  if(!success) {
+    glDeleteProgram(shader->id);
+    shader->id = 0;
+
+    s_cache.stats.misses++;
+    return false;
+  }
+
+  f64 load_time = window_get_time() - start;
+
+  s_cache.stats.hits++;
+  s_cache.stats.load_time  += load_time;
+  s_cache.stats.saved_time += header.compile_time - load_time;
+
+  return true;
+}
+
+void shader_cache_prepare(const Shader* shader) {
+  if(!gl_ext_supported(GLEXT_PROGRAM_BINARY)) {
+    return;
+  }
+
+  glProgramParameteri(shader->id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void shader_cache_store(const Shader* shader, const f64 compile_time) {
+  s_cache.stats.compile_time += compile_time;
+
+  if(!gl_ext_supported(GLEXT_PROGRAM_BINARY)) {
+    return;
+  }
+
+  i32 length = 0;
+  glGetProgramiv(shader->id, GL_PROGRAM_BINARY_LENGTH, &length);
+  if(length <= 0) {
+    return;
+  }
+
+  ShaderCacheHeader header;
+  header.magic        = SHADER_CACHE_MAGIC;
+  header.source_hash  = get_source_hash(shader);
+  header.driver_hash  = get_driver_hash();
+  header.compile_time = (f32)compile_time;
+
+  std::vector<u8> binary(length);
+  glGetProgramBinary(shader->id, length, &length, &header.format, binary.data());
+  header.size = length;
+
+  std::error_code err;
+  std::filesystem::create_directories(SHADER_CACHE_DIR, err);
+
+  std::string path = get_cache_path(header.source_hash);
+  std::ofstream file(path, std::ios::binary);
+  if(!file.is_open()) {
+    fprintf(stderr, "[WARNING]: Could not write the shader cache at \'%s\'\n", path.c_str());
+    return;
+  }
+
+  file_write_binary(file, &header, sizeof(ShaderCacheHeader));
+  file_write_binary(file, binary.data(), header.size);
+  file.close();
+}
+
+const ShaderCacheStats shader_cache_get_stats() {
+  return s_cache.stats;
+}
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "defines.h"
+#include "graphics/shader.h"
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+#define SHADER_CACHE_DIR "cache/shaders/"
+/////////////////////////////////////////////////////////////////////////////////
+
+// ShaderCacheStats
+/////////////////////////////////////////////////////////////////////////////////
+struct ShaderCacheStats {
+  u32 hits, misses;
+
+  f64 load_time;    // Seconds spent creating programs out of cached binaries
+  f64 compile_time; // Seconds spent compiling the programs that were not cached
+  f64 saved_time;   // How much longer the cached programs would have taken to compile
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// Linked programs are saved in 'SHADER_CACHE_DIR' with 'glGetProgramBinary', keyed by
+// the hash of their sources. Each binary also remembers the driver (vendor, renderer and
+// version) it came from, since a binary is only valid for the driver that created it.
+// NOTE: Does nothing if the driver does not support program binaries.
+
+// Tries to create 'shader->id' out of a cached binary of the shader's sources.
+// Returns 'false' if there was no valid binary, in which case the shader should be
+// compiled as usual and given to 'shader_cache_store'.
+const bool shader_cache_load(Shader* shader);
+
+// Must be called before linking a program that should be stored later
+void shader_cache_prepare(const Shader* shader);
+
+// Save the binary of the linked 'shader->id', which took 'compile_time' seconds to compile
+void shader_cache_store(const Shader* shader, const f64 compile_time);
+
+const ShaderCacheStats shader_cache_get_stats();
+/////////////////////////////////////////////////////////////////////////////////
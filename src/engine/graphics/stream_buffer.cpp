@@ -0,0 +1,231 @@
+#include "stream_buffer.h"
+#include "defines.h"
+#include "core/window.h"
+#include "graphics/gl_ext.h"
+#include "graphics/gl_state.h"
+#include "graphics/gpu_memory.h"
+
+#include <glad/gl.h>
+
+#include <cstdio>
+
+// StreamBuffer
+/////////////////////////////////////////////////////////////////////////////////
+struct StreamBuffer {
+  u32 id = 0;
+  u8* persistent_data = nullptr; // Only valid if the buffer is persistently mapped
+  bool is_persistent = false;
+
+  GLsync fences[STREAM_BUFFER_REGIONS];
+  u32 region    = 0;
+  usizei offset = 0; // The write head (in bytes) from the start of the buffer
+
+  // The currently active mapping
+  bool is_mapped = false;
+  usizei map_offset, map_size;
+
+  StreamBufferStats frame_stats, last_stats;
+};
+
+static StreamBuffer s_stream;
+/////////////////////////////////////////////////////////////////////////////////
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static usizei region_start(const u32 region) {
+  return (usizei)region * STREAM_BUFFER_REGION_SIZE;
+}
+
+static usizei align_offset(const usizei offset, const usizei alignment) {
+  if(alignment <= 1) {
+    return offset;
+  }
+
+  return ((offset + alignment - 1) / alignment) * alignment;
+}
+
+static void wait_region(const u32 region) {
+  GLsync fence = s_stream.fences[region];
+  if(!fence) {
+    return;
+  }
+
+  f64 start = window_get_time();
+
+  // Wait in 1ms steps until the GPU is done with the region
+  while(true) {
+    GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    if(result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+      break;
+    }
+    else if(result == GL_WAIT_FAILED) {
+      fprintf(stderr, "[STREAM-ERROR]: Failed to wait on the fence of region %i\n", region);
+      break;
+    }
+  }
+
+  s_stream.frame_stats.fence_wait_time += window_get_time() - start;
+
+  glDeleteSync(fence);
+  s_stream.fences[region] = nullptr;
+}
+
+static void advance_region() {
+  // Everything issued up until now reads from the current region. Fence it off
+  // so it does not get overwritten until the GPU is done with it.
+  s_stream.fences[s_stream.region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  s_stream.region = (s_stream.region + 1) % STREAM_BUFFER_REGIONS;
+  s_stream.offset = region_start(s_stream.region);
+}
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+const bool stream_buffer_init() {
+  usizei total_size = (usizei)STREAM_BUFFER_REGION_SIZE * STREAM_BUFFER_REGIONS;
+
+  glGenBuffers(1, &s_stream.id);
+  gl_state_bind_buffer(GL_COPY_WRITE_BUFFER, s_stream.id);
+
+  // Persistently map the whole buffer once if we can. Otherwise, each region
+  // will be mapped unsynchronized when needed.
+  s_stream.is_persistent = gl_ext_supported(GLEXT_BUFFER_STORAGE);
+  if(s_stream.is_persistent) {
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glBufferStorage(GL_COPY_WRITE_BUFFER, total_size, nullptr, flags);
+    s_stream.persistent_data = (u8*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total_size, flags);
+
+    if(!s_stream.persistent_data) {
+      fprintf(stderr, "[STREAM-ERROR]: Failed to persistently map the stream buffer\n");
+      return false;
+    }
+  }
+  else {
+    glBufferData(GL_COPY_WRITE_BUFFER, total_size, nullptr, GL_STREAM_DRAW);
+  }
+
+  gl_state_bind_buffer(GL_COPY_WRITE_BUFFER, 0);
+  gpu_memory_alloc(GPU_MEMORY_STREAMING, total_size);
+
+  for(u32 i = 0; i < STREAM_BUFFER_REGIONS; i++) {
+    s_stream.fences[i] = nullptr;
+  }
+
+  s_stream.region      = 0;
+  s_stream.offset      = 0;
+  s_stream.is_mapped   = false;
+  s_stream.frame_stats = StreamBufferStats{};
+  s_stream.last_stats  = StreamBufferStats{};
+
+  return true;
+}
+
+void stream_buffer_shutdown() {
+  for(u32 i = 0; i < STREAM_BUFFER_REGIONS; i++) {
+    if(s_stream.fences[i]) {
+      glDeleteSync(s_stream.fences[i]);
+      s_stream.fences[i] = nullptr;
+    }
+  }
+
+  if(s_stream.is_persistent) {
+    gl_state_bind_buffer(GL_COPY_WRITE_BUFFER, s_stream.id);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    gl_state_bind_buffer(GL_COPY_WRITE_BUFFER, 0);
+
+    s_stream.persistent_data = nullptr;
+  }
+
+  gl_state_forget_buffer(s_stream.id);
+  glDeleteBuffers(1, &s_stream.id);
+
+  gpu_memory_free(GPU_MEMORY_STREAMING, (usizei)STREAM_BUFFER_REGION_SIZE * STREAM_BUFFER_REGIONS);
+}
+
+void* stream_buffer_map(const usizei size, const usizei alignment) {
+  if(s_stream.is_mapped) {
+    fprintf(stderr, "[STREAM-ERROR]: Cannot map the stream buffer while it is already mapped\n");
+    return nullptr;
+  }
+
+  if(size > STREAM_BUFFER_REGION_SIZE) {
+    fprintf(stderr, "[STREAM-ERROR]: Cannot map %zu bytes. Max is %i bytes\n", size, STREAM_BUFFER_REGION_SIZE);
+    return nullptr;
+  }
+
+  // Not enough space left in this region. Move on to the next one.
+  usizei offset = align_offset(s_stream.offset, alignment);
+  if((offset + size) > region_start(s_stream.region) + STREAM_BUFFER_REGION_SIZE) {
+    advance_region();
+    offset = align_offset(s_stream.offset, alignment);
+
+    // The start of a region is not always aligned. Writing past its end would land in 
+    // the next region, which the GPU might still be reading from.
+    if((offset + size) > region_start(s_stream.region) + STREAM_BUFFER_REGION_SIZE) {
+      fprintf(stderr, "[STREAM-ERROR]: Cannot map %zu bytes with an alignment of %zu. It does not fit in a region\n", size, alignment);
+      return nullptr;
+    }
+  }
+
+  // Make sure the GPU is not reading from the region anymore
+  wait_region(s_stream.region);
+
+  s_stream.is_mapped  = true;
+  s_stream.map_offset = offset;
+  s_stream.map_size   = size;
+
+  if(s_stream.is_persistent) {
+    return s_stream.persistent_data + offset;
+  }
+
+  // The fences already guarantee the range is not in use. No need for the driver to sync.
+  GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+
+  gl_state_bind_buffer(GL_COPY_WRITE_BUFFER, s_stream.id);
+  void* data = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size, flags);
+  gl_state_bind_buffer(GL_COPY_WRITE_BUFFER, 0);
+
+  return data;
+}
+
+const usizei stream_buffer_unmap(const usizei used_size) {
+  if(!s_stream.is_mapped) {
+    fprintf(stderr, "[STREAM-ERROR]: Cannot unmap the stream buffer since it was never mapped\n");
+    return 0;
+  }
+
+  if(!s_stream.is_persistent) {
+    gl_state_bind_buffer(GL_COPY_WRITE_BUFFER, s_stream.id);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    gl_state_bind_buffer(GL_COPY_WRITE_BUFFER, 0);
+  }
+
+  usizei used = used_size < s_stream.map_size ? used_size : s_stream.map_size;
+
+  s_stream.is_mapped = false;
+  s_stream.offset    = s_stream.map_offset + used;
+  s_stream.frame_stats.bytes_streamed += used;
+
+  return s_stream.map_offset;
+}
+
+void stream_buffer_end_frame() {
+  // Only fence the region if anything was written into it
+  if(s_stream.offset != region_start(s_stream.region)) {
+    advance_region();
+  }
+
+  s_stream.last_stats  = s_stream.frame_stats;
+  s_stream.frame_stats = StreamBufferStats{};
+}
+
+const u32 stream_buffer_get_id() {
+  return s_stream.id;
+}
+
+const StreamBufferStats stream_buffer_get_stats() {
+  return s_stream.last_stats;
+}
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "defines.h"
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+// The stream buffer is split into this many regions. Each region is guarded by a fence,
+// so the CPU can write into one region while the GPU is still reading the others.
+#define STREAM_BUFFER_REGIONS     3
+#define STREAM_BUFFER_REGION_SIZE (4 * 1024 * 1024)
+/////////////////////////////////////////////////////////////////////////////////
+
+// StreamBufferStats
+/////////////////////////////////////////////////////////////////////////////////
+struct StreamBufferStats {
+  usizei bytes_streamed; // How many bytes were written into the buffer last frame
+  f64 fence_wait_time;   // How long (in seconds) the CPU waited on the GPU last frame
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// A single ring buffer shared by every renderer for per-frame (streamed) data like
+// batched vertices and instances. If the driver supports it, the buffer is persistently
+// and coherently mapped, so writes go straight into GPU-visible memory without any
+// extra copy or implicit synchronization.
+// NOTE: Must be initialized after the OpenGL context and 'gl_ext_init'.
+const bool stream_buffer_init();
+void stream_buffer_shutdown();
+
+// Returns a pointer the caller can write up to 'size' bytes into. 'alignment' is the
+// alignment (in bytes) of the returned offset and does not have to be a power of two.
+// Returns a 'nullptr' if 'size' plus up to 'alignment - 1' bytes of padding does not fit in a region.
+// NOTE: Every 'stream_buffer_map' call must be followed by a 'stream_buffer_unmap' call
+// before issuing any draw calls that use the data, and only one mapping can be active at a time.
+void* stream_buffer_map(const usizei size, const usizei alignment);
+
+// Finishes the current mapping, keeping only the first 'used_size' bytes that were written.
+// Returns the offset (in bytes) of the written data in the buffer.
+const usizei stream_buffer_unmap(const usizei used_size);
+
+// Fences off everything that was written this frame.
+// NOTE: Should be called once per frame, right before swapping the buffers.
+void stream_buffer_end_frame();
+
+// The OpenGL ID of the buffer. Bind this as a vertex buffer when drawing streamed data.
+const u32 stream_buffer_get_id();
+
+// The stats of the last finished frame
+const StreamBufferStats stream_buffer_get_stats();
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,229 @@
+#include "texture_residency.h"
+#include "defines.h"
+#include "resources/texture.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+// Textures that were not drawn for this many frames drop down to their smallest mip
+#define IDLE_FRAMES 120
+
+// Textures never drop below this size (in pixels), so there is always something to sample
+#define MIN_SIZE 64
+
+// A texture that is still on screen only drops mips once it needs this many fewer, 
+// so it does not stream back and forth around a switching distance
+#define DROP_HYSTERESIS 2
+/////////////////////////////////////////////////////////////////////////////////
+
+// ResidentTexture
+/////////////////////////////////////////////////////////////////////////////////
+struct ResidentTexture {
+  Texture* texture;
+
+  u64 last_used   = 0;    // The frame the texture was last drawn in
+  f32 screen_size = 0.0f; // The biggest it was on screen in the last frame it was drawn in
+  u32 wanted_mip  = 0;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// TextureResidency
+/////////////////////////////////////////////////////////////////////////////////
+struct TextureResidency {
+  std::unordered_map<Texture*, ResidentTexture> textures;
+
+  usizei vram_budget = TEXTURE_RESIDENCY_VRAM_BUDGET;
+  usizei ram_budget  = TEXTURE_RESIDENCY_RAM_BUDGET;
+
+  u64 frame = 0;
+
+  // Kept around between updates so the memory gets reused
+  std::vector<ResidentTexture*> sorted;
+
+  TextureResidencyStats stats;
+};
+
+static TextureResidency s_residency;
+/////////////////////////////////////////////////////////////////////////////////
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static usizei get_mip_size(const Texture* texture, const u32 mip) {
+  return texture_get_mip_size(texture, mip);
+}
+
+// How big the pixels of the whole image are on the CPU while it gets decoded
+static usizei get_decode_size(const Texture* texture) {
+  // Cooked textures are uploaded straight from the mapped file
+  if(texture->cooked) {
+    return 0;
+  }
+
+  return (usizei)texture->full_width * texture->full_height * glm::max(texture->channels, 1);
+}
+
+static u32 get_max_mip(const Texture* texture) {
+  u32 mip  = 0;
+  i32 size = glm::max(texture->full_width, texture->full_height);
+
+  while((size >> (mip + 1)) >= MIN_SIZE) {
+    mip++;
+  }
+
+  return mip;
+}
+
+static u32 get_wanted_mip(const ResidentTexture& res) {
+  const Texture* texture = res.texture;
+  u32 max_mip = get_max_mip(texture);
+
+  // Textures that miss a few frames (like when they are culled for a moment) keep the size they were last drawn at
+  if(s_residency.frame - res.last_used > IDLE_FRAMES || res.screen_size <= 0.0f) {
+    return max_mip;
+  }
+
+  // Every mip past the first one that still has a texel per pixel on screen is wasted
+  f32 size = (f32)glm::max(texture->full_width, texture->full_height);
+  u32 mip  = 0;
+  while(mip < max_mip && size / (f32)(1 << (mip + 1)) >= res.screen_size) {
+    mip++;
+  }
+
+  // Getting sharper is always worth it, but getting blurrier is only worth it if it saves a good amount
+  if(mip > texture->resident_mip && mip < texture->resident_mip + DROP_HYSTERESIS) {
+    return texture->resident_mip;
+  }
+
+  return mip;
+}
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+void texture_residency_set_budget(const usizei vram_budget, const usizei ram_budget) {
+  s_residency.vram_budget = vram_budget;
+  s_residency.ram_budget  = ram_budget;
+}
+
+void texture_residency_add(Texture* texture) {
+  ResidentTexture res;
+  res.texture   = texture;
+  res.last_used = s_residency.frame;
+
+  s_residency.textures[texture] = res;
+}
+
+void texture_residency_remove(Texture* texture) {
+  s_residency.textures.erase(texture);
+}
+
+void texture_residency_touch(Texture* texture, const f32 screen_size) {
+  auto it = s_residency.textures.find(texture);
+  if(it == s_residency.textures.end()) {
+    return;
+  }
+
+  // The first touch of a frame replaces whatever size was kept from the last frame the texture was drawn in
+  ResidentTexture& res = it->second;
+  if(res.last_used != s_residency.frame) {
+    res.screen_size = 0.0f;
+  }
+
+  res.last_used   = s_residency.frame;
+  res.screen_size = glm::max(res.screen_size, screen_size);
+}
+
+void texture_residency_update() {
+  TextureResidencyStats stats = {};
+
+  s_residency.sorted.clear();
+
+  usizei vram_size = 0; // What every texture would take with the mips it wants
+  usizei ram_size  = 0; // The decoded pixels that are on their way right now
+
+  for(auto& [texture, res] : s_residency.textures) {
+    // Not decoded yet. There is nothing to go by.
+    if(texture->full_width == 0) {
+      continue;
+    }
+
+    res.wanted_mip = get_wanted_mip(res);
+
+    vram_size += get_mip_size(texture, res.wanted_mip);
+
+    if(texture->requested_mip != texture->resident_mip) {
+      ram_size += get_decode_size(texture);
+      stats.streaming_count++;
+    }
+
+    stats.textures_count++;
+    stats.resident_size += get_mip_size(texture, texture->resident_mip);
+    stats.full_size     += get_mip_size(texture, 0);
+
+    s_residency.sorted.push_back(&res);
+  }
+
+  // Least recently used first
+  std::sort(s_residency.sorted.begin(), s_residency.sorted.end(), [](const ResidentTexture* a, const ResidentTexture* b) {
+    return a->last_used < b->last_used;
+  });
+
+  // Over the budget. Keep dropping a mip from each texture, least recently used first, until it fits.
+  bool dropped = true;
+  while(vram_size > s_residency.vram_budget && dropped) {
+    dropped = false;
+
+    for(auto& res : s_residency.sorted) {
+      if(res->wanted_mip >= get_max_mip(res->texture)) {
+        continue;
+      }
+
+      vram_size -= get_mip_size(res->texture, res->wanted_mip);
+      res->wanted_mip++;
+      vram_size += get_mip_size(res->texture, res->wanted_mip);
+      dropped = true;
+
+      if(vram_size <= s_residency.vram_budget) {
+        break;
+      }
+    }
+  }
+
+  // Request the mips that changed, most recently used first. At least one request 
+  // is always let through, so a texture bigger than the RAM budget still gets there. 
+  for(auto it = s_residency.sorted.rbegin(); it != s_residency.sorted.rend(); it++) {
+    Texture* texture = (*it)->texture;
+    if((*it)->wanted_mip == texture->resident_mip) {
+      continue;
+    }
+
+    usizei decode_size = get_decode_size(texture);
+    if(stats.streaming_count > 0 && ram_size + decode_size > s_residency.ram_budget) {
+      break;
+    }
+
+    if(texture_stream(texture, (*it)->wanted_mip)) {
+      ram_size += decode_size;
+      stats.streaming_count++;
+    }
+  }
+
+  s_residency.stats = stats;
+  s_residency.frame++;
+}
+
+const TextureResidencyStats texture_residency_get_stats() {
+  return s_residency.stats;
+}
+
+void texture_residency_shutdown() {
+  s_residency.textures.clear();
+  s_residency.sorted.clear();
+  s_residency.stats = TextureResidencyStats{};
+}
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "defines.h"
+
+struct Texture;
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+#define TEXTURE_RESIDENCY_VRAM_BUDGET (256 * 1024 * 1024)
+#define TEXTURE_RESIDENCY_RAM_BUDGET  (64 * 1024 * 1024)
+/////////////////////////////////////////////////////////////////////////////////
+
+// TextureResidencyStats
+/////////////////////////////////////////////////////////////////////////////////
+struct TextureResidencyStats {
+  u32 textures_count;  // Every texture that can be streamed
+  u32 streaming_count; // Textures with a mip on its way right now
+
+  usizei resident_size; // Bytes the streamed textures take on the GPU right now
+  usizei full_size;     // Bytes they would take with every mip resident
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// Decides how much of each texture (that was loaded from a path) should be on the GPU. 
+// Every frame, textures stream in the mip that fits how big they were on screen, and 
+// textures that were not seen for a while drop down to their smallest mips. If that is 
+// still over the VRAM budget, mips get dropped from the least recently used textures first.
+// New mips are only requested while the decoded pixels on their way fit into the RAM budget.
+// Textures that keep their pixels on the CPU are never streamed, since their size has to match them.
+//
+// NOTE: Everything here has to be called on the render thread.
+
+// Both budgets are in bytes
+void texture_residency_set_budget(const usizei vram_budget, const usizei ram_budget);
+
+// NOTE: Called by the texture itself when it gets loaded and unloaded
+void texture_residency_add(Texture* texture);
+void texture_residency_remove(Texture* texture);
+
+// The texture was drawn at (about) 'screen_size' pixels across this frame.
+// NOTE: Textures that are not streamed are ignored.
+void texture_residency_touch(Texture* texture, const f32 screen_size);
+
+// Decide what each texture needs, and request the mips that changed.
+// NOTE: Should be called once per frame, before the uploads get flushed.
+void texture_residency_update();
+
+// The stats of the last update
+const TextureResidencyStats texture_residency_get_stats();
+
+// Free everything. Textures that are still loaded keep whatever they have on the GPU.
+void texture_residency_shutdown();
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,152 @@
+#include "texture_units.h"
+#include "defines.h"
+#include "graphics/gl_state.h"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <cstdio>
+
+// TextureUnit
+/////////////////////////////////////////////////////////////////////////////////
+struct TextureUnit {
+  u32 target, texture;
+  u64 last_used; // 0 if the unit was never handed out
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// TextureUnits
+/////////////////////////////////////////////////////////////////////////////////
+struct TextureUnits {
+  TextureUnit units[GL_STATE_MAX_TEXTURE_UNITS];
+  u32 units_count = 0;
+
+  u32 samplers[SAMPLERS_MAX];
+
+  u64 clock = 0;
+
+  TextureUnitsStats stats, last_stats;
+};
+
+static TextureUnits s_units;
+/////////////////////////////////////////////////////////////////////////////////
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static u32 create_sampler(const i32 min_filter, const i32 wrap) {
+  u32 sampler = 0;
+  glGenSamplers(1, &sampler);
+
+  glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, min_filter);
+  glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, wrap);
+  glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, wrap);
+  glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, wrap);
+
+  return sampler;
+}
+
+static i32 find_unit(const u32 target, const u32 texture) {
+  for(u32 i = 0; i < s_units.units_count; i++) {
+    const TextureUnit& unit = s_units.units[i];
+    if(unit.last_used == 0 || unit.target != target || unit.texture != texture) {
+      continue;
+    }
+
+    // Something else might have been bound to the unit directly since
+    if(gl_state_get_texture(i, target) != texture) {
+      return -1;
+    }
+
+    return i;
+  }
+
+  return -1;
+}
+
+static u32 least_recently_used() {
+  u32 lru = 0;
+  for(u32 i = 1; i < s_units.units_count; i++) {
+    if(s_units.units[i].last_used < s_units.units[lru].last_used) {
+      lru = i;
+    }
+  }
+
+  return lru;
+}
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+const bool texture_units_init() {
+  s_units = TextureUnits{};
+
+  i32 max_units = 0;
+  glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &max_units);
+  if(max_units <= 0) {
+    fprintf(stderr, "[ERROR]: Failed to query the number of texture units\n");
+    return false;
+  }
+
+  // Units past what the state cache tracks would always get rebound anyway
+  s_units.units_count = std::min<u32>(max_units, GL_STATE_MAX_TEXTURE_UNITS);
+
+  s_units.samplers[SAMPLER_LINEAR_MIPMAP_REPEAT] = create_sampler(GL_LINEAR_MIPMAP_LINEAR, GL_REPEAT);
+  s_units.samplers[SAMPLER_LINEAR_CLAMP]         = create_sampler(GL_LINEAR, GL_CLAMP_TO_EDGE);
+
+  return true;
+}
+
+void texture_units_shutdown() {
+  for(u32 i = 0; i < SAMPLERS_MAX; i++) {
+    gl_state_forget_sampler(s_units.samplers[i]);
+    glDeleteSamplers(1, &s_units.samplers[i]);
+  }
+
+  s_units = TextureUnits{};
+}
+
+const u32 texture_units_bind(const u32 target, const u32 texture, const SamplerType sampler) {
+  u32 gl_sampler = s_units.samplers[sampler];
+  s_units.clock++;
+
+  i32 found = find_unit(target, texture);
+  if(found >= 0) {
+    s_units.units[found].last_used = s_units.clock;
+
+    // The same texture can be sampled differently between draws
+    gl_state_bind_sampler(found, gl_sampler);
+
+    s_units.stats.hits++;
+    return found;
+  }
+
+  u32 index = least_recently_used();
+  if(s_units.units[index].last_used != 0) {
+    s_units.stats.evictions++;
+  }
+
+  TextureUnit& unit = s_units.units[index];
+  unit.target    = target;
+  unit.texture   = texture;
+  unit.last_used = s_units.clock;
+
+  gl_state_bind_texture(index, target, texture);
+  gl_state_bind_sampler(index, gl_sampler);
+
+  return index;
+}
+
+const u32 texture_units_get_sampler(const SamplerType sampler) {
+  return s_units.samplers[sampler];
+}
+
+void texture_units_end_frame() {
+  s_units.last_stats = s_units.stats;
+  s_units.stats      = TextureUnitsStats{};
+}
+
+const TextureUnitsStats texture_units_get_stats() {
+  return s_units.last_stats;
+}
+/////////////////////////////////////////////////////////////////////////////////
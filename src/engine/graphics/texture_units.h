@@ -0,0 +1,46 @@
+#pragma once
+
+#include "defines.h"
+
+// SamplerType
+/////////////////////////////////////////////////////////////////////////////////
+// Every texture is sampled with one of these, instead of keeping its own filtering and wrapping state
+enum SamplerType {
+  SAMPLER_LINEAR_MIPMAP_REPEAT = 0, // Loaded textures
+  SAMPLER_LINEAR_CLAMP,             // Raw pixels, cubemaps, and render targets
+
+  SAMPLERS_MAX,
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// TextureUnitsStats
+/////////////////////////////////////////////////////////////////////////////////
+struct TextureUnitsStats {
+  u32 hits;      // Binds where the texture was still on a unit last frame
+  u32 evictions; // Binds that had to take over the least recently used unit last frame
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// Hands out texture units on demand. A texture that is still bound to a unit
+// keeps it, and a texture that is not takes over the unit that was used the
+// longest time ago. 
+// NOTE: Everything here has to be called on the render thread.
+const bool texture_units_init();
+void texture_units_shutdown();
+
+// Make sure the texture is bound to some unit, with the given sampler, and return that unit.
+// NOTE: Units that get bound directly (through 'gl_state_bind_texture') are simply
+// taken over, so the returned unit is only valid until the next draw.
+const u32 texture_units_bind(const u32 target, const u32 texture, const SamplerType sampler);
+
+// The shared sampler object of the given type. Useful when binding to a fixed unit.
+const u32 texture_units_get_sampler(const SamplerType sampler);
+
+// Should be called once per frame, right before swapping the buffers.
+void texture_units_end_frame();
+
+// The stats of the last finished frame
+const TextureUnitsStats texture_units_get_stats();
+/////////////////////////////////////////////////////////////////////////////////
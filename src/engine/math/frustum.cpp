@@ -0,0 +1,147 @@
+#include "frustum.h"
+#include "defines.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static glm::vec4 normalize_plane(const glm::vec4& plane) {
+  f32 length = glm::length(glm::vec3(plane));
+  return length > 0.0f ? plane / length : plane;
+}
+
+static bool is_box_visible(const Frustum& frustum, const AABBBatch& batch, const usizei i) {
+  for(u32 p = 0; p < FRUSTUM_PLANES_MAX; p++) {
+    const glm::vec4& plane = frustum.planes[p];
+
+    // The distance of the box's center from the plane, and how far the box reaches towards it
+    f32 dist   = plane.x * batch.center_x[i] + plane.y * batch.center_y[i] + plane.z * batch.center_z[i] + plane.w;
+    f32 radius = glm::abs(plane.x) * batch.extent_x[i] + glm::abs(plane.y) * batch.extent_y[i] + glm::abs(plane.z) * batch.extent_z[i];
+
+    if(dist + radius < 0.0f) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+#ifdef FRUSTUM_USE_SSE
+// Returns a 4-bit mask of which of the 4 boxes starting at 'i' are visible
+static i32 are_boxes_visible_sse(const Frustum& frustum, const AABBBatch& batch, const usizei i) {
+  __m128 cx = _mm_loadu_ps(&batch.center_x[i]);
+  __m128 cy = _mm_loadu_ps(&batch.center_y[i]);
+  __m128 cz = _mm_loadu_ps(&batch.center_z[i]);
+  __m128 ex = _mm_loadu_ps(&batch.extent_x[i]);
+  __m128 ey = _mm_loadu_ps(&batch.extent_y[i]);
+  __m128 ez = _mm_loadu_ps(&batch.extent_z[i]);
+
+  __m128 zero    = _mm_setzero_ps();
+  __m128 outside = zero;
+
+  for(u32 p = 0; p < FRUSTUM_PLANES_MAX; p++) {
+    const glm::vec4& plane = frustum.planes[p];
+
+    __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)),
+                                        _mm_mul_ps(cy, _mm_set1_ps(plane.y))),
+                             _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)),
+                                        _mm_set1_ps(plane.w)));
+    __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(glm::abs(plane.x))),
+                                          _mm_mul_ps(ey, _mm_set1_ps(glm::abs(plane.y)))),
+                               _mm_mul_ps(ez, _mm_set1_ps(glm::abs(plane.z))));
+
+    outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, radius), zero));
+  }
+
+  return ~_mm_movemask_ps(outside) & 0xf;
+}
+#endif
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+Frustum frustum_create(const glm::mat4& view_projection) {
+  // The rows of the matrix (GLM is column-major)
+  glm::vec4 row0 = glm::vec4(view_projection[0][0], view_projection[1][0], view_projection[2][0], view_projection[3][0]);
+  glm::vec4 row1 = glm::vec4(view_projection[0][1], view_projection[1][1], view_projection[2][1], view_projection[3][1]);
+  glm::vec4 row2 = glm::vec4(view_projection[0][2], view_projection[1][2], view_projection[2][2], view_projection[3][2]);
+  glm::vec4 row3 = glm::vec4(view_projection[0][3], view_projection[1][3], view_projection[2][3], view_projection[3][3]);
+
+  Frustum frustum;
+  frustum.planes[FRUSTUM_LEFT]   = normalize_plane(row3 + row0);
+  frustum.planes[FRUSTUM_RIGHT]  = normalize_plane(row3 - row0);
+  frustum.planes[FRUSTUM_BOTTOM] = normalize_plane(row3 + row1);
+  frustum.planes[FRUSTUM_TOP]    = normalize_plane(row3 - row1);
+  frustum.planes[FRUSTUM_NEAR]   = normalize_plane(row3 + row2);
+  frustum.planes[FRUSTUM_FAR]    = normalize_plane(row3 - row2);
+
+  return frustum;
+}
+
+void aabb_batch_push(AABBBatch* batch,
+                     const glm::vec3& min,
+                     const glm::vec3& max,
+                     const glm::vec3& position,
+                     const glm::quat& rotation,
+                     const glm::vec3& scale) {
+  // A zeroed quaternion is treated as "no rotation" by the transforms
+  glm::quat rot = glm::length(rotation) > 0.0f ? glm::normalize(rotation) : glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+  glm::mat3 rot_mat = glm::mat3_cast(rot);
+
+  glm::vec3 local_center = ((min + max) * 0.5f) * scale;
+  glm::vec3 local_extent = ((max - min) * 0.5f) * glm::abs(scale);
+
+  // The extents of the rotated box along each world axis
+  glm::mat3 abs_rot = glm::mat3(glm::abs(rot_mat[0]), glm::abs(rot_mat[1]), glm::abs(rot_mat[2]));
+
+  glm::vec3 center = position + rot_mat * local_center;
+  glm::vec3 extent = abs_rot * local_extent;
+
+  batch->center_x.push_back(center.x);
+  batch->center_y.push_back(center.y);
+  batch->center_z.push_back(center.z);
+  batch->extent_x.push_back(extent.x);
+  batch->extent_y.push_back(extent.y);
+  batch->extent_z.push_back(extent.z);
+}
+
+void aabb_batch_clear(AABBBatch* batch) {
+  batch->center_x.clear();
+  batch->center_y.clear();
+  batch->center_z.clear();
+  batch->extent_x.clear();
+  batch->extent_y.clear();
+  batch->extent_z.clear();
+}
+
+const u32 frustum_cull(const Frustum& frustum, const AABBBatch& batch, u8* out_visible) {
+  usizei count = batch.center_x.size();
+  usizei i     = 0;
+  u32 visible  = 0;
+
+#ifdef FRUSTUM_USE_SSE
+  for(; i + 4 <= count; i += 4) {
+    i32 mask = are_boxes_visible_sse(frustum, batch, i);
+
+    for(u32 j = 0; j < 4; j++) {
+      out_visible[i + j] = (mask >> j) & 1;
+      visible += out_visible[i + j];
+    }
+  }
+#endif
+
+  // Whatever is left over (or everything if SSE is not available)
+  for(; i < count; i++) {
+    out_visible[i] = is_box_visible(frustum, batch, i) ? 1 : 0;
+    visible += out_visible[i];
+  }
+
+  return visible;
+}
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "defines.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+
+// FrustumPlane
+/////////////////////////////////////////////////////////////////////////////////
+enum FrustumPlane {
+  FRUSTUM_LEFT,
+  FRUSTUM_RIGHT,
+  FRUSTUM_BOTTOM,
+  FRUSTUM_TOP,
+  FRUSTUM_NEAR,
+  FRUSTUM_FAR,
+  FRUSTUM_PLANES_MAX = 6,
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// Frustum
+/////////////////////////////////////////////////////////////////////////////////
+// Each plane is stored as (normal, distance), with the normal pointing inside the frustum
+struct Frustum {
+  glm::vec4 planes[FRUSTUM_PLANES_MAX];
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// AABBBatch
+/////////////////////////////////////////////////////////////////////////////////
+// World-space boxes stored as (center, half extents) in separate arrays,
+// so they can be tested against the frustum 4 at a time.
+struct AABBBatch {
+  std::vector<f32> center_x, center_y, center_z;
+  std::vector<f32> extent_x, extent_y, extent_z;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// Extract the planes out of a view projection matrix
+Frustum frustum_create(const glm::mat4& view_projection);
+
+// Transform the local 'min' and 'max' of a mesh into a world-space box and add it to the batch
+void aabb_batch_push(AABBBatch* batch,
+                     const glm::vec3& min,
+                     const glm::vec3& max,
+                     const glm::vec3& position,
+                     const glm::quat& rotation,
+                     const glm::vec3& scale);
+void aabb_batch_clear(AABBBatch* batch);
+
+// Test every box in the batch against the frustum. 'out_visible' will have a 1 for each
+// box that is at least partially inside the frustum and a 0 otherwise.
+// Returns the number of visible boxes.
+// NOTE: 'out_visible' must have room for as many boxes as there are in the batch.
+const u32 frustum_cull(const Frustum& frustum, const AABBBatch& batch, u8* out_visible);
+/////////////////////////////////////////////////////////////////////////////////
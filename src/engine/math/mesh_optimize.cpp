@@ -0,0 +1,290 @@
+#include "mesh_optimize.h"
+#include "defines.h"
+#include "math/vertex.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+// The size of the post-transform cache to optimize for. Most GPUs have (at least) this much.
+#define CACHE_SIZE 16
+/////////////////////////////////////////////////////////////////////////////////
+
+// ClusterSort
+/////////////////////////////////////////////////////////////////////////////////
+struct ClusterSort {
+  u32 first, count; // In triangles
+  f32 key;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+// The next vertex that still has triangles left, from the ones that were just emitted (most
+// recent first), or the first one in the mesh. Returns -1 once every triangle is emitted.
+static i64 skip_dead_end(const std::vector<u32>& live, std::vector<u32>* dead_end, u32* cursor) {
+  while(!dead_end->empty()) {
+    u32 vertex = dead_end->back();
+    dead_end->pop_back();
+
+    if(live[vertex] > 0) {
+      return vertex;
+    }
+  }
+
+  for(; *cursor < live.size(); (*cursor)++) {
+    if(live[*cursor] > 0) {
+      return *cursor;
+    }
+  }
+
+  return -1;
+}
+
+// Pick the candidate that has been in the cache the longest, but will still be in it
+// once all of its triangles are emitted. Returns -1 if there is no such vertex.
+static i64 next_fan_vertex(const std::vector<u32>& live, const std::vector<u32>& candidates, const std::vector<u32>& cache_time, const u32 time) {
+  i64 best          = -1;
+  i64 best_priority = 0;
+
+  for(auto& vertex : candidates) {
+    if(live[vertex] == 0) {
+      continue;
+    }
+
+    i64 priority = 0;
+    if(time - cache_time[vertex] + 2 * live[vertex] <= CACHE_SIZE) {
+      priority = time - cache_time[vertex];
+    }
+
+    if(priority > best_priority) {
+      best          = vertex;
+      best_priority = priority;
+    }
+  }
+
+  return best;
+}
+
+// Run the triangles in [first, last) through a simulated FIFO cache, returning how many vertices missed it
+static u32 simulate_cache(const std::vector<u32>& indices, const u32 first, const u32 last, std::vector<u32>& cache_time, u32* time) {
+  u32 misses = 0;
+
+  for(u32 i = first * 3; i < last * 3; i++) {
+    u32 vertex = indices[i];
+    if(*time - cache_time[vertex] > CACHE_SIZE) {
+      cache_time[vertex] = (*time)++;
+      misses++;
+    }
+  }
+
+  return misses;
+}
+
+// Split the clusters up wherever the triangles before the split already use the cache about as well as the whole cluster
+static void split_clusters(const std::vector<u32>& indices, const std::vector<u32>& clusters, const u32 vertices_count, const f32 threshold, std::vector<u32>* out_clusters) {
+  u32 triangles_count = indices.size() / 3;
+
+  std::vector<u32> cache_time(vertices_count, 0);
+  u32 time = CACHE_SIZE + 1;
+
+  for(u32 i = 0; i < clusters.size(); i++) {
+    u32 start = clusters[i];
+    u32 end   = i + 1 < clusters.size() ? clusters[i + 1] : triangles_count;
+
+    f32 cluster_acmr = (f32)simulate_cache(indices, start, end, cache_time, &time) / (end - start);
+    time += CACHE_SIZE + 1; // Flush the cache
+
+    out_clusters->push_back(start);
+
+    u32 misses = 0;
+    u32 split  = start;
+    for(u32 tri = start; tri < end - 1; tri++) {
+      misses += simulate_cache(indices, tri, tri + 1, cache_time, &time);
+
+      if((f32)misses / (tri + 1 - split) <= cluster_acmr * threshold) {
+        out_clusters->push_back(tri + 1);
+
+        split  = tri + 1;
+        misses = 0;
+        time  += CACHE_SIZE + 1;
+      }
+    }
+
+    time += CACHE_SIZE + 1;
+  }
+}
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+void optimize_vertex_cache(std::vector<u32>* indices, const u32 vertices_count, std::vector<u32>* out_clusters) {
+  const std::vector<u32>& in = *indices;
+  u32 triangles_count = in.size() / 3;
+
+  out_clusters->clear();
+  if(triangles_count == 0) {
+    return;
+  }
+
+  // How many triangles each vertex still has left to emit
+  std::vector<u32> live(vertices_count, 0);
+  for(auto& index : in) {
+    live[index]++;
+  }
+
+  // Which triangles use each vertex
+  std::vector<u32> adjacency_offsets(vertices_count + 1, 0);
+  for(u32 i = 0; i < vertices_count; i++) {
+    adjacency_offsets[i + 1] = adjacency_offsets[i] + live[i];
+  }
+
+  std::vector<u32> adjacency(in.size());
+  std::vector<u32> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+  for(u32 i = 0; i < in.size(); i++) {
+    adjacency[fill[in[i]]++] = i / 3;
+  }
+
+  std::vector<u32> cache_time(vertices_count, 0);
+  std::vector<u8> emitted(triangles_count, 0);
+  std::vector<u32> dead_end, candidates;
+  dead_end.reserve(in.size());
+
+  std::vector<u32> result;
+  result.reserve(in.size());
+
+  u32 time   = CACHE_SIZE + 1;
+  u32 cursor = 0;
+
+  // Every time the fanning has to jump somewhere that is not in the cache, a new cluster starts
+  i64 fan = skip_dead_end(live, &dead_end, &cursor);
+  while(fan >= 0) {
+    out_clusters->push_back(result.size() / 3);
+
+    while(fan >= 0) {
+      candidates.clear();
+
+      // Emit every triangle around the fanning vertex
+      for(u32 i = adjacency_offsets[fan]; i < adjacency_offsets[fan + 1]; i++) {
+        u32 tri = adjacency[i];
+        if(emitted[tri]) {
+          continue;
+        }
+
+        for(u32 j = 0; j < 3; j++) {
+          u32 vertex = in[tri * 3 + j];
+
+          result.push_back(vertex);
+          dead_end.push_back(vertex);
+          candidates.push_back(vertex);
+          live[vertex]--;
+
+          if(time - cache_time[vertex] > CACHE_SIZE) {
+            cache_time[vertex] = time++;
+          }
+        }
+
+        emitted[tri] = 1;
+      }
+
+      fan = next_fan_vertex(live, candidates, cache_time, time);
+    }
+
+    fan = skip_dead_end(live, &dead_end, &cursor);
+  }
+
+  *indices = result;
+}
+
+void optimize_overdraw(const std::vector<Vertex3D>& vertices,
+                       std::vector<u32>* indices,
+                       const std::vector<u32>& clusters,
+                       const f32 threshold) {
+  const std::vector<u32>& in = *indices;
+  u32 triangles_count = in.size() / 3;
+  if(clusters.empty()) {
+    return;
+  }
+
+  std::vector<u32> split;
+  split_clusters(in, clusters, vertices.size(), threshold, &split);
+
+  // The area-weighted center of the whole mesh
+  glm::vec3 mesh_center(0.0f);
+  f32 mesh_area = 0.0f;
+  for(u32 i = 0; i < in.size(); i += 3) {
+    glm::vec3 p0 = vertices[in[i + 0]].position;
+    glm::vec3 p1 = vertices[in[i + 1]].position;
+    glm::vec3 p2 = vertices[in[i + 2]].position;
+
+    f32 area     = glm::length(glm::cross(p1 - p0, p2 - p0));
+    mesh_center += (p0 + p1 + p2) * (area / 3.0f);
+    mesh_area   += area;
+  }
+  mesh_center = mesh_area > 0.0f ? mesh_center / mesh_area : glm::vec3(0.0f);
+
+  // Clusters that face away from the center sit on the outside of the mesh, and should be drawn first
+  std::vector<ClusterSort> sorted(split.size());
+  for(u32 i = 0; i < split.size(); i++) {
+    ClusterSort& cluster = sorted[i];
+    cluster.first = split[i];
+    cluster.count = (i + 1 < split.size() ? split[i + 1] : triangles_count) - cluster.first;
+
+    glm::vec3 center(0.0f), normal(0.0f);
+    f32 area = 0.0f;
+    for(u32 tri = cluster.first; tri < cluster.first + cluster.count; tri++) {
+      glm::vec3 p0 = vertices[in[tri * 3 + 0]].position;
+      glm::vec3 p1 = vertices[in[tri * 3 + 1]].position;
+      glm::vec3 p2 = vertices[in[tri * 3 + 2]].position;
+
+      glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+      f32 tri_area    = glm::length(cross);
+
+      center += (p0 + p1 + p2) * (tri_area / 3.0f);
+      normal += cross;
+      area   += tri_area;
+    }
+
+    f32 normal_length = glm::length(normal);
+    if(area <= 0.0f || normal_length <= 0.0f) {
+      cluster.key = 0.0f;
+      continue;
+    }
+
+    cluster.key = glm::dot(center / area - mesh_center, normal / normal_length);
+  }
+
+  std::stable_sort(sorted.begin(), sorted.end(), [](const ClusterSort& a, const ClusterSort& b) {
+    return a.key > b.key;
+  });
+
+  std::vector<u32> result;
+  result.reserve(in.size());
+  for(auto& cluster : sorted) {
+    result.insert(result.end(), in.begin() + cluster.first * 3, in.begin() + (cluster.first + cluster.count) * 3);
+  }
+
+  *indices = result;
+}
+
+void optimize_vertex_fetch(std::vector<Vertex3D>* vertices, std::vector<u32>* indices) {
+  std::vector<u32> remap(vertices->size(), UINT32_MAX);
+  std::vector<Vertex3D> result;
+  result.reserve(vertices->size());
+
+  for(auto& index : *indices) {
+    if(remap[index] == UINT32_MAX) {
+      remap[index] = result.size();
+      result.push_back((*vertices)[index]);
+    }
+
+    index = remap[index];
+  }
+
+  *vertices = result;
+}
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "defines.h"
+#include "math/vertex.h"
+
+#include <vector>
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// Reorder the triangles in 'indices' so the vertices they share get reused while they are still
+// in the GPU's post-transform cache (using Tipsify). Returns where each run of triangles that were
+// fanned around together starts (in triangles) in 'out_clusters', which 'optimize_overdraw' needs.
+void optimize_vertex_cache(std::vector<u32>* indices, const u32 vertices_count, std::vector<u32>* out_clusters);
+
+// Reorder the clusters found by 'optimize_vertex_cache' so the ones that face outwards get drawn
+// first, and hide as much of the rest of the mesh as possible. Clusters are split up further as long
+// as that does not make the cache hit rate worse than 'threshold' times what it was (1.05 is a
+// good start).
+void optimize_overdraw(const std::vector<Vertex3D>& vertices,
+                       std::vector<u32>* indices,
+                       const std::vector<u32>& clusters,
+                       const f32 threshold);
+
+// Reorder the vertices in the order the triangles first use them, so the vertex fetches
+// are as close together in memory as possible. The indices are remapped to match.
+// NOTE: Vertices that are not used by any triangle are dropped.
+void optimize_vertex_fetch(std::vector<Vertex3D>* vertices, std::vector<u32>* indices);
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,339 @@
+#include "simplify.h"
+#include "defines.h"
+#include "math/vertex.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <vector>
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+// How much more the edges on the border of the mesh resist being collapsed
+#define BORDER_WEIGHT 10.0f
+/////////////////////////////////////////////////////////////////////////////////
+
+// Quadric
+/////////////////////////////////////////////////////////////////////////////////
+// A symmetric 4x4 matrix that sums up the squared distance to a set of planes,
+// along with the total weight of the planes
+struct Quadric {
+  f64 a2, b2, c2, d2;
+  f64 ab, ac, ad;
+  f64 bc, bd;
+  f64 cd;
+
+  f64 weight;
+};
+
+struct Collapse {
+  u32 from, to; // Position IDs
+  f32 cost;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static Quadric quadric_from_plane(const glm::vec3& normal, const f32 distance, const f32 weight) {
+  f64 a = normal.x, b = normal.y, c = normal.z, d = distance;
+
+  Quadric q;
+  q.a2 = a * a * weight; q.b2 = b * b * weight; q.c2 = c * c * weight; q.d2 = d * d * weight;
+  q.ab = a * b * weight; q.ac = a * c * weight; q.ad = a * d * weight;
+  q.bc = b * c * weight; q.bd = b * d * weight;
+  q.cd = c * d * weight;
+  q.weight = weight;
+
+  return q;
+}
+
+static void quadric_add(Quadric* q, const Quadric& other) {
+  q->a2 += other.a2; q->b2 += other.b2; q->c2 += other.c2; q->d2 += other.d2;
+  q->ab += other.ab; q->ac += other.ac; q->ad += other.ad;
+  q->bc += other.bc; q->bd += other.bd;
+  q->cd += other.cd;
+  q->weight += other.weight;
+}
+
+// The average squared distance from 'p' to the planes of the quadric
+static f32 quadric_error(const Quadric& q, const glm::vec3& p) {
+  f64 x = p.x, y = p.y, z = p.z;
+
+  f64 error = q.a2 * x * x + q.b2 * y * y + q.c2 * z * z + q.d2 +
+              2.0 * (q.ab * x * y + q.ac * x * z + q.ad * x + q.bc * y * z + q.bd * y + q.cd * z);
+
+  if(q.weight <= 0.0) {
+    return 0.0f;
+  }
+
+  return (f32)glm::max(error / q.weight, 0.0);
+}
+
+// Give every vertex the ID of the first vertex at the exact same position
+static void weld_positions(const std::vector<Vertex3D>& vertices, std::vector<u32>& remap) {
+  std::vector<u32> order(vertices.size());
+  for(u32 i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+
+  auto less = [&vertices](const u32 a, const u32 b) {
+    const glm::vec3& pa = vertices[a].position;
+    const glm::vec3& pb = vertices[b].position;
+
+    if(pa.x != pb.x) return pa.x < pb.x;
+    if(pa.y != pb.y) return pa.y < pb.y;
+    if(pa.z != pb.z) return pa.z < pb.z;
+    return a < b;
+  };
+  std::sort(order.begin(), order.end(), less);
+
+  remap.resize(vertices.size());
+  for(u32 i = 0; i < order.size(); i++) {
+    bool same = i > 0 && vertices[order[i]].position == vertices[order[i - 1]].position;
+    remap[order[i]] = same ? remap[order[i - 1]] : order[i];
+  }
+}
+
+static void build_quadrics(const std::vector<Vertex3D>& vertices, const std::vector<u32>& indices, const std::vector<u32>& remap, std::vector<Quadric>& quadrics) {
+  quadrics.assign(vertices.size(), Quadric{});
+
+  // Count how many triangles share each edge. Edges with only one triangle are on the border.
+  std::vector<u64> edges;
+  edges.reserve(indices.size());
+  for(u32 i = 0; i < indices.size(); i += 3) {
+    for(u32 j = 0; j < 3; j++) {
+      u32 a = remap[indices[i + j]];
+      u32 b = remap[indices[i + (j + 1) % 3]];
+      edges.push_back(((u64)glm::min(a, b) << 32) | glm::max(a, b));
+    }
+  }
+  std::sort(edges.begin(), edges.end());
+
+  for(u32 i = 0; i < indices.size(); i += 3) {
+    u32 ids[3] = {remap[indices[i]], remap[indices[i + 1]], remap[indices[i + 2]]};
+
+    glm::vec3 p0 = vertices[ids[0]].position;
+    glm::vec3 p1 = vertices[ids[1]].position;
+    glm::vec3 p2 = vertices[ids[2]].position;
+
+    glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+    f32 length       = glm::length(normal);
+    if(length <= 0.0f) {
+      continue;
+    }
+    normal /= length;
+
+    // Bigger triangles matter more
+    Quadric plane = quadric_from_plane(normal, -glm::dot(normal, p0), length * 0.5f);
+    for(u32 j = 0; j < 3; j++) {
+      quadric_add(&quadrics[ids[j]], plane);
+    }
+
+    // Keep the border in place with a plane that is perpendicular to the triangle
+    for(u32 j = 0; j < 3; j++) {
+      u32 a = ids[j];
+      u32 b = ids[(j + 1) % 3];
+
+      u64 edge   = ((u64)glm::min(a, b) << 32) | glm::max(a, b);
+      auto range = std::equal_range(edges.begin(), edges.end(), edge);
+      if(range.second - range.first != 1) {
+        continue;
+      }
+
+      glm::vec3 edge_dir = vertices[b].position - vertices[a].position;
+      f32 edge_length    = glm::length(edge_dir);
+      if(edge_length <= 0.0f) {
+        continue;
+      }
+
+      glm::vec3 border_normal = glm::normalize(glm::cross(edge_dir, normal));
+      Quadric border = quadric_from_plane(border_normal, -glm::dot(border_normal, vertices[a].position), edge_length * edge_length * BORDER_WEIGHT);
+
+      quadric_add(&quadrics[a], border);
+      quadric_add(&quadrics[b], border);
+    }
+  }
+}
+
+// Returns 'true' if moving 'from' to the position of 'to' would turn any of its triangles around
+static bool collapse_flips(const std::vector<Vertex3D>& vertices,
+                           const std::vector<u32>& indices,
+                           const std::vector<u32>& remap,
+                           const u32* triangles,
+                           const u32 triangles_count,
+                           const u32 from,
+                           const u32 to) {
+  glm::vec3 new_pos = vertices[to].position;
+
+  for(u32 i = 0; i < triangles_count; i++) {
+    u32 ids[3] = {remap[indices[triangles[i] * 3 + 0]], remap[indices[triangles[i] * 3 + 1]], remap[indices[triangles[i] * 3 + 2]]};
+
+    // These triangles disappear with the collapse
+    if(ids[0] == to || ids[1] == to || ids[2] == to) {
+      continue;
+    }
+
+    glm::vec3 p[3], moved[3];
+    for(u32 j = 0; j < 3; j++) {
+      p[j]     = vertices[ids[j]].position;
+      moved[j] = ids[j] == from ? new_pos : p[j];
+    }
+
+    glm::vec3 old_normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+    glm::vec3 new_normal = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+    if(glm::dot(old_normal, new_normal) <= 0.0f) {
+      return true;
+    }
+  }
+
+  return false;
+}
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+const f32 simplify_mesh(const std::vector<Vertex3D>& vertices,
+                        const std::vector<u32>& indices,
+                        const u32 target_count,
+                        std::vector<u32>* out_indices) {
+  std::vector<u32>& result = *out_indices;
+  result = indices;
+
+  std::vector<u32> remap;
+  weld_positions(vertices, remap);
+
+  std::vector<Quadric> quadrics;
+  build_quadrics(vertices, indices, remap, quadrics);
+
+  std::vector<u32> adjacency_offsets, adjacency;
+  std::vector<Collapse> collapses;
+  std::vector<u32> wedges(vertices.size());
+  std::vector<u8> locked(vertices.size());
+
+  f32 max_error = 0.0f;
+
+  // Collapse as many edges as possible in each pass, then clean up and try again
+  while(result.size() > target_count) {
+    u32 triangles_count = result.size() / 3;
+
+    // Which triangles use each position
+    adjacency_offsets.assign(vertices.size() + 1, 0);
+    for(u32 i = 0; i < result.size(); i++) {
+      adjacency_offsets[remap[result[i]] + 1]++;
+    }
+    for(u32 i = 0; i < vertices.size(); i++) {
+      adjacency_offsets[i + 1] += adjacency_offsets[i];
+    }
+
+    adjacency.resize(result.size());
+    std::vector<u32> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+    for(u32 i = 0; i < result.size(); i++) {
+      adjacency[fill[remap[result[i]]]++] = i / 3;
+    }
+
+    // Every edge can be collapsed both ways
+    collapses.clear();
+    for(u32 i = 0; i < result.size(); i += 3) {
+      for(u32 j = 0; j < 3; j++) {
+        u32 a = remap[result[i + j]];
+        u32 b = remap[result[i + (j + 1) % 3]];
+
+        collapses.push_back(Collapse{a, b, quadric_error(quadrics[a], vertices[b].position)});
+        collapses.push_back(Collapse{b, a, quadric_error(quadrics[b], vertices[a].position)});
+      }
+    }
+    std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+      return a.cost < b.cost;
+    });
+
+    for(u32 i = 0; i < wedges.size(); i++) {
+      wedges[i] = i;
+    }
+    std::fill(locked.begin(), locked.end(), 0);
+
+    // Each collapse removes about two triangles
+    u32 wanted_collapses = (triangles_count - target_count / 3) / 2 + 1;
+    u32 collapsed        = 0;
+
+    for(auto& collapse : collapses) {
+      if(collapsed >= wanted_collapses) {
+        break;
+      }
+
+      u32 from = collapse.from;
+      u32 to   = collapse.to;
+      if(locked[from] || locked[to]) {
+        continue;
+      }
+
+      const u32* triangles = &adjacency[adjacency_offsets[from]];
+      u32 count            = adjacency_offsets[from + 1] - adjacency_offsets[from];
+      if(collapse_flips(vertices, result, remap, triangles, count, from, to)) {
+        continue;
+      }
+
+      // Move each vertex at 'from' onto a vertex at 'to' it shares a triangle with,
+      // so their normals and texture coords stay on the same side of any seam
+      for(u32 t = 0; t < count; t++) {
+        const u32* tri = &result[triangles[t] * 3];
+
+        for(u32 j = 0; j < 3; j++) {
+          for(u32 k = 0; k < 3; k++) {
+            if(remap[tri[j]] == from && remap[tri[k]] == to) {
+              wedges[tri[j]] = tri[k];
+            }
+          }
+        }
+      }
+
+      // The ones without any vertex at 'to' next to them just take its position
+      for(u32 t = 0; t < count; t++) {
+        const u32* tri = &result[triangles[t] * 3];
+
+        for(u32 j = 0; j < 3; j++) {
+          if(remap[tri[j]] == from && wedges[tri[j]] == tri[j]) {
+            wedges[tri[j]] = to;
+          }
+        }
+      }
+
+      quadric_add(&quadrics[to], quadrics[from]);
+      max_error = glm::max(max_error, collapse.cost);
+
+      // The triangles around 'from' are about to change. Nothing else should touch them this pass.
+      for(u32 t = 0; t < count; t++) {
+        const u32* tri = &result[triangles[t] * 3];
+        locked[remap[tri[0]]] = 1;
+        locked[remap[tri[1]]] = 1;
+        locked[remap[tri[2]]] = 1;
+      }
+
+      collapsed++;
+    }
+
+    // Nothing else can go without breaking the surface
+    if(collapsed == 0) {
+      break;
+    }
+
+    // Apply the collapses and drop the triangles that got squashed into lines
+    u32 last = 0;
+    for(u32 i = 0; i < result.size(); i += 3) {
+      u32 a = wedges[result[i + 0]];
+      u32 b = wedges[result[i + 1]];
+      u32 c = wedges[result[i + 2]];
+
+      if(remap[a] == remap[b] || remap[b] == remap[c] || remap[a] == remap[c]) {
+        continue;
+      }
+
+      result[last++] = a;
+      result[last++] = b;
+      result[last++] = c;
+    }
+    result.resize(last);
+  }
+
+  return glm::sqrt(max_error);
+}
+/////////////////////////////////////////////////////////////////////////////////
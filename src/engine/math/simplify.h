@@ -0,0 +1,24 @@
+#pragma once
+
+#include "defines.h"
+#include "math/vertex.h"
+
+#include <vector>
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// Simplify the triangles in 'indices' down to (about) 'target_count' indices by collapsing
+// edges in the order of their quadric error. Vertices are never moved or created, so the
+// result indexes into the same 'vertices' and can share their buffer with the original.
+//
+// Vertices at the same position are treated as one, so meshes that were split along
+// their normal or texture seams still get simplified as one surface.
+//
+// Returns the error of the simplified surface. That is, roughly how far (in the same
+// units as the vertices) it strays from the original one.
+// NOTE: Stops early if nothing else can be collapsed without flipping a triangle.
+const f32 simplify_mesh(const std::vector<Vertex3D>& vertices,
+                        const std::vector<u32>& indices,
+                        const u32 target_count,
+                        std::vector<u32>* out_indices);
+/////////////////////////////////////////////////////////////////////////////////
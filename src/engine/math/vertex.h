@@ -3,6 +3,7 @@
 #include "defines.h"
 
 #include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
 
 // Vertex2D
 /////////////////////////////////////////////////////////////////////////////////
@@ -24,3 +25,15 @@ struct Vertex3D
   glm::vec2 texture_coords;
 };
 /////////////////////////////////////////////////////////////////////////////////
+
+// PackedVertex3D
+/////////////////////////////////////////////////////////////////////////////////
+// How a 'Vertex3D' is stored on the GPU. 16 bytes instead of 32.
+struct PackedVertex3D 
+{
+  glm::u16vec3 position; // Unorm16 between the mesh's min and max
+  u16 padding;
+  u32 normal;            // Snorm 10:10:10:2
+  u32 texture_coords;    // Two half floats
+};
+/////////////////////////////////////////////////////////////////////////////////
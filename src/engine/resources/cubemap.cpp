@@ -1,52 +1,118 @@
 #include "cubemap.h"
 #include "defines.h"
+#include "graphics/gl_state.h"
+#include "graphics/gpu_memory.h"
+#include "graphics/render_thread.h"
+#include "graphics/texture_units.h"
+#include "resources/texture_file.h"
+#include "core/thread_pool.h"
+#include "utils/utils_file.h"
 
 #include <stb_image/stb_image.h>
 #include <glad/gl.h>
 
+#include <atomic>
 #include <cstdio>
 #include <string>
 
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+// Every face (and every mip of it) goes straight from the mapped file to the GPU
+static bool load_cooked(CubeMap* cm, const std::string& path) {
+  TextureFile file;
+  if(!texture_file_open(path, &file)) {
+    return false;
+  }
+
+  TextureFileFormat format = (TextureFileFormat)file.header->format;
+  if(file.header->faces_count != TEXTURE_FILE_CUBEMAP_FACES || !texture_file_is_supported(format)) {
+    fprintf(stderr, "[WARNING]: Cannot use cooked cubemap \'%s\' (%s). Loading the faces instead\n", 
+            path.c_str(), 
+            texture_file_format_str(format));
+
+    texture_file_close(&file);
+    return false;
+  }
+
+  cm->width        = file.header->width;
+  cm->height       = file.header->height;
+  cm->num_channels = 4;
+
+  render_thread_call([cm, &file]() {
+    glGenTextures(1, &cm->id);
+    gl_state_bind_texture(GL_TEXTURE_CUBE_MAP, cm->id);
+
+    for(u32 i = 0; i < TEXTURE_FILE_CUBEMAP_FACES; i++) {
+      cm->gpu_size += texture_file_upload(&file, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, i, 0);
+    }
+    gpu_memory_alloc(GPU_MEMORY_TEXTURES, cm->gpu_size);
+
+    gl_state_bind_texture(GL_TEXTURE_CUBE_MAP, 0);
+  });
+
+  texture_file_close(&file);
+  return true;
+}
+/////////////////////////////////////////////////////////////////////////////////
+
 // Public functions
 /////////////////////////////////////////////////////////////////////////////////
 CubeMap* cubemap_load(const std::string& path) {
   CubeMap* cm = new CubeMap{};
 
-  glGenTextures(1, &cm->id);
-  glBindTexture(GL_TEXTURE_CUBE_MAP, cm->id);
+  std::string cooked_path = texture_file_is_cooked(path) ? path : texture_file_get_cooked_path(path);
+  if(file_exists(cooked_path) && load_cooked(cm, cooked_path)) {
+    return cm;
+  }
 
-  // @TODO: This is bad. Find a way for the user to write these instead of hard coding it
-  std::string ext = ".png";
-  std::string texture_paths[] = {
-    path + "right" + ext, 
-    path + "left" + ext, 
-    path + "top" + ext, 
-    path + "bottom" + ext, 
-    path + "front" + ext, 
-    path + "back" + ext, 
-  };
-
-  // Load all of the 6 faces of the cubemap (i.e load all the 6 textures)
+  std::string texture_paths[6];
   for(u32 i = 0; i < 6; i++) {
-    u8* data = stbi_load(texture_paths[i].c_str(), &cm->width, &cm->height, &cm->num_channels, 0);
-    if(!data) {
-      fprintf(stderr, "[ERROR]: Could not load cubemap texture at \'%s\'\n", texture_paths[i].c_str());
-      stbi_image_free(data);
+    texture_paths[i] = cubemap_get_face_path(path, i);
+  }
 
-      continue;
-    }
+  // Load all of the 6 faces of the cubemap (i.e load all the 6 textures) at the same time
+  u8* faces[6];
+  i32 sizes[6][3];
+  std::atomic<u32> faces_left = 0;
+  for(u32 i = 0; i < 6; i++) {
+    thread_pool_push([&faces, &sizes, &texture_paths, i]() {
+      // Faces used to be decoded with whatever the last texture set the (global) flip to, which was always on
+      stbi_set_flip_vertically_on_load_thread(true);
+
+      faces[i] = stbi_load(texture_paths[i].c_str(), &sizes[i][0], &sizes[i][1], &sizes[i][2], 0);
+      if(!faces[i]) {
+        fprintf(stderr, "[ERROR]: Could not load cubemap texture at \'%s\'\n", texture_paths[i].c_str());
+      }
+    }, &faces_left);
+  }
+  thread_pool_wait(&faces_left);
 
-    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, cm->width, cm->height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    stbi_image_free(data);
+  for(u32 i = 0; i < 6; i++) {
+    if(faces[i]) {
+      cm->width        = sizes[i][0];
+      cm->height       = sizes[i][1];
+      cm->num_channels = sizes[i][2];
+    }
   }
 
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+  render_thread_call([cm, &faces]() {
+    glGenTextures(1, &cm->id);
+    gl_state_bind_texture(GL_TEXTURE_CUBE_MAP, cm->id);
+
+    for(u32 i = 0; i < 6; i++) {
+      if(faces[i]) {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, cm->width, cm->height, 0, GL_RGB, GL_UNSIGNED_BYTE, faces[i]);
+        cm->gpu_size += gpu_memory_texture_size(cm->width, cm->height, 3, false);
+      }
+    }
+    gpu_memory_alloc(GPU_MEMORY_TEXTURES, cm->gpu_size);
+
+    gl_state_bind_texture(GL_TEXTURE_CUBE_MAP, 0);
+  });
 
-  glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+  for(u32 i = 0; i < 6; i++) {
+    stbi_image_free(faces[i]);
+  }
 
   return cm;
 }
@@ -56,14 +122,27 @@ void cubemap_unload(CubeMap* cm) {
     return;
   }
 
-  delete cm;
+  // The skybox might still be drawn by a recorded frame
+  render_thread_push([cm]() {
+    gl_state_forget_texture(cm->id);
+    glDeleteTextures(1, &cm->id);
+    gpu_memory_free(GPU_MEMORY_TEXTURES, cm->gpu_size);
+
+    delete cm;
+  });
 }
 
-void cubemap_use(CubeMap* cm) {
+const u32 cubemap_use(CubeMap* cm) {
   if(!cm) {
-    return;
+    return 0;
   }
 
-  glBindTexture(GL_TEXTURE_CUBE_MAP, cm->id);
+  return texture_units_bind(GL_TEXTURE_CUBE_MAP, cm->id, SAMPLER_LINEAR_CLAMP);
+}
+
+const std::string cubemap_get_face_path(const std::string& path, const u32 face) {
+  // @TODO: This is bad. Find a way for the user to write these instead of hard coding it
+  const char* names[] = {"right", "left", "top", "bottom", "front", "back"};
+  return path + names[face] + ".png";
 }
 /////////////////////////////////////////////////////////////////////////////////
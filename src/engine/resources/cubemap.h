@@ -9,12 +9,23 @@
 struct CubeMap {
   u32 id;
   i32 width, height, num_channels;
+
+  usizei gpu_size; // Bytes taken on the GPU by all the faces
 };
 /////////////////////////////////////////////////////////////////////////////////
 
 // Public functions
 /////////////////////////////////////////////////////////////////////////////////
+// Load the six faces found at 'path' (see 'cubemap_get_face_path'), or the cooked version 
+// of the directory (see 'texture_file_get_cooked_path') if there is one. 
+// The path can also point to the cooked file directly.
 CubeMap* cubemap_load(const std::string& path);
 void cubemap_unload(CubeMap* cm);
-void cubemap_use(CubeMap* cm);
+
+// Bind the cubemap to whichever texture unit is free (see 'texture_units_bind') and return that unit
+// NOTE: Must be called from the render thread.
+const u32 cubemap_use(CubeMap* cm);
+
+// Where the image of the given face (in the order OpenGL numbers them, starting at +X) is expected to be
+const std::string cubemap_get_face_path(const std::string& path, const u32 face);
 /////////////////////////////////////////////////////////////////////////////////
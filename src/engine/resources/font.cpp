@@ -1,9 +1,8 @@
 #include "font.h"
 #include "defines.h"
-#include "resources/texture.h"
+#include "resources/glyph_atlas.h"
 #include "utils/utils_file.h"
 
-#include <glad/gl.h>
 #include <stb_truetype/stb_truetype.h>
 #include <glm/glm.hpp>
 
@@ -46,29 +45,25 @@ static void init_font_chars(Font* font, stbtt_fontinfo* info) {
   font->ascent = ascent * scale_factor;
   font->descent = descent * scale_factor;
 
-  for(u32 i = 0; i < info->numGlyphs; i++) { 
+  font->scale_factor = scale_factor;
+
+  // Only the metrics are needed up front. The pixels are rasterized into the atlas 
+  // the first time the glyph gets drawn (see 'font_get_glyph_region').
+  // NOTE: Glyphs are looked up with an 'i8', so only the printable ASCII range can ever be reached.
+  for(i32 codepoint = 32; codepoint < 127; codepoint++) { 
     Glyph glyph;
-    glyph.unicode = i + 32;
+    glyph.unicode = codepoint;
 
     // This functions will return 0 if the given unicode is not in 
     // the font. Thus, to speed up the loop, we just skip these unicodes.
-    i32 glyph_index = stbtt_FindGlyphIndex(info, glyph.unicode);
-    if(glyph_index == 0) {
+    glyph.glyph_index = stbtt_FindGlyphIndex(info, glyph.unicode);
+    if(glyph.glyph_index == 0) {
       continue;
     }
 
-    // Pixels of the specific codepoint, offset, and size 
-    u8* mono_bitmap = stbtt_GetGlyphBitmap(info, 
-                                           0,
-                                           scale_factor, 
-                                           glyph_index, 
-                                           &glyph.width, 
-                                           &glyph.height, 
-                                           &glyph.x_offset, 
-                                           &glyph.y_offset);
-
+    // The box the pixels of the glyph would take, relative to the origin
     stbtt_GetGlyphBitmapBox(info, 
-                            glyph_index, 
+                            glyph.glyph_index, 
                             scale_factor, 
                             scale_factor, 
                             &glyph.left, 
@@ -76,35 +71,14 @@ static void init_font_chars(Font* font, stbtt_fontinfo* info) {
                             &glyph.right, 
                             &glyph.bottom);
 
-    // Only give OpenGL the pixels when it is valid 
-    if(mono_bitmap) {
-      // Converting the mono bitmap into an RGBA bitmap format to be used more 
-      // efficiently with the batch renderer.
-      usizei btmp_size = glyph.width * glyph.height * 4;
-      u8* bitmap = new u8[btmp_size];
-      for(u32 i = 0; i < glyph.height; i++) {
-        for(u32 j = 0; j < glyph.width; j++) {
-          u32 mono_index = (i * glyph.width) + j; 
-          u32 rgba_index = ((i * glyph.width) + j) * 4;
-
-          bitmap[rgba_index] = 255; // Red 
-          bitmap[rgba_index + 1] = 255; // Green 
-          bitmap[rgba_index + 2] = 255; // Blue 
-          bitmap[rgba_index + 3] = mono_bitmap[mono_index]; // Alpha 
-        }
-      }
-
-      glyph.texture = texture_load(glyph.width, glyph.height, TEXTURE_FORMAT_RGBA, bitmap);
-      delete[] bitmap;
-    }  
-    else { // Probably the space character (' ') so just allocate an empty buffer for it
-      u32 pixels = 0x00; 
-      glyph.texture = texture_load(1, 1, TEXTURE_FORMAT_RED, &pixels);
-    }
+    glyph.width    = glyph.right - glyph.left;
+    glyph.height   = glyph.bottom - glyph.top;
+    glyph.x_offset = glyph.left;
+    glyph.y_offset = glyph.top;
     
     // Getting the advance and the left side bearing of the specific codepoint/glyph.
     // The advance is the value required to "advance" to the next glyph
-    stbtt_GetGlyphHMetrics(info, glyph_index, &glyph.advance_x, &glyph.left_side_bearing);
+    stbtt_GetGlyphHMetrics(info, glyph.glyph_index, &glyph.advance_x, &glyph.left_side_bearing);
     glyph.advance_x *= scale_factor;
 
     // Getting the kern of the glyph. The kern is used to make some specific glyphs look better 
@@ -115,10 +89,6 @@ static void init_font_chars(Font* font, stbtt_fontinfo* info) {
     glyph.y_offset += font->ascent;
     glyph.y_offset -= glyph.top / 2;
     glyph.x_offset = glyph.right / 2;
-
-    // Make sure the deallocate the bitmap data that was allocated by STB 
-    // NOTE: Potentially really slow to have an allocation and a deallocation in a loop 
-    stbtt_FreeBitmap(mono_bitmap, nullptr);
   
     // A valid glyph that was loaded 
     font->glyphs_count++;
@@ -136,21 +106,19 @@ Font* font_load(const std::string& path, const f32 size) {
   Font* font = new Font{};
   font->base_size = size; 
 
-  u8* data = get_font_data(path);
-  stbtt_fontinfo info;
-  if(stbtt_InitFont(&info, data, stbtt_GetFontOffsetForIndex(data, 0)) == 0) {
+  font->data  = get_font_data(path);
+  font->info  = new stbtt_fontinfo{};
+  font->atlas = glyph_atlas_create();
+  if(!font->data || stbtt_InitFont(font->info, font->data, stbtt_GetFontOffsetForIndex(font->data, 0)) == 0) {
     fprintf(stderr, "[ERROR]: Failed to initialize stb for font \'%s\'\n", path.c_str());
     return font;
   }
 
-  font->glyphs.reserve(info.numGlyphs);
   font->glyph_padding = 4.0f;
 
-  // Load the textures and required values for every glyph in the font 
-  init_font_chars(font, &info);
-  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  // Load the required values for every glyph in the font 
+  init_font_chars(font, font->info);
 
-  delete[] data;
   return font;
 }
 
@@ -159,9 +127,9 @@ void font_unload(Font* font) {
     return;
   }
 
-  for(u32 i = 0; i < font->glyphs.size(); i++) {
-    texture_unload(font->glyphs[i].texture);
-  }
+  glyph_atlas_destroy(font->atlas);
+  delete font->info;
+  delete[] font->data;
   
   font->glyphs.clear();
   delete font;
@@ -178,4 +146,28 @@ i32 font_get_glyph_index(const Font* font, i8 codepoint) {
 
   return 0;
 }
+
+const GlyphRegion& font_get_glyph_region(Font* font, const i32 index) {
+  const Glyph& glyph = font->glyphs[index];
+
+  const GlyphRegion* region = glyph_atlas_find(font->atlas, index);
+  if(region) {
+    return *region;
+  }
+
+  // Rasterize straight into a single-channel buffer. The atlas only keeps a copy until it is uploaded.
+  std::vector<u8> pixels((usizei)glyph.width * glyph.height);
+  if(!pixels.empty()) {
+    stbtt_MakeGlyphBitmap(font->info, 
+                          pixels.data(), 
+                          glyph.width, 
+                          glyph.height, 
+                          glyph.width, 
+                          font->scale_factor, 
+                          font->scale_factor, 
+                          glyph.glyph_index);
+  }
+
+  return glyph_atlas_add(font->atlas, index, glyph.width, glyph.height, pixels.data());
+}
 /////////////////////////////////////////////////////////////////////////////////
@@ -1,16 +1,18 @@
 #pragma once 
 
 #include "defines.h"
-#include "resources/texture.h"
+#include "resources/glyph_atlas.h"
 
 #include <string>
 #include <vector>
 
+struct stbtt_fontinfo;
+
 // Glyph
 /////////////////////////////////////////////////////////////////////////////////
 struct Glyph {
   i8 unicode;
-  Texture* texture;
+  i32 glyph_index; // The index of the glyph in the font file itself
 
   i32 width, height;
   i32 x_offset, y_offset;
@@ -29,6 +31,13 @@ struct Font {
 
   std::vector<Glyph> glyphs;
   u32 glyphs_count;
+
+  // Glyphs are only rasterized (into the atlas) the first time they are drawn, 
+  // so the font file has to stay around
+  u8* data             = nullptr;
+  stbtt_fontinfo* info = nullptr;
+  f32 scale_factor     = 0.0f;
+  GlyphAtlas* atlas    = nullptr;
 };
 /////////////////////////////////////////////////////////////////////////////////
 
@@ -37,4 +46,7 @@ struct Font {
 Font* font_load(const std::string& path, const f32 size);
 void font_unload(Font* font);
 i32 font_get_glyph_index(const Font* font, i8 codepoint);
+
+// Where the glyph at the given index is in the font's atlas. The glyph gets rasterized if this is the first time it is asked for.
+const GlyphRegion& font_get_glyph_region(Font* font, const i32 index);
 /////////////////////////////////////////////////////////////////////////////////
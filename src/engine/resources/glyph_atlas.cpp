@@ -0,0 +1,152 @@
+#include "glyph_atlas.h"
+#include "defines.h"
+#include "graphics/gl_state.h"
+#include "graphics/render_thread.h"
+#include "resources/texture.h"
+
+#include <glad/gl.h>
+
+#include <cstdio>
+#include <vector>
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static GlyphAtlasPage* add_page(GlyphAtlas* atlas) {
+  GlyphAtlasPage page;
+  page.next_y = 0;
+
+  // Starts out empty, so the padding around every glyph is already clear. 
+  // Only the first level is ever written (and sampled), so there are no mipmaps.
+  std::vector<u8> pixels(GLYPH_ATLAS_PAGE_SIZE * GLYPH_ATLAS_PAGE_SIZE, 0);
+  page.texture = texture_load(GLYPH_ATLAS_PAGE_SIZE, GLYPH_ATLAS_PAGE_SIZE, TEXTURE_FORMAT_RED, pixels.data(), false);
+
+  // Sample the single channel as (1, 1, 1, red), which is what the glyphs used to be stored as
+  Texture* texture = page.texture;
+  render_thread_call([texture]() {
+    i32 swizzle[] = {GL_ONE, GL_ONE, GL_ONE, GL_RED};
+
+    gl_state_bind_texture(GL_TEXTURE_2D, texture->id);
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    gl_state_bind_texture(GL_TEXTURE_2D, 0);
+  });
+
+  atlas->pages.push_back(page);
+  return &atlas->pages.back();
+}
+
+// Find room for a 'width' by 'height' rectangle. The shelf that wastes the least height wins, 
+// and a new shelf (or page) is only started when none of the existing ones fit. 
+static GlyphAtlasPage* find_room(GlyphAtlas* atlas, const i32 width, const i32 height, i32* out_x, i32* out_y) {
+  GlyphAtlasPage* best_page   = nullptr;
+  GlyphAtlasShelf* best_shelf = nullptr;
+
+  for(auto& page : atlas->pages) {
+    for(auto& shelf : page.shelves) {
+      if(shelf.height < height || shelf.next_x + width > GLYPH_ATLAS_PAGE_SIZE) {
+        continue;
+      }
+
+      if(!best_shelf || shelf.height < best_shelf->height) {
+        best_page  = &page;
+        best_shelf = &shelf;
+      }
+    }
+  }
+
+  // A glyph much shorter than the shelf would waste most of the row. A new shelf is better, if there is room for one.
+  if(!best_shelf || best_shelf->height > height * 2) {
+    GlyphAtlasPage* open_page = nullptr;
+    for(auto& page : atlas->pages) {
+      if(page.next_y + height <= GLYPH_ATLAS_PAGE_SIZE) {
+        open_page = &page;
+        break;
+      }
+    }
+
+    // Every page is full. Only grow when nothing fits at all.
+    if(!open_page && !best_shelf) {
+      open_page = add_page(atlas);
+    }
+
+    if(open_page) {
+      open_page->shelves.push_back(GlyphAtlasShelf{open_page->next_y, height, 0});
+      open_page->next_y += height;
+
+      best_page  = open_page;
+      best_shelf = &open_page->shelves.back();
+    }
+  }
+
+  *out_x = best_shelf->next_x;
+  *out_y = best_shelf->y;
+
+  best_shelf->next_x += width;
+  return best_page;
+}
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+GlyphAtlas* glyph_atlas_create() {
+  return new GlyphAtlas{};
+}
+
+void glyph_atlas_destroy(GlyphAtlas* atlas) {
+  if(!atlas) {
+    return;
+  }
+
+  for(auto& page : atlas->pages) {
+    texture_unload(page.texture);
+  }
+
+  atlas->pages.clear();
+  atlas->regions.clear();
+  delete atlas;
+}
+
+const GlyphRegion* glyph_atlas_find(const GlyphAtlas* atlas, const u32 key) {
+  auto it = atlas->regions.find(key);
+  if(it == atlas->regions.end()) {
+    return nullptr;
+  }
+
+  return &it->second;
+}
+
+const GlyphRegion& glyph_atlas_add(GlyphAtlas* atlas, const u32 key, const i32 width, const i32 height, const u8* pixels) {
+  GlyphRegion& region = atlas->regions[key];
+  region = GlyphRegion{};
+
+  // Nothing to draw
+  if(!pixels || width <= 0 || height <= 0) {
+    return region;
+  }
+
+  i32 padded_width  = width + GLYPH_ATLAS_PADDING * 2;
+  i32 padded_height = height + GLYPH_ATLAS_PADDING * 2;
+  if(padded_width > GLYPH_ATLAS_PAGE_SIZE || padded_height > GLYPH_ATLAS_PAGE_SIZE) {
+    fprintf(stderr, "[ERROR]: Glyph of size %ix%i does not fit in a glyph atlas page\n", width, height);
+    return region;
+  }
+
+  i32 x, y;
+  GlyphAtlasPage* page = find_room(atlas, padded_width, padded_height, &x, &y);
+  x += GLYPH_ATLAS_PADDING;
+  y += GLYPH_ATLAS_PADDING;
+
+  f32 page_size  = (f32)GLYPH_ATLAS_PAGE_SIZE;
+  region.texture = page->texture;
+  region.uv_min  = glm::vec2(x / page_size, y / page_size);
+  region.uv_max  = glm::vec2((x + width) / page_size, (y + height) / page_size);
+
+  // Recorded like a draw, so it lands before the first batch that uses the glyph
+  Texture* texture = page->texture;
+  std::vector<u8> copy(pixels, pixels + (usizei)width * height);
+  render_thread_push([texture, x, y, width, height, copy]() {
+    texture_update(texture, x, y, width, height, copy.data());
+  });
+
+  return region;
+}
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "defines.h"
+#include "resources/texture.h"
+
+#include <glm/vec2.hpp>
+
+#include <unordered_map>
+#include <vector>
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+// The size of every page of the atlas (in pixels). A new page is added once nothing fits anymore.
+#define GLYPH_ATLAS_PAGE_SIZE 1024
+
+// Empty pixels kept around every glyph, so filtering never bleeds into its neighbours
+#define GLYPH_ATLAS_PADDING 1
+/////////////////////////////////////////////////////////////////////////////////
+
+// GlyphRegion
+/////////////////////////////////////////////////////////////////////////////////
+struct GlyphRegion {
+  Texture* texture = nullptr; // The page the glyph is on, or 'nullptr' for glyphs without any pixels (like ' ')
+  glm::vec2 uv_min, uv_max;   // 'uv_min' is the top-left corner of the glyph
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// GlyphAtlasPage
+/////////////////////////////////////////////////////////////////////////////////
+// Glyphs are packed into shelves, which are rows as tall as the first glyph that went into them
+struct GlyphAtlasShelf {
+  i32 y, height;
+  i32 next_x;
+};
+
+struct GlyphAtlasPage {
+  Texture* texture;
+
+  std::vector<GlyphAtlasShelf> shelves;
+  i32 next_y;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// GlyphAtlas
+/////////////////////////////////////////////////////////////////////////////////
+struct GlyphAtlas {
+  std::vector<GlyphAtlasPage> pages;
+  std::unordered_map<u32, GlyphRegion> regions;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// A set of single-channel pages that glyphs get packed into as they are needed. The pages are 
+// sampled as white with the glyph as the alpha, so text batches with everything else in 'renderer2d'.
+GlyphAtlas* glyph_atlas_create();
+void glyph_atlas_destroy(GlyphAtlas* atlas);
+
+// Returns the region that was added with the given key, or 'nullptr' if there is none yet
+const GlyphRegion* glyph_atlas_find(const GlyphAtlas* atlas, const u32 key);
+
+// Pack the given single-channel pixels (one byte per pixel, with no padding between rows) into the 
+// atlas under the given key, and return where they ended up. 
+// NOTE: The pixels are copied, and uploaded on the render thread before anything recorded after this.
+const GlyphRegion& glyph_atlas_add(GlyphAtlas* atlas, const u32 key, const i32 width, const i32 height, const u8* pixels);
+/////////////////////////////////////////////////////////////////////////////////
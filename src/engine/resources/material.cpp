@@ -1,18 +1,120 @@
 #include "material.h"
 #include "defines.h"
 #include "graphics/color.h"
+#include "graphics/gl_ext.h"
+#include "graphics/gl_state.h"
+#include "graphics/gpu_memory.h"
 #include "graphics/shader.h"
+#include "graphics/render_thread.h"
 #include "resources/texture.h"
 
+#include <glad/gl.h>
+
+#include <vector>
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+static u32 s_next_material_id = 0;
+
+// How many materials the buffer can hold before it has to grow
+#define MATERIAL_BUFFER_CAPACITY 64
+/////////////////////////////////////////////////////////////////////////////////
+
+// MaterialData
+/////////////////////////////////////////////////////////////////////////////////
+// How a material is laid out in the material buffer (std430)
+struct MaterialData {
+  glm::vec4 color;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// MaterialBuffer
+/////////////////////////////////////////////////////////////////////////////////
+// Only ever touched by the render thread
+struct MaterialBuffer {
+  u32 id       = 0;
+  u32 capacity = 0; // In materials
+
+  std::vector<MaterialData> data;
+  std::vector<u32> free_indices;
+
+  std::vector<Material*> dirty;
+};
+
+static MaterialBuffer s_buffer;
+/////////////////////////////////////////////////////////////////////////////////
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static void mark_dirty(Material* mat) {
+  if(!mat->is_dirty) {
+    mat->is_dirty = true;
+    s_buffer.dirty.push_back(mat);
+  }
+}
+
+static void add_to_buffer(Material* mat) {
+  if(!s_buffer.free_indices.empty()) {
+    mat->buffer_index = s_buffer.free_indices.back();
+    s_buffer.free_indices.pop_back();
+  }
+  else {
+    mat->buffer_index = s_buffer.data.size();
+    s_buffer.data.emplace_back();
+  }
+
+  s_buffer.data[mat->buffer_index].color = mat->color;
+  mark_dirty(mat);
+}
+
+static void remove_from_buffer(Material* mat) {
+  s_buffer.free_indices.push_back(mat->buffer_index);
+
+  // Should not be uploaded anymore
+  if(mat->is_dirty) {
+    std::erase(s_buffer.dirty, mat);
+  }
+}
+
+// Makes sure the GPU buffer can hold every material. Returns 'true' if it had to be recreated.
+static bool reserve_buffer() {
+  if(s_buffer.id != 0 && s_buffer.data.size() <= s_buffer.capacity) {
+    return false;
+  }
+
+  u32 capacity = s_buffer.capacity > 0 ? s_buffer.capacity : MATERIAL_BUFFER_CAPACITY;
+  while(capacity < s_buffer.data.size()) {
+    capacity *= 2;
+  }
+
+  material_shutdown_buffer();
+
+  glGenBuffers(1, &s_buffer.id);
+  gl_state_bind_buffer(GL_SHADER_STORAGE_BUFFER, s_buffer.id);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(MaterialData) * capacity, nullptr, GL_DYNAMIC_DRAW);
+  gl_state_bind_buffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  s_buffer.capacity = capacity;
+  gpu_memory_alloc(GPU_MEMORY_UNIFORMS, sizeof(MaterialData) * capacity);
+
+  return true;
+}
+/////////////////////////////////////////////////////////////////////////////////
+
 // Public functions 
 /////////////////////////////////////////////////////////////////////////////////
 Material* material_load(Texture* diffuse, Texture* specular, Shader* shader) {
   Material* mat = new Material{};
+  mat->id = s_next_material_id++;
   mat->diffuse_map = diffuse;
   mat->specular_map = specular;
   mat->shader = shader;
   mat->color = COLOR_WHITE;
 
+  render_thread_push([mat]() {
+    add_to_buffer(mat);
+  });
+
   return mat;
 }
 
@@ -22,33 +124,77 @@ void material_unload(Material* mat) {
 
   // Do not unload the shader since the material does not own the pointer. 
   // It just points to it but does not own it.
-  mat->shader = nullptr;
+  // NOTE: Recorded draws might still use the material, so it is freed on the render thread.
+  render_thread_push([mat]() {
+    remove_from_buffer(mat);
 
-  delete mat;
+    mat->shader = nullptr;
+    delete mat;
+  });
 }
 
 void material_use(Material* mat) {
   // Use the shader 
   shader_bind(mat->shader);
-  shader_upload_int(mat->shader, "u_diffuse", mat->diffuse_map->slot);
-  // shader_upload_int(mat->shader, "u_specular", mat->specular_map->slot);
+  shader_upload_int(mat->shader, "u_material_index", mat->buffer_index);
+  // shader_upload_int(mat->shader, "u_specular", texture_use(mat->specular_map));
 
   // Use the maps (if they are valid/exist)
   if(mat->diffuse_map) {
-    texture_use(mat->diffuse_map, mat->diffuse_map->slot);
+    shader_upload_int(mat->shader, "u_diffuse", texture_use(mat->diffuse_map));
   }
 
   if(mat->specular_map) {
-    texture_use(mat->specular_map, mat->specular_map->slot);
+    texture_use(mat->specular_map);
   }
 }
 
 void material_set_color(Material* mat, const glm::vec4& color) {
   mat->color = color;
-  shader_upload_vec4(mat->shader, "u_color", color);
+
+  render_thread_push([mat, color]() {
+    s_buffer.data[mat->buffer_index].color = color;
+    mark_dirty(mat);
+  });
 }
 
-void material_set_model(Material* mat, const glm::mat4& model) {
-  shader_upload_mat4(mat->shader, "u_model", model);
+const usizei material_flush_buffer() {
+  usizei uploaded = 0;
+
+  // A new buffer gets everything at once
+  if(reserve_buffer()) {
+    gl_state_bind_buffer(GL_SHADER_STORAGE_BUFFER, s_buffer.id);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(MaterialData) * s_buffer.data.size(), s_buffer.data.data());
+
+    uploaded = sizeof(MaterialData) * s_buffer.data.size();
+  }
+  else if(!s_buffer.dirty.empty()) {
+    gl_state_bind_buffer(GL_SHADER_STORAGE_BUFFER, s_buffer.id);
+    for(auto& mat : s_buffer.dirty) {
+      glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(MaterialData) * mat->buffer_index, sizeof(MaterialData), &s_buffer.data[mat->buffer_index]);
+    }
+
+    uploaded = sizeof(MaterialData) * s_buffer.dirty.size();
+  }
+
+  for(auto& mat : s_buffer.dirty) {
+    mat->is_dirty = false;
+  }
+  s_buffer.dirty.clear();
+
+  gl_state_bind_buffer_base(GL_SHADER_STORAGE_BUFFER, MATERIAL_BUFFER_BINDING, s_buffer.id);
+  return uploaded;
+}
+
+void material_shutdown_buffer() {
+  if(s_buffer.id == 0) {
+    return;
+  }
+
+  gl_state_forget_buffer(s_buffer.id);
+  glDeleteBuffers(1, &s_buffer.id);
+  gpu_memory_free(GPU_MEMORY_UNIFORMS, sizeof(MaterialData) * s_buffer.capacity);
+
+  s_buffer.id = 0;
 }
 /////////////////////////////////////////////////////////////////////////////////
@@ -5,6 +5,16 @@
 
 #include <glm/glm.hpp>
 
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+// The shader storage binding every shader can read the materials from, as:
+//
+//   struct MaterialData { vec4 color; };
+//   layout(std430, binding = 1) readonly buffer materials { MaterialData u_materials[]; };
+//   uniform int u_material_index;
+#define MATERIAL_BUFFER_BINDING 1
+/////////////////////////////////////////////////////////////////////////////////
+
 // MaterialMapType
 /////////////////////////////////////////////////////////////////////////////////
 enum MaterialMapType {
@@ -16,11 +26,18 @@ enum MaterialMapType {
 // Material
 /////////////////////////////////////////////////////////////////////////////////
 struct Material {
+  u32 id; // Unique per material. Used to sort draws by material.
+
   Texture* diffuse_map;
   Texture* specular_map;
   
   Shader* shader;
   glm::vec4 color;
+
+  // Where the material lives in the material buffer
+  // NOTE: Only valid on the render thread.
+  u32 buffer_index;
+  bool is_dirty; // Needs to be uploaded again
 };
 /////////////////////////////////////////////////////////////////////////////////
 
@@ -29,14 +46,22 @@ struct Material {
 Material* material_load(Texture* diffuse, Texture* specular, Shader* shader);
 void material_unload(Material* mat);
 
-// Bind the shader and render textures whithin the maps
+// Bind the shader and render textures whithin the maps, and point the shader at 
+// the material's data in the material buffer ('u_material_index')
+// NOTE: Touches OpenGL directly, so it must run on the render thread (inside a recorded command).
 void material_use(Material* mat);
 
-// NOTE: The 'material_set_*' functions below do NOT bind the shader before setting the 
-// uniforms. You must use the 'material_use' function beforehand.
-// Set the color uniform in the shader
+// Set the color of the material. The material buffer only gets the new color once it is 
+// flushed, and only the materials that actually changed get uploaded.
+// NOTE: The change is recorded on the render thread like any other command.
 void material_set_color(Material* mat, const glm::vec4& color);
 
-// Set the model matrix in the shader
-void material_set_model(Material* mat, const glm::mat4& model);
+// Upload every material that changed since the last flush, and bind the material buffer
+// to 'MATERIAL_BUFFER_BINDING'. Returns how many bytes were uploaded.
+// NOTE: Must be called from the render thread, before drawing anything with materials.
+const usizei material_flush_buffer();
+
+// Free the material buffer
+// NOTE: Must be called from the render thread.
+void material_shutdown_buffer();
 /////////////////////////////////////////////////////////////////////////////////
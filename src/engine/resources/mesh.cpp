@@ -1,9 +1,20 @@
 #include "mesh.h"
 #include "defines.h"
+#include "graphics/geometry_arena.h"
+#include "graphics/render_thread.h"
+#include "math/simplify.h"
 
-#include <cstddef>
 #include <glm/glm.hpp>
-#include <glad/gl.h>
+
+#include <cstdio>
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+static u32 s_next_mesh_id = 0;
+
+// Each LOD should at least get rid of this much of the LOD before it. Otherwise, it's not worth it.
+#define LOD_MIN_REDUCTION 0.8f
+/////////////////////////////////////////////////////////////////////////////////
 
 // Private functions
 /////////////////////////////////////////////////////////////////////////////////
@@ -72,38 +83,52 @@ static void setup_buffers(Mesh* mesh) {
   };
 }
 
-void setup_gl_buffers(Mesh* mesh) {
-  // VAO
-  glGenVertexArrays(1, &mesh->vao);
-  glBindVertexArray(mesh->vao);
-
-  // EBO
-  glGenBuffers(1, &mesh->ebo);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ebo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(u32) * mesh->indices.size(), &mesh->indices[0], GL_STATIC_DRAW);
-  
-  // IBO - Instance buffer
-  glGenBuffers(1, &mesh->ibo);
-  glBindBuffer(GL_ARRAY_BUFFER, mesh->ibo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4) * MAX_MESH_INSTANCES, nullptr, GL_DYNAMIC_DRAW);
-
-  // VBO
-  glGenBuffers(1, &mesh->vbo);
-  glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex3D) * mesh->vertices.size(), &mesh->vertices[0], GL_STATIC_DRAW);
- 
-  // Attributes 
-  // Position 
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(Vertex3D), 0);
-  
-  // Normal 
-  glEnableVertexAttribArray(1);
-  glVertexAttribPointer(1, 3, GL_FLOAT, false, sizeof(Vertex3D), (void*)offsetof(Vertex3D, normal));
-  
-  // Texture coords 
-  glEnableVertexAttribArray(2);
-  glVertexAttribPointer(2, 2, GL_FLOAT, false, sizeof(Vertex3D), (void*)offsetof(Vertex3D, texture_coords));
+static void calc_bounds(Mesh* mesh) {
+  // An empty mesh has nothing to bound, so it just gets zero bounds
+  mesh->min = glm::vec3(0.0f);
+  mesh->max = glm::vec3(0.0f);
+
+  if(!mesh->vertices.empty()) {
+    mesh->min = mesh->vertices[0].position;
+    mesh->max = mesh->vertices[0].position;
+  }
+
+  for(u32 i = 1; i < mesh->vertices.size(); i++) {
+    glm::vec3 vertex = mesh->vertices[i].position;
+
+    mesh->min = glm::min(mesh->min, vertex);
+    mesh->max = glm::max(mesh->max, vertex);
+  }
+
+  geometry_arena_get_dequantize(mesh->min, mesh->max, &mesh->dequantize_offset, &mesh->dequantize_scale);
+}
+
+// NOTE: Must be called from the render thread
+static GeometryRange add_indices(const Mesh* mesh, const std::vector<u32>& indices) {
+  if(!mesh->has_short_indices) {
+    return geometry_arena_add_indices(indices.data(), indices.size());
+  }
+
+  std::vector<u16> short_indices(indices.begin(), indices.end());
+  return geometry_arena_add_indices(short_indices.data(), short_indices.size());
+}
+
+static void setup_gl_buffers(Mesh* mesh) {
+  // Everything gets drawn indexed
+  if(mesh->indices.size() == 0) {
+    for(u32 i = 0; i < mesh->vertices.size(); i++) {
+      mesh->indices.push_back(i);
+    }
+  }
+
+  calc_bounds(mesh);
+  mesh->has_short_indices = mesh->vertices.size() <= MESH_MAX_SHORT_VERTICES;
+
+  render_thread_call([mesh]() {
+    mesh->vertex_range = geometry_arena_add_vertices(mesh->vertices.data(), mesh->vertices.size(), mesh->min, mesh->max);
+    mesh->lods[0].index_range = add_indices(mesh, mesh->indices);
+    mesh->lods[0].error       = 0.0f;
+  });
 }
 /////////////////////////////////////////////////////////////////////////////////
 
@@ -111,44 +136,89 @@ void setup_gl_buffers(Mesh* mesh) {
 /////////////////////////////////////////////////////////////////////////////////
 Mesh* mesh_create() {
   Mesh* mesh = new Mesh{};
+  mesh->id = s_next_mesh_id++;
   setup_buffers(mesh);
   setup_gl_buffers(mesh);
 
-  mesh->min = mesh->vertices[0].position;
-  mesh->max = mesh->vertices[0].position;
-  for(u32 i = 1; i < mesh->vertices.size(); i++) {
-    glm::vec3 vertex = mesh->vertices[i].position;
-
-    mesh->min = glm::min(mesh->min, vertex);
-    mesh->max = glm::max(mesh->max, vertex);
-  }
-
   return mesh;
 }
 
-Mesh* mesh_create(const std::vector<Vertex3D>& vertices, const std::vector<u32>& indices) {
+Mesh* mesh_create(const std::vector<Vertex3D>& vertices, const std::vector<u32>& indices, const bool keep_geometry) {
   Mesh* mesh = new Mesh{};
+  mesh->id = s_next_mesh_id++;
   mesh->vertices = vertices;
   mesh->indices = indices;
 
   setup_gl_buffers(mesh);
-
-  mesh->min = mesh->vertices[0].position;
-  mesh->max = mesh->vertices[0].position;
-  for(u32 i = 1; i < mesh->vertices.size(); i++) {
-    glm::vec3 vertex = mesh->vertices[i].position;
-
-    mesh->min = glm::min(mesh->min, vertex);
-    mesh->max = glm::max(mesh->max, vertex);
+  if(!keep_geometry) {
+    mesh_release_geometry(mesh);
   }
 
   return mesh;
 }
 
 void mesh_destroy(Mesh* mesh) {
-  mesh->vertices.clear();
-  mesh->indices.clear();
+  // The ranges can not be reused until every recorded draw of the mesh is done
+  render_thread_push([mesh]() {
+    geometry_arena_remove_vertices(mesh->vertex_range);
+    for(u32 i = 0; i < mesh->lods_count; i++) {
+      geometry_arena_remove_indices(mesh->lods[i].index_range, mesh->has_short_indices ? sizeof(u16) : sizeof(u32));
+    }
+
+    mesh->vertices.clear();
+    mesh->indices.clear();
+
+    delete mesh;
+  });
+}
+
+void mesh_release_geometry(Mesh* mesh) {
+  // 'clear' alone keeps the memory around
+  std::vector<Vertex3D>().swap(mesh->vertices);
+  std::vector<u32>().swap(mesh->indices);
+}
+
+const usizei mesh_get_geometry_size(const Mesh* mesh) {
+  return sizeof(Vertex3D) * mesh->vertices.capacity() + sizeof(u32) * mesh->indices.capacity();
+}
+
+void mesh_generate_lods(Mesh* mesh) {
+  if(mesh->vertices.empty()) {
+    fprintf(stderr, "[WARNING]: Cannot generate LODs for a mesh without geometry\n");
+    return;
+  }
+
+  std::vector<u32> lod_indices[MESH_MAX_LODS];
+  f32 errors[MESH_MAX_LODS];
+  u32 count = 1;
+
+  // Always simplify from the full mesh, so the errors don't pile up between LODs
+  u32 last_size = mesh->indices.size();
+  for(; count < MESH_MAX_LODS; count++) {
+    u32 target = (mesh->indices.size() >> count) / 3 * 3;
+    if(target < 3) {
+      break;
+    }
+
+    errors[count] = simplify_mesh(mesh->vertices, mesh->indices, target, &lod_indices[count]);
+    if(lod_indices[count].empty() || lod_indices[count].size() > last_size * LOD_MIN_REDUCTION) {
+      break;
+    }
+
+    last_size = lod_indices[count].size();
+  }
+
+  if(count == 1) {
+    return;
+  }
+
+  render_thread_call([mesh, &lod_indices, &errors, count]() {
+    for(u32 i = 1; i < count; i++) {
+      mesh->lods[i].index_range = add_indices(mesh, lod_indices[i]);
+      mesh->lods[i].error       = errors[i];
+    }
 
-  delete mesh;
+    mesh->lods_count = count;
+  });
 }
 /////////////////////////////////////////////////////////////////////////////////
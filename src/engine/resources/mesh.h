@@ -2,14 +2,43 @@
 
 #include "defines.h"
 #include "math/vertex.h"
+#include "graphics/geometry_arena.h"
 
 #include <glm/vec3.hpp>
+#include <glm/gtc/type_precision.hpp>
 
 #include <vector>
 
+// MeshInstance
+/////////////////////////////////////////////////////////////////////////////////
+// The per-instance data that gets streamed to the GPU for every drawn mesh. 
+// The transform is packed as a position, a quaternion, and a scale, which the 
+// vertex shader expands back into a model matrix. This keeps each instance at 
+// 36 bytes instead of a 64-byte matrix plus a 16-byte color.
+struct MeshInstance {
+  glm::vec3 position;
+  u32 color;             // RGBA8
+  glm::i16vec4 rotation; // Normalized quaternion (x, y, z, w) stored as snorm16
+  glm::vec3 scale;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
 // DEFS
 /////////////////////////////////////////////////////////////////////////////////
-#define MAX_MESH_INSTANCES 2048
+#define MESH_MAX_LODS 4
+
+// The most vertices a mesh can have and still be drawn with 16-bit indices
+#define MESH_MAX_SHORT_VERTICES 65536
+/////////////////////////////////////////////////////////////////////////////////
+
+// MeshLOD
+/////////////////////////////////////////////////////////////////////////////////
+// A simplified version of the mesh. Only the indices differ between the 
+// LODs of a mesh, so they all share the same vertices.
+struct MeshLOD {
+  GeometryRange index_range;
+  f32 error; // How far (in model space) this LOD strays from the full mesh
+};
 /////////////////////////////////////////////////////////////////////////////////
 
 // Mesh
@@ -18,16 +47,48 @@ struct Mesh {
   std::vector<Vertex3D> vertices; 
   std::vector<u32> indices;
 
-  u32 vao, vbo, ebo;
-  u32 ibo; // Instance buffer
+  u32 id; // Unique per mesh. Used to sort draws by mesh.
+
+  // Where the vertices of the mesh live in the geometry arena
+  GeometryRange vertex_range;
+
+  // LOD 0 is always the full mesh. Every LOD after it has fewer triangles than the last.
+  MeshLOD lods[MESH_MAX_LODS];
+  u32 lods_count = 1;
+
+  // Meshes with few enough vertices store their indices (in the arena) as 16-bits
+  bool has_short_indices;
 
   glm::vec3 min, max;
+
+  // What the positions in the arena have to be scaled by and offset with to get back 
+  // to model space, since packed vertices are quantized between 'min' and 'max'
+  glm::vec3 dequantize_offset, dequantize_scale;
 };
 /////////////////////////////////////////////////////////////////////////////////
 
 // Public functions
 /////////////////////////////////////////////////////////////////////////////////
 Mesh* mesh_create();
-Mesh* mesh_create(const std::vector<Vertex3D>& vertices, const std::vector<u32>& indices);
+
+// NOTE: If no indices are given, the mesh will be indexed in the order of its vertices.
+// Meshes with up to 'MESH_MAX_SHORT_VERTICES' vertices get 16-bit indices on the GPU.
+// If 'keep_geometry' is false, the CPU copy of the vertices and indices is freed as soon
+// as they are uploaded (see 'mesh_release_geometry').
+Mesh* mesh_create(const std::vector<Vertex3D>& vertices, const std::vector<u32>& indices, const bool keep_geometry = true);
+
 void mesh_destroy(Mesh* mesh);
+
+// Free the CPU copy of the vertices and indices. The mesh can still be drawn, 
+// but can not be simplified into LODs anymore.
+void mesh_release_geometry(Mesh* mesh);
+
+// How many bytes the CPU copy of the mesh's geometry takes
+const usizei mesh_get_geometry_size(const Mesh* mesh);
+
+// Simplify the mesh into as many LODs as possible (up to 'MESH_MAX_LODS'), each one
+// with about half the triangles of the one before it.
+// NOTE: Takes a while on big meshes. Should only be done while loading, and before 
+// the geometry of the mesh is released.
+void mesh_generate_lods(Mesh* mesh);
 /////////////////////////////////////////////////////////////////////////////////
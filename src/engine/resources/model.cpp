@@ -2,6 +2,7 @@
 #include "defines.h"
 #include "graphics/renderer.h"
 #include "math/vertex.h"
+#include "math/mesh_optimize.h"
 #include "resources/mesh.h"
 #include "resources/material.h"
 #include "resources/resource_manager.h"
@@ -11,9 +12,41 @@
 #include <glm/glm.hpp>
 
 #include <cstdio>
+#include <functional>
+#include <unordered_map>
 #include <vector>
 #include <string>
 
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+// How much worse the cache hit rate can get to cut down on overdraw
+#define OVERDRAW_THRESHOLD 1.05f
+/////////////////////////////////////////////////////////////////////////////////
+
+// ObjIndexKey
+/////////////////////////////////////////////////////////////////////////////////
+// The position, normal, and texture coords indices of a face corner in the OBJ file
+struct ObjIndexKey {
+  i32 vertex_index, normal_index, texcoord_index;
+
+  bool operator==(const ObjIndexKey& other) const {
+    return vertex_index == other.vertex_index && 
+           normal_index == other.normal_index && 
+           texcoord_index == other.texcoord_index;
+  }
+};
+
+struct ObjIndexHash {
+  usizei operator()(const ObjIndexKey& key) const {
+    usizei hash = std::hash<i32>()(key.vertex_index);
+    hash ^= std::hash<i32>()(key.normal_index) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<i32>()(key.texcoord_index) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+
+    return hash;
+  }
+};
+/////////////////////////////////////////////////////////////////////////////////
+
 // Private functions
 /////////////////////////////////////////////////////////////////////////////////
 static const std::vector<Material*> load_materials(const std::vector<tinyobj::material_t>& materials, const tinyobj::ObjReaderConfig& cfg) {
@@ -27,7 +60,7 @@ static const std::vector<Material*> load_materials(const std::vector<tinyobj::ma
     // Loading the diffuse texture
     std::string diff = materials[i].diffuse_texname;
     if(!diff.empty()) {
-      diffuse = texture_load(cfg.mtl_search_path + diff);
+      diffuse = texture_load_async(cfg.mtl_search_path + diff);
     }
     else {
       glm::vec4 col(materials[i].diffuse[0], materials[i].diffuse[1], materials[i].diffuse[2], materials[i].dissolve);  
@@ -37,7 +70,7 @@ static const std::vector<Material*> load_materials(const std::vector<tinyobj::ma
     // Loading the specular texture
     std::string spec = materials[i].specular_texname;
     if(!spec.empty()) {
-      specular = texture_load(cfg.mtl_search_path + spec);
+      specular = texture_load_async(cfg.mtl_search_path + spec);
     }
     else {
       glm::vec4 col(materials[i].specular[0], materials[i].specular[1], materials[i].specular[2], materials[i].dissolve);  
@@ -51,64 +84,80 @@ static const std::vector<Material*> load_materials(const std::vector<tinyobj::ma
   return mats;
 }
 
+static Vertex3D make_vertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& index) {
+  Vertex3D vert;
+
+  // Vertex position
+  tinyobj::real_t vert_x = attrib.vertices[3 * usizei(index.vertex_index) + 0]; 
+  tinyobj::real_t vert_y = attrib.vertices[3 * usizei(index.vertex_index) + 1]; 
+  tinyobj::real_t vert_z = attrib.vertices[3 * usizei(index.vertex_index) + 2];
+  vert.position = glm::vec3(vert_x, vert_y, vert_z);
+
+  // Vertex normal (if it exists)
+  if(index.normal_index >= 0) {
+    tinyobj::real_t normal_x = attrib.normals[3 * usizei(index.normal_index) + 0];
+    tinyobj::real_t normal_y = attrib.normals[3 * usizei(index.normal_index) + 1];
+    tinyobj::real_t normal_z = attrib.normals[3 * usizei(index.normal_index) + 2];
+    vert.normal = glm::vec3(normal_x, normal_y, normal_z);
+  }
+  else {
+    vert.normal = glm::vec3(0.0f);
+  }
+
+  // Vertex texture coords (if it exists)
+  if(index.texcoord_index >= 0) {
+    tinyobj::real_t u = attrib.texcoords[2 * usizei(index.texcoord_index) + 0];
+    tinyobj::real_t v = attrib.texcoords[2 * usizei(index.texcoord_index) + 1];
+    vert.texture_coords = glm::vec2(u, v);
+  } 
+  else {
+    vert.texture_coords = glm::vec2(0.0f);
+  }
+
+  return vert;
+}
+
 static void load_model_data(Model* model, const tinyobj::ObjReader& reader, const tinyobj::ObjReaderConfig cfg) {
   auto& shape = reader.GetShapes();
   auto& attrib = reader.GetAttrib();
   const auto& materials = reader.GetMaterials();
 
   model->materials = load_materials(materials, cfg); 
-  std::vector<Vertex3D> vertices;
-  std::vector<u32> indices;
 
   // Loop over the shapes
   for(u32 i = 0; i < shape.size(); i++) {
-    usizei index_offset = 0;
-
-    // Loop over the faces
-    for(u32 j = 0; j < shape[i].mesh.num_face_vertices.size(); j++) {
-      usizei face_vertex = shape[i].mesh.num_face_vertices[j];
-     
-      // Loop over the vertices in the face 
-      for(u32 x = 0; x < face_vertex; x++) {
-        Vertex3D vert;
-
-        // Index 
-        tinyobj::index_t index = shape[i].mesh.indices[index_offset + x]; 
-
-        // Vertex position
-        tinyobj::real_t vert_x = attrib.vertices[3 * usizei(index.vertex_index) + 0]; 
-        tinyobj::real_t vert_y = attrib.vertices[3 * usizei(index.vertex_index) + 1]; 
-        tinyobj::real_t vert_z = attrib.vertices[3 * usizei(index.vertex_index) + 2];
-        vert.position = glm::vec3(vert_x, vert_y, vert_z);
-
-        // Vertex normal (if it exists)
-        if(index.normal_index >= 0) {
-          tinyobj::real_t normal_x = attrib.normals[3 * usizei(index.normal_index) + 0];
-          tinyobj::real_t normal_y = attrib.normals[3 * usizei(index.normal_index) + 1];
-          tinyobj::real_t normal_z = attrib.normals[3 * usizei(index.normal_index) + 2];
-          vert.normal = glm::vec3(vert_x, vert_y, vert_z);
-        }
-        else {
-          vert.normal = glm::vec3(0.0f);
-        }
-
-        // Vertex texture coords (if it exists)
-        if(index.texcoord_index >= 0) {
-          tinyobj::real_t u = attrib.texcoords[2 * usizei(index.texcoord_index) + 0];
-          tinyobj::real_t v = attrib.texcoords[2 * usizei(index.texcoord_index) + 1];
-          vert.texture_coords = glm::vec2(u, v);
-        } 
-        else {
-          vert.texture_coords = glm::vec2(0.0f);
-        }
-
-        // New vertex
-        vertices.push_back(vert);
+    std::vector<Vertex3D> vertices;
+    std::vector<u32> indices;
+    indices.reserve(shape[i].mesh.indices.size());
+
+    // Face corners that share the same position, normal, and texture coords all become the same vertex
+    std::unordered_map<ObjIndexKey, u32, ObjIndexHash> unique_vertices;
+    unique_vertices.reserve(shape[i].mesh.indices.size());
+
+    // Every face is a triangle, since the reader triangulates them
+    for(auto& index : shape[i].mesh.indices) {
+      ObjIndexKey key = {index.vertex_index, index.normal_index, index.texcoord_index};
+
+      auto found = unique_vertices.find(key);
+      if(found != unique_vertices.end()) {
+        indices.push_back(found->second);
+        continue;
       }
 
-      // Advance to the next vertices
-      index_offset += face_vertex;
+      // New vertex
+      u32 vertex_index = vertices.size();
+      unique_vertices[key] = vertex_index;
+
+      vertices.push_back(make_vertex(attrib, index));
+      indices.push_back(vertex_index);
     }
+
+    // Make the most out of the post-transform cache, draw the outside of the mesh 
+    // first to cut down on overdraw, and then lay the vertices out in the order they are used
+    std::vector<u32> clusters;
+    optimize_vertex_cache(&indices, vertices.size(), &clusters);
+    optimize_overdraw(vertices, &indices, clusters, OVERDRAW_THRESHOLD);
+    optimize_vertex_fetch(&vertices, &indices);
   
     /*
     * NOTE: This ID will be used when rendering the model. Each mesh needs a specific 
@@ -121,7 +170,13 @@ static void load_model_data(Model* model, const tinyobj::ObjReader& reader, cons
     i32 id = shape[i].mesh.material_ids[i % shape[i].mesh.num_face_vertices.size()];
     
     model->material_ids.push_back(id);
-    model->meshes.push_back(mesh_create(vertices, indices));
+    Mesh* mesh = mesh_create(vertices, indices);
+    mesh_generate_lods(mesh);
+
+    // Nothing needs the geometry on the CPU after this
+    mesh_release_geometry(mesh);
+
+    model->meshes.push_back(mesh);
   }
 }
 /////////////////////////////////////////////////////////////////////////////////
@@ -153,7 +208,7 @@ void model_unload(Model* model) {
   for(auto& mesh : model->meshes) {
     mesh_destroy(mesh);
   }
-  model->materials.clear();
+  model->meshes.clear();
 
   for(auto& mat : model->materials) {
     material_unload(mat);
@@ -6,13 +6,30 @@
 #include "resources/model.h"
 #include "resources/texture.h"
 #include "resources/font.h"
+#include "graphics/geometry_arena.h"
+#include "graphics/gpu_memory.h"
+#include "graphics/render_thread.h"
 #include "math/vertex.h"
 #include "defines.h"
 
+#include <cstdio>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+// SharedResource
+/////////////////////////////////////////////////////////////////////////////////
+struct SharedResource {
+  std::string id;
+  u32 ref_count; 
+  bool is_held; // The manager holds one of the references itself (see 'add_mesh_ref')
+
+  // The size of the geometry a mesh was acquired with (see 'is_same_geometry')
+  usizei vertices_count = 0; 
+  usizei indices_count  = 0;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
 // ResourceManager
 /////////////////////////////////////////////////////////////////////////////////
 struct ResourceManager {
@@ -25,6 +42,10 @@ struct ResourceManager {
   std::unordered_map<std::string, Material*> materials;
   std::unordered_map<std::string, Model*> models;
   std::unordered_map<std::string, CubeMap*> cubemaps;
+
+  // The references to every mesh and model that was acquired at least once
+  std::unordered_map<Mesh*, SharedResource> shared_meshes;
+  std::unordered_map<Model*, SharedResource> shared_models;
 };
 
 static ResourceManager s_res_man;
@@ -87,6 +108,56 @@ static CubeMap* find_cubemap(const std::string& id) {
 
   return nullptr;
 }
+
+// FNV-1a
+static u64 hash_bytes(const void* data, const usizei size, u64 hash) {
+  const u8* bytes = (const u8*)data;
+  for(usizei i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3;
+  }
+
+  return hash;
+}
+
+static std::string hash_geometry(const std::vector<Vertex3D>& vertices, const std::vector<u32>& indices) {
+  u64 hash = 0xcbf29ce484222325;
+  hash = hash_bytes(vertices.data(), sizeof(Vertex3D) * vertices.size(), hash);
+  hash = hash_bytes(indices.data(), sizeof(u32) * indices.size(), hash);
+
+  char id[32];
+  snprintf(id, sizeof(id), "#mesh-%016llx", (unsigned long long)hash);
+
+  return id;
+}
+
+// Two different pieces of geometry can end up with the same hash. The sizes tell most of them apart.
+static bool is_same_geometry(Mesh* mesh, const std::vector<Vertex3D>& vertices, const std::vector<u32>& indices) {
+  auto it = s_res_man.shared_meshes.find(mesh);
+  if(it == s_res_man.shared_meshes.end()) {
+    return false;
+  }
+
+  return it->second.vertices_count == vertices.size() && it->second.indices_count == indices.size();
+}
+
+// Resources that were already in the manager before they were first acquired are 
+// also held by the manager itself, so they never get unloaded by a release
+static void add_mesh_ref(Mesh* mesh, const std::string& id, const bool is_new) {
+  if(s_res_man.shared_meshes.find(mesh) == s_res_man.shared_meshes.end()) {
+    s_res_man.shared_meshes[mesh] = SharedResource{id, is_new ? 0u : 1u, !is_new};
+  }
+
+  s_res_man.shared_meshes[mesh].ref_count++;
+}
+
+static void add_model_ref(Model* model, const std::string& id, const bool is_new) {
+  if(s_res_man.shared_models.find(model) == s_res_man.shared_models.end()) {
+    s_res_man.shared_models[model] = SharedResource{id, is_new ? 0u : 1u, !is_new};
+  }
+
+  s_res_man.shared_models[model].ref_count++;
+}
 /////////////////////////////////////////////////////////////////////////////////
 
 // Public functions
@@ -111,10 +182,32 @@ void resources_shutdown() {
   }
   s_res_man.fonts.clear();
   
+  // Shared meshes that were removed while someone still held them are not in the map anymore
+  for(auto& [mesh, shared] : s_res_man.shared_meshes) {
+    auto it = s_res_man.meshes.find(shared.id);
+    if(it == s_res_man.meshes.end() || it->second != mesh) {
+      mesh_destroy(mesh);
+    }
+  }
+
   for(auto& [key, value] : s_res_man.meshes) {
     mesh_destroy(value);
   }
   s_res_man.meshes.clear();
+  s_res_man.shared_meshes.clear();
+
+  for(auto& [model, shared] : s_res_man.shared_models) {
+    auto it = s_res_man.models.find(shared.id);
+    if(it == s_res_man.models.end() || it->second != model) {
+      model_unload(model);
+    }
+  }
+
+  for(auto& [key, value] : s_res_man.models) {
+    model_unload(value);
+  }
+  s_res_man.models.clear();
+  s_res_man.shared_models.clear();
   
   for(auto& [key, value] : s_res_man.materials) {
     material_unload(value);
@@ -130,14 +223,21 @@ Shader* resources_add_shader(const std::string& id, const std::string& path) {
 }
 
 Shader* resources_add_shader(const std::string& id, const std::string& shader_name, const std::string& shader_code) {
-  s_res_man.shaders[id] = shader_load(shader_name, shader_code);
+  s_res_man.shaders[id] = shader_load_async(shader_name, shader_code);
   return s_res_man.shaders[id];
 }
 
-Texture* resources_add_texture(const std::string& id, const std::string& path) {
+Texture* resources_add_texture(const std::string& id, const std::string& path, const bool keep_pixels) {
   std::string full_path = s_res_man.res_path + path; 
   
-  s_res_man.textures[id] = texture_load(full_path);
+  s_res_man.textures[id] = texture_load(full_path, keep_pixels);
+  return s_res_man.textures[id];
+}
+
+Texture* resources_add_texture_async(const std::string& id, const std::string& path) {
+  std::string full_path = s_res_man.res_path + path; 
+  
+  s_res_man.textures[id] = texture_load_async(full_path);
   return s_res_man.textures[id];
 }
 
@@ -154,11 +254,21 @@ Font* resources_add_font(const std::string& path, const std::string& id) {
 }
 
 Mesh* resources_add_mesh(const std::string& id) {
+  Mesh* mesh = find_mesh(id);
+  if(mesh) {
+    return mesh;
+  }
+
   s_res_man.meshes[id] = mesh_create();
   return s_res_man.meshes[id];
 }
 
 Mesh* resources_add_mesh(const std::string& id, const std::vector<Vertex3D>& vertices, const std::vector<u32>& indices) {
+  Mesh* mesh = find_mesh(id);
+  if(mesh) {
+    return mesh;
+  }
+
   s_res_man.meshes[id] = mesh_create(vertices, indices);
   return s_res_man.meshes[id];
 }
@@ -172,6 +282,11 @@ Material* resources_add_material(const std::string& id,
 }
 
 Model* resources_add_model(const std::string& id, const std::string& path) {
+  Model* model = find_model(id);
+  if(model) {
+    return model;
+  }
+
   std::string full_path = s_res_man.res_path + path; 
 
   s_res_man.models[id] = model_load(full_path);
@@ -185,6 +300,108 @@ CubeMap* resources_add_cubemap(const std::string& id, const std::string& path) {
   return s_res_man.cubemaps[id];
 }
 
+Mesh* resources_acquire_mesh(const std::string& id) {
+  Mesh* mesh = find_mesh(id);
+  bool is_new = false;
+
+  // The built-in meshes are only created once someone needs them
+  if(!mesh && id == RESOURCES_MESH_CUBE) {
+    mesh = mesh_create();
+    s_res_man.meshes[id] = mesh;
+    is_new = true;
+  }
+
+  if(!mesh) {
+    fprintf(stderr, "[WARNING]: Could not acquire mesh \'%s\'\n", id.c_str());
+    return nullptr;
+  }
+
+  add_mesh_ref(mesh, id, is_new);
+  return mesh;
+}
+
+Mesh* resources_acquire_mesh(const std::vector<Vertex3D>& vertices, const std::vector<u32>& indices) {
+  std::string hash_id = hash_geometry(vertices, indices);
+  std::string id      = hash_id;
+
+  // A collision gets the next free id after the hash
+  Mesh* mesh = find_mesh(id);
+  for(u32 i = 1; mesh && !is_same_geometry(mesh, vertices, indices); i++) {
+    id   = hash_id + "-" + std::to_string(i);
+    mesh = find_mesh(id);
+  }
+
+  bool is_new = !mesh;
+  if(is_new) {
+    mesh = mesh_create(vertices, indices);
+    s_res_man.meshes[id] = mesh;
+  }
+
+  add_mesh_ref(mesh, id, is_new);
+  if(is_new) {
+    s_res_man.shared_meshes[mesh].vertices_count = vertices.size();
+    s_res_man.shared_meshes[mesh].indices_count  = indices.size();
+  }
+
+  return mesh;
+}
+
+Model* resources_acquire_model(const std::string& path) {
+  // Kept apart from the ids of added models, so a path never hands out (or replaces) one of them
+  std::string id = "#model-" + path;
+
+  Model* model = find_model(id);
+  bool is_new = !model;
+  if(is_new) {
+    model = model_load(s_res_man.res_path + path);
+    s_res_man.models[id] = model;
+  }
+
+  add_model_ref(model, id, is_new);
+  return model;
+}
+
+void resources_release_mesh(Mesh* mesh) {
+  auto shared = s_res_man.shared_meshes.find(mesh);
+  if(shared == s_res_man.shared_meshes.end()) {
+    return;
+  }
+
+  shared->second.ref_count--;
+  if(shared->second.ref_count > 0) {
+    return;
+  }
+
+  // Nobody holds it anymore. The id might have been removed (and even reused) already.
+  auto it = s_res_man.meshes.find(shared->second.id);
+  if(it != s_res_man.meshes.end() && it->second == mesh) {
+    s_res_man.meshes.erase(it);
+  }
+
+  s_res_man.shared_meshes.erase(shared);
+  mesh_destroy(mesh);
+}
+
+void resources_release_model(Model* model) {
+  auto shared = s_res_man.shared_models.find(model);
+  if(shared == s_res_man.shared_models.end()) {
+    return;
+  }
+
+  shared->second.ref_count--;
+  if(shared->second.ref_count > 0) {
+    return;
+  }
+
+  auto it = s_res_man.models.find(shared->second.id);
+  if(it != s_res_man.models.end() && it->second == model) {
+    s_res_man.models.erase(it);
+  }
+
+  s_res_man.shared_models.erase(shared);
+  model_unload(model);
+}
+
 Shader* resources_get_shader(const std::string& id) {
   return find_shader(id);
 }
@@ -213,6 +430,55 @@ CubeMap* resources_get_cubemap(const std::string& id) {
   return find_cubemap(id);
 }
 
+void resources_memory_report() {
+  const f64 mib = 1024.0 * 1024.0;
+
+  usizei textures_size = 0;
+  for(auto& [key, value] : s_res_man.textures) {
+    textures_size += value->gpu_size;
+  }
+
+  usizei cubemaps_size = 0;
+  for(auto& [key, value] : s_res_man.cubemaps) {
+    cubemaps_size += value->gpu_size;
+  }
+
+  usizei meshes_size = 0;
+  for(auto& [key, value] : s_res_man.meshes) {
+    meshes_size += mesh_get_geometry_size(value);
+  }
+
+  usizei models_size = 0;
+  for(auto& [key, value] : s_res_man.models) {
+    for(auto& mesh : value->meshes) {
+      models_size += mesh_get_geometry_size(mesh);
+    }
+  }
+
+  GeometryArenaStats arena;
+  render_thread_call([&arena]() {
+    arena = geometry_arena_get_stats();
+  });
+
+  printf("[INFO]: Resources memory report\n");
+  
+  printf("  GPU:\n");
+  for(u32 i = 0; i < GPU_MEMORY_TYPES_MAX; i++) {
+    printf("    %-16s %8.2fMiB\n", gpu_memory_type_str((GPUMemoryType)i), gpu_memory_get((GPUMemoryType)i) / mib);
+  }
+  printf("    %-16s %8.2fMiB (peak %.2fMiB)\n", "Total", gpu_memory_get_total() / mib, gpu_memory_get_peak() / mib);
+
+  printf("  Geometry arena:\n");
+  printf("    %-16s %8.2fMiB of %.2fMiB\n", "Vertices", arena.vertices_used / mib, arena.vertices_capacity / mib);
+  printf("    %-16s %8.2fMiB of %.2fMiB\n", "Indices", arena.indices_used / mib, arena.indices_capacity / mib);
+
+  printf("  Resources:\n");
+  printf("    %-16s %8.2fMiB GPU (%zu)\n", "Textures", textures_size / mib, s_res_man.textures.size());
+  printf("    %-16s %8.2fMiB GPU (%zu)\n", "Cubemaps", cubemaps_size / mib, s_res_man.cubemaps.size());
+  printf("    %-16s %8.2fMiB CPU (%zu)\n", "Meshes", meshes_size / mib, s_res_man.meshes.size());
+  printf("    %-16s %8.2fMiB CPU (%zu)\n", "Models", models_size / mib, s_res_man.models.size());
+}
+
 bool resources_remove_shader(const std::string& id) {
   Shader* shader = find_shader(id);
   if(shader) {
@@ -252,14 +518,26 @@ bool resources_remove_font(const std::string& id) {
 
 bool resources_remove_mesh(const std::string& id) {
   Mesh* mesh = find_mesh(id);
-  if(mesh) {
-    mesh_destroy(mesh);
-    s_res_man.fonts.erase(id);
-    
+  if(!mesh) {
+    return false;
+  }
+
+  s_res_man.meshes.erase(id);
+
+  // Shared meshes only lose the manager's own reference. Whoever acquired 
+  // it keeps it, and the last one to release it unloads it.
+  auto shared = s_res_man.shared_meshes.find(mesh);
+  if(shared != s_res_man.shared_meshes.end()) {
+    if(shared->second.is_held) {
+      shared->second.is_held = false;
+      resources_release_mesh(mesh);
+    }
+
     return true;
   }
 
-  return false;
+  mesh_destroy(mesh);
+  return true;
 }
 
 bool resources_remove_material(const std::string& id) {
@@ -276,14 +554,25 @@ bool resources_remove_material(const std::string& id) {
 
 bool resources_remove_model(const std::string& id) {
   Model* model = find_model(id);
-  if(model) {
-    model_unload(model);
-    s_res_man.models.erase(id);
-    
+  if(!model) {
+    return false;
+  }
+
+  s_res_man.models.erase(id);
+
+  // Same as meshes. Only the manager's own reference goes away.
+  auto shared = s_res_man.shared_models.find(model);
+  if(shared != s_res_man.shared_models.end()) {
+    if(shared->second.is_held) {
+      shared->second.is_held = false;
+      resources_release_model(model);
+    }
+
     return true;
   }
 
-  return false;
+  model_unload(model);
+  return true;
 }
 
 bool resources_remove_cubemap(const std::string& id) {
@@ -12,6 +12,12 @@
 #include <string>
 #include <vector>
 
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+// The ID of the built-in unit cube mesh
+#define RESOURCES_MESH_CUBE "cube"
+/////////////////////////////////////////////////////////////////////////////////
+
 // Public functions
 /////////////////////////////////////////////////////////////////////////////////
 // The initial initialization of the resource manager. The given 'res_path' will be 
@@ -30,10 +36,20 @@ void resources_shutdown();
 // NOTE: The path that is passed to the functions should omit the initial resource path, as 
 // that is given initially when the resource manager is initialized. For example, if a texture is 
 // at "res/textures/texture.png" then the "res/" should be removed. Therefore, it should be "textures/texture.png".
+//
+// NOTE: Meshes and models are only ever created once per ID. Adding one with an ID that 
+// already exists just returns the existing one.
 Shader* resources_add_shader(const std::string& id, const std::string& path);
+
+// NOTE: Shaders added from code are compiled asynchronously. See 'shader_load_async'.
 Shader* resources_add_shader(const std::string& id, const std::string& shader_name, const std::string& shader_code);
-Texture* resources_add_texture(const std::string& id, const std::string& path);
+
+// NOTE: See 'texture_load' for 'keep_pixels'
+Texture* resources_add_texture(const std::string& id, const std::string& path, const bool keep_pixels = false);
 Texture* resources_add_texture(const std::string& id, i32 width, i32 height, TextureFormat format, void* pixels);
+
+// NOTE: See 'texture_load_async'. The texture can be used right away, but is a placeholder until it is ready.
+Texture* resources_add_texture_async(const std::string& id, const std::string& path);
 Font* resources_add_font(const std::string& path, const std::string& id);
 Mesh* resources_add_mesh(const std::string& id);
 Mesh* resources_add_mesh(const std::string& id, const std::vector<Vertex3D>& vertices, const std::vector<u32>& indices);
@@ -52,12 +68,40 @@ Material* resources_get_material(const std::string& id);
 Model* resources_get_model(const std::string& id);
 CubeMap* resources_get_cubemap(const std::string& id);
 
+// Sharing resources
+// The following functions hand out a mesh or a model that is shared between everyone who 
+// acquires it, and only create (or load) it the first time. Each call adds a reference to 
+// the resource, which has to be given back with the matching 'resources_release_*' function. 
+// The resource gets unloaded once its last reference is released.
+//
+// NOTE: Resources that were added with a 'resources_add_*' function are kept by the manager 
+// until it shuts down (or they get removed), even if every reference to them is released.
+
+// Acquire a mesh that was already added, or a built-in one (like 'RESOURCES_MESH_CUBE').
+// Returns a 'nullptr' if there is no such mesh.
+Mesh* resources_acquire_mesh(const std::string& id);
+
+// Acquire a mesh made out of the given geometry. Meshes with the exact same vertices and indices are shared.
+Mesh* resources_acquire_mesh(const std::vector<Vertex3D>& vertices, const std::vector<u32>& indices);
+
+// Acquire the model at the given path. Every model is only loaded once per path.
+Model* resources_acquire_model(const std::string& path);
+
+void resources_release_mesh(Mesh* mesh);
+void resources_release_model(Model* model);
+
+// Print how much memory every resource type takes on the GPU and the CPU, along 
+// with the GPU memory the engine itself allocated (like the geometry arena and render targets)
+void resources_memory_report();
+
 // Removing resources
 // Removes the specified resource from the resource manager's map. 
 // These functions will return a 'true' if the resource is found and successfully removed 
 // and 'false' otherwise. 
 // NOTE: These functions also unload the resources before removing the resource from the manager. 
 // Therefore, please do be careful when using these functions.
+// NOTE: Meshes and models that were acquired (see 'resources_acquire_*') are the exception. Removing 
+// them only drops the manager's own reference, and they get unloaded once the last reference is released.
 bool resources_remove_shader(const std::string& id);
 bool resources_remove_texture(const std::string& id);
 bool resources_remove_font(const std::string& id);
@@ -1,15 +1,54 @@
 #include "texture.h"
 #include "defines.h"
+#include "graphics/gl_state.h"
+#include "graphics/gpu_memory.h"
+#include "graphics/render_thread.h"
+#include "graphics/texture_residency.h"
+#include "resources/texture_cooker.h"
+#include "resources/texture_file.h"
+#include "core/thread_pool.h"
+#include "utils/utils_file.h"
 
 #include <stb_image/stb_image.h>
 #include <glad/gl.h>
+#include <glm/glm.hpp>
 
 #include <string>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
 
-// Globals
+// TextureUpload
 /////////////////////////////////////////////////////////////////////////////////
-static u64 texture_slots = 0;
+// A texture that is being loaded with 'texture_load_async' or streamed with 'texture_stream'. The workers only ever touch
+// the decoded pixels in here, never the texture itself.
+struct TextureUpload {
+  Texture* texture; // 'nullptr' if the texture got unloaded before the upload was done
+  std::string path;
+  u32 mip; // How many times the image gets halved after decoding
+
+  u8* pixels = nullptr;
+  i32 width, height, channels;
+  i32 full_width, full_height;
+
+  bool is_decoded = false;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// TextureUploads
+/////////////////////////////////////////////////////////////////////////////////
+struct TextureUploads {
+  std::mutex mutex;
+  std::vector<TextureUpload*> pending; // In the order they were loaded
+
+  // The pixel unpack buffer every upload goes through. Owned by the render thread.
+  u32 pbo         = 0;
+  usizei pbo_size = 0;
+};
+
+static TextureUploads s_uploads;
 /////////////////////////////////////////////////////////////////////////////////
 
 // Private functions
@@ -34,108 +73,494 @@ i32 get_channels_by_format(TextureFormat format) {
 
   return channels;
 }
+
+static TextureFormat get_format_by_channels(const i32 channels) {
+  switch(channels) {
+    case 1:
+      return TEXTURE_FORMAT_RED;
+    case 2:
+      return TEXTURE_FORMAT_RG;
+    case 3:
+      return TEXTURE_FORMAT_RGB;
+    default:
+      return TEXTURE_FORMAT_RGBA;
+  }
+}
+
+// NOTE: Runs on one of the thread pool's workers
+static void decode_upload(TextureUpload* upload) {
+  // The flip is global by default. Setting it per thread keeps the workers out of each other's way.
+  stbi_set_flip_vertically_on_load_thread(true);
+
+  i32 width, height, channels;
+  u8* pixels = stbi_load(upload->path.c_str(), &width, &height, &channels, 0);
+  if(!pixels) {
+    fprintf(stderr, "[ERROR]: Failed to load texture at \'%s\'\n", upload->path.c_str());
+  }
+
+  i32 full_width  = width;
+  i32 full_height = height;
+  for(u32 i = 0; pixels && i < upload->mip; i++) {
+    u8* half = texture_downsample(pixels, width, height, channels, &width, &height);
+    stbi_image_free(pixels);
+    pixels = half;
+  }
+
+  std::lock_guard<std::mutex> lock(s_uploads.mutex);
+  upload->pixels      = pixels;
+  upload->width       = width;
+  upload->height      = height;
+  upload->channels    = channels;
+  upload->full_width  = full_width;
+  upload->full_height = full_height;
+  upload->is_decoded  = true;
+}
+
+// NOTE: Must be called from the render thread
+static void push_upload(Texture* texture, const u32 mip) {
+  TextureUpload* upload = new TextureUpload{};
+  upload->texture = texture;
+  upload->path    = texture->path;
+  upload->mip     = mip;
+
+  texture->requested_mip = mip;
+
+  {
+    std::lock_guard<std::mutex> lock(s_uploads.mutex);
+    s_uploads.pending.push_back(upload);
+  }
+
+  thread_pool_push([upload]() {
+    decode_upload(upload);
+  });
+}
+
+// NOTE: Must be called from the render thread
+static void upload_pixels(Texture* texture, const u8* pixels, const usizei size) {
+  if(s_uploads.pbo == 0) {
+    glGenBuffers(1, &s_uploads.pbo);
+  }
+
+  // Orphaning the buffer means the copy never has to wait on the GPU to be done with the last upload
+  gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, s_uploads.pbo);
+  glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+
+  gpu_memory_free(GPU_MEMORY_STREAMING, s_uploads.pbo_size);
+  gpu_memory_alloc(GPU_MEMORY_STREAMING, size);
+  s_uploads.pbo_size = size;
+
+  // With a pixel unpack buffer bound, the pointer given to 'glTexImage2D' is an offset into it
+  const void* source = nullptr;
+  void* dest = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  if(dest) {
+    memcpy(dest, pixels, size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+  }
+  else {
+    fprintf(stderr, "[WARNING]: Could not map the texture upload buffer. Uploading directly instead\n");
+
+    gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    source = pixels;
+  }
+
+  gl_state_bind_texture(GL_TEXTURE_2D, texture->id);
+
+  // The rows are tightly packed. Odd-width RGB images (and their downsampled mips) are not a multiple of 4 bytes.
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, texture->depth, GL_RGBA, texture->width, texture->height, 0, texture->format, GL_UNSIGNED_BYTE, source);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  glGenerateMipmap(GL_TEXTURE_2D);
+  gl_state_bind_texture(GL_TEXTURE_2D, 0);
+
+  // Every other upload passes its pixels directly
+  gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+// Returns the cooked version of 'path', if there is one and the driver can use it
+static TextureFile* open_cooked(const std::string& path) {
+  std::string cooked_path = texture_file_is_cooked(path) ? path : texture_file_get_cooked_path(path);
+  if(!file_exists(cooked_path)) {
+    return nullptr;
+  }
+
+  TextureFile* file = new TextureFile{};
+  if(!texture_file_open(cooked_path, file)) {
+    delete file;
+    return nullptr;
+  }
+
+  TextureFileFormat format = (TextureFileFormat)file->header->format;
+  if(file->header->faces_count != 1 || !texture_file_is_supported(format)) {
+    fprintf(stderr, "[WARNING]: Cannot use cooked texture \'%s\' (%s). Loading the original instead\n", 
+            cooked_path.c_str(), 
+            texture_file_format_str(format));
+
+    texture_file_close(file);
+    delete file;
+    return nullptr;
+  }
+
+  return file;
+}
+
+// Replace the whole texture with the cooked mips, starting at 'mip'
+// NOTE: Must be called from the render thread
+static void upload_cooked(Texture* texture, const u32 mip) {
+  const TextureFile* file = texture->cooked;
+  u32 first_mip           = glm::min(mip, file->header->mips_count - 1);
+
+  texture->width        = texture_file_get_mip_width(file, first_mip);
+  texture->height       = texture_file_get_mip_height(file, first_mip);
+  texture->resident_mip = first_mip;
+
+  gl_state_bind_texture(GL_TEXTURE_2D, texture->id);
+  usizei size = texture_file_upload(file, GL_TEXTURE_2D, 0, first_mip);
+
+  // Levels from a bigger mip that was resident before are left behind, and should never be sampled
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, file->header->mips_count - first_mip - 1);
+  gl_state_bind_texture(GL_TEXTURE_2D, 0);
+
+  gpu_memory_free(GPU_MEMORY_TEXTURES, texture->gpu_size);
+  texture->gpu_size = size;
+  gpu_memory_alloc(GPU_MEMORY_TEXTURES, texture->gpu_size);
+
+  texture->requested_mip = texture->resident_mip;
+}
+
+// NOTE: Must be called from the render thread
+static void finish_upload(TextureUpload* upload) {
+  Texture* texture = upload->texture;
+  if(texture && upload->pixels) {
+    texture->width    = upload->width;
+    texture->height   = upload->height;
+    texture->channels = upload->channels;
+    texture->format   = get_format_by_channels(upload->channels);
+
+    texture->full_width   = upload->full_width;
+    texture->full_height  = upload->full_height;
+    texture->resident_mip = upload->mip;
+
+    usizei size = (usizei)upload->width * upload->height * upload->channels;
+    upload_pixels(texture, upload->pixels, size);
+
+    // The placeholder (or the last mip) goes away, and is replaced by the new one (always stored as RGBA)
+    gpu_memory_free(GPU_MEMORY_TEXTURES, texture->gpu_size);
+    texture->gpu_size = gpu_memory_texture_size(texture->width, texture->height, 4, true);
+    gpu_memory_alloc(GPU_MEMORY_TEXTURES, texture->gpu_size);
+  }
+
+  // Textures that failed to load stay as they were
+  if(texture) {
+    texture->requested_mip = texture->resident_mip;
+    texture->is_ready      = true;
+  }
+
+  stbi_image_free(upload->pixels);
+  delete upload;
+}
 /////////////////////////////////////////////////////////////////////////////////
 
 // Public functions
 /////////////////////////////////////////////////////////////////////////////////
-Texture* texture_load(const std::string& path) {
+Texture* texture_load(const std::string& path, const bool keep_pixels) {
   Texture* texture = new Texture{};
-  texture->id    = 0; 
-  texture->depth = 0;
-  texture->slot  = texture_slots++;
+  texture->id      = 0; 
+  texture->depth   = 0;
+  texture->sampler = SAMPLER_LINEAR_MIPMAP_REPEAT;
+  texture->path    = path;
+
+  // Cooked textures go to the GPU as they are in the file, without decoding anything
+  texture->cooked = keep_pixels ? nullptr : open_cooked(path);
+  if(texture->cooked) {
+    texture->full_width  = texture->cooked->header->width;
+    texture->full_height = texture->cooked->header->height;
+    texture->channels    = 4;
+    texture->format      = TEXTURE_FORMAT_RGBA;
+
+    render_thread_call([texture]() {
+      glGenTextures(1, &texture->id);
+      upload_cooked(texture, 0);
+
+      texture_residency_add(texture);
+    });
 
-  glGenTextures(1, &texture->id);
-  glBindTexture(GL_TEXTURE_2D, texture->id);
+    return texture;
+  }
 
+  // Decode on the calling thread. Only the upload needs the render thread.
   stbi_set_flip_vertically_on_load(true);
   texture->pixels = stbi_load(path.c_str(), &texture->width, &texture->height, &texture->channels, 0);
   if(texture->pixels) {
     // Deduce the correct format based on the channels
-    switch(texture->channels) {
-      case 1:
-        texture->format = TEXTURE_FORMAT_RED;
-        break;
-      case 2:
-        texture->format = TEXTURE_FORMAT_RG;
-        break;
-      case 3:
-        texture->format = TEXTURE_FORMAT_RGB;
-        break;
-      case 4:
-        texture->format = TEXTURE_FORMAT_RGBA;
-        break;
-    } 
-
-    // Send the pixel data to the GPU and generate a mipmap
-    glTexImage2D(GL_TEXTURE_2D, texture->depth, GL_RGBA, texture->width, texture->height, 0, texture->format, GL_UNSIGNED_BYTE, texture->pixels);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    texture->format      = get_format_by_channels(texture->channels);
+    texture->full_width  = texture->width;
+    texture->full_height = texture->height;
   }
   // Couldn't load the texture
   else {
     fprintf(stderr, "[ERROR]: Failed to load texture at \'%s\'\n", path.c_str());
   }
- 
-  // Setting texture options
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-  glBindTexture(GL_TEXTURE_2D, 0);
+  render_thread_call([texture, keep_pixels]() {
+    glGenTextures(1, &texture->id);
+    gl_state_bind_texture(GL_TEXTURE_2D, texture->id);
+
+    // Send the pixel data to the GPU and generate a mipmap
+    if(texture->pixels) {
+      glTexImage2D(GL_TEXTURE_2D, texture->depth, GL_RGBA, texture->width, texture->height, 0, texture->format, GL_UNSIGNED_BYTE, texture->pixels);
+      glGenerateMipmap(GL_TEXTURE_2D);
+
+      // Always stored as RGBA
+      texture->gpu_size = gpu_memory_texture_size(texture->width, texture->height, 4, true);
+      gpu_memory_alloc(GPU_MEMORY_TEXTURES, texture->gpu_size);
+
+      if(!keep_pixels) {
+        texture_residency_add(texture);
+      }
+    }
+
+    gl_state_bind_texture(GL_TEXTURE_2D, 0);
+  });
+
+  if(!keep_pixels) {
+    stbi_image_free(texture->pixels);
+    texture->pixels = nullptr;
+  }
+
   return texture;
 }
 
-Texture* texture_load(i32 width, i32 height, TextureFormat format, void* pixels) {
+Texture* texture_load(i32 width, i32 height, TextureFormat format, void* pixels, const bool has_mipmaps) {
   Texture* texture  = new Texture{};
   texture->id       = 0; 
   texture->width    = width;
   texture->height   = height;
   texture->depth    = 0;
-  texture->slot     = texture_slots++;
+  texture->sampler  = SAMPLER_LINEAR_CLAMP;
   texture->channels = get_channels_by_format(format);
   texture->format   = format;
 
-  glGenTextures(1, &texture->id);
-  glBindTexture(GL_TEXTURE_2D, texture->id);
+  render_thread_call([texture, pixels, has_mipmaps]() {
+    glGenTextures(1, &texture->id);
+    gl_state_bind_texture(GL_TEXTURE_2D, texture->id);
 
-  if(pixels) {
-    // Send the pixel data to the GPU and generate a mipmap
-    glTexImage2D(GL_TEXTURE_2D, texture->depth, texture->format, texture->width, texture->height, 0, texture->format, GL_UNSIGNED_BYTE, pixels);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    if(pixels) {
+      // Send the pixel data to the GPU and generate a mipmap
+      glTexImage2D(GL_TEXTURE_2D, texture->depth, texture->format, texture->width, texture->height, 0, texture->format, GL_UNSIGNED_BYTE, pixels);
+      if(has_mipmaps) {
+        glGenerateMipmap(GL_TEXTURE_2D);
+      }
+      else {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+      }
+
+      texture->gpu_size = gpu_memory_texture_size(texture->width, texture->height, texture->channels, has_mipmaps);
+      gpu_memory_alloc(GPU_MEMORY_TEXTURES, texture->gpu_size);
+    }
+    // Couldn't load the texture
+    else {
+      fprintf(stderr, "[ERROR]: Given pixels not valid for texture\n");
+    }
+
+    gl_state_bind_texture(GL_TEXTURE_2D, 0);
+  });
+
+  return texture;
+}
+
+Texture* texture_load_async(const std::string& path) {
+  if(texture_file_is_cooked(path) || file_exists(texture_file_get_cooked_path(path))) {
+    return texture_load(path);
   }
-  // Couldn't load the texture
-  else {
-    fprintf(stderr, "[ERROR]: Given pixels not valid for texture\n");
-  }
- 
-  // Setting texture options
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
- 
-  glBindTexture(GL_TEXTURE_2D, 0);
+
+  Texture* texture  = new Texture{};
+  texture->id       = 0; 
+  texture->width    = 1;
+  texture->height   = 1;
+  texture->depth    = 0;
+  texture->channels = 4;
+  texture->format   = TEXTURE_FORMAT_RGBA;
+  texture->sampler  = SAMPLER_LINEAR_MIPMAP_REPEAT;
+  texture->is_ready = false;
+  texture->path     = path;
+
+  // The placeholder is a single level, so it is already complete for the mipmapped sampler
+  render_thread_call([texture]() {
+    u32 placeholder = 0xffffffff;
+
+    glGenTextures(1, &texture->id);
+    gl_state_bind_texture(GL_TEXTURE_2D, texture->id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &placeholder);
+    gl_state_bind_texture(GL_TEXTURE_2D, 0);
+
+    texture->gpu_size = gpu_memory_texture_size(1, 1, 4, false);
+    gpu_memory_alloc(GPU_MEMORY_TEXTURES, texture->gpu_size);
+
+    texture_residency_add(texture);
+    push_upload(texture, 0);
+  });
+
   return texture;
 }
 
+const bool texture_is_ready(Texture* texture) {
+  return texture->is_ready;
+}
+
+const usizei texture_flush_uploads() {
+  std::vector<TextureUpload*> decoded;
+  usizei uploaded = 0;
+
+  // Only grab the uploads here. The workers should not have to wait on the actual uploading.
+  {
+    std::lock_guard<std::mutex> lock(s_uploads.mutex);
+
+    for(auto it = s_uploads.pending.begin(); it != s_uploads.pending.end();) {
+      TextureUpload* upload = *it;
+      if(!upload->is_decoded) {
+        it++;
+        continue;
+      }
+
+      usizei size = upload->pixels ? (usizei)upload->width * upload->height * upload->channels : 0;
+      if(uploaded > 0 && uploaded + size > TEXTURE_UPLOAD_BUDGET) {
+        break;
+      }
+
+      uploaded += size;
+      decoded.push_back(upload);
+      it = s_uploads.pending.erase(it);
+    }
+  }
+
+  for(auto& upload : decoded) {
+    finish_upload(upload);
+  }
+
+  return uploaded;
+}
+
+const bool texture_stream(Texture* texture, const u32 mip) {
+  // The pixels that were kept have to match the size of the texture
+  if(texture->path.empty() || texture->pixels || !texture->is_ready) {
+    return false;
+  }
+
+  // Only one mip can be on its way at a time
+  if(texture->requested_mip != texture->resident_mip || mip == texture->resident_mip) {
+    return false;
+  }
+
+  if(texture->cooked) {
+    upload_cooked(texture, mip);
+    return true;
+  }
+
+  push_upload(texture, mip);
+  return true;
+}
+
+void texture_update(Texture* texture, const i32 x, const i32 y, const i32 width, const i32 height, const void* pixels) {
+  gl_state_bind_texture(GL_TEXTURE_2D, texture->id);
+
+  // Rows of single-channel pixels are rarely a multiple of 4 bytes
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, texture->format, GL_UNSIGNED_BYTE, pixels);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  gl_state_bind_texture(GL_TEXTURE_2D, 0);
+}
+
+const usizei texture_get_mip_size(const Texture* texture, const u32 mip) {
+  if(!texture->cooked) {
+    i32 width  = glm::max(texture->full_width >> mip, 1);
+    i32 height = glm::max(texture->full_height >> mip, 1);
+
+    // Always stored as RGBA
+    return gpu_memory_texture_size(width, height, 4, true);
+  }
+
+  usizei size = 0;
+  for(u32 i = mip; i < texture->cooked->header->mips_count; i++) {
+    usizei level_size;
+    texture_file_get_level(texture->cooked, i, 0, &level_size);
+
+    size += level_size;
+  }
+
+  return size;
+}
+
+void texture_shutdown_uploads() {
+  {
+    std::lock_guard<std::mutex> lock(s_uploads.mutex);
+
+    for(auto& upload : s_uploads.pending) {
+      stbi_image_free(upload->pixels);
+      delete upload;
+    }
+    s_uploads.pending.clear();
+  }
+
+  if(s_uploads.pbo != 0) {
+    gl_state_forget_buffer(s_uploads.pbo);
+    glDeleteBuffers(1, &s_uploads.pbo);
+    gpu_memory_free(GPU_MEMORY_STREAMING, s_uploads.pbo_size);
+  }
+
+  s_uploads.pbo      = 0;
+  s_uploads.pbo_size = 0;
+}
+
 void texture_unload(Texture* texture) {
   if(!texture) {
     return;
   }
 
-  glDeleteTextures(1, &texture->id);
-  stbi_image_free(texture->pixels);
+  // Draws that were already recorded might still use the texture
+  render_thread_push([texture]() {
+    texture_residency_remove(texture);
+
+    // An upload might still be on its way. It has nothing to upload into anymore.
+    if(!texture->is_ready || texture->requested_mip != texture->resident_mip) {
+      std::lock_guard<std::mutex> lock(s_uploads.mutex);
+
+      for(auto& upload : s_uploads.pending) {
+        if(upload->texture == texture) {
+          upload->texture = nullptr;
+        }
+      }
+    }
+
+    gl_state_forget_texture(texture->id);
+    glDeleteTextures(1, &texture->id);
+    gpu_memory_free(GPU_MEMORY_TEXTURES, texture->gpu_size);
+    stbi_image_free(texture->pixels);
+
+    if(texture->cooked) {
+      texture_file_close(texture->cooked);
+      delete texture->cooked;
+    }
+
+    delete texture;
+  });
+}
+
+const u32 texture_use(Texture* texture) {
+  if(!texture) {
+    return 0;
+  }
 
-  delete texture;
-  texture = nullptr;
+  return texture_units_bind(GL_TEXTURE_2D, texture->id, texture->sampler);
 }
 
-void texture_use(Texture* texture, i32 slot) {
+void texture_use(Texture* texture, const u32 unit) {
   if(!texture) {
     return;
   }
 
-  glActiveTexture(GL_TEXTURE0 + slot);
-  glBindTexture(GL_TEXTURE_2D, texture->id);
+  gl_state_bind_texture(unit, GL_TEXTURE_2D, texture->id);
+  gl_state_bind_sampler(unit, texture_units_get_sampler(texture->sampler));
 }
 /////////////////////////////////////////////////////////////////////////////////
@@ -1,9 +1,20 @@
 #pragma once
 
 #include "defines.h"
+#include "graphics/texture_units.h"
 
+#include <atomic>
 #include <string>
 
+struct TextureFile;
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+// How many bytes of pixels 'texture_flush_uploads' uploads per frame at most. A texture 
+// bigger than this still gets uploaded, just on a frame of its own.
+#define TEXTURE_UPLOAD_BUDGET (8 * 1024 * 1024)
+/////////////////////////////////////////////////////////////////////////////////
+
 // TextureFormat
 /////////////////////////////////////////////////////////////////////////////////
 // Values of this enum are directly lifted from OpenGL or the 'gl.h' file
@@ -20,17 +31,81 @@ enum TextureFormat {
 struct Texture {
   u32 id;
   i32 width, height;
-  i32 depth, slot, channels;
+  i32 depth, channels;
   TextureFormat format;
+  SamplerType sampler;
+
+  usizei gpu_size = 0; // Bytes taken on the GPU, mipmaps included
 
+  // Only kept for textures that were loaded with 'keep_pixels'
   void* pixels = nullptr;
+
+  // Textures loaded with 'texture_load_async' are a 1x1 placeholder until this is set
+  std::atomic<bool> is_ready = true;
+
+  // Mip streaming (see 'texture_residency.h'). Only textures loaded from a path can be streamed.
+  // NOTE: Everything below is owned by the render thread.
+  std::string path;
+  i32 full_width = 0, full_height = 0; // The size of the image on disk
+  u32 resident_mip  = 0;               // How many mips were dropped from the image on the GPU
+  u32 requested_mip = 0;               // The mip that is streaming in, or 'resident_mip' if none is
+
+  // Cooked textures (see 'texture_file.h') stay mapped, so streaming a mip in is just another upload
+  TextureFile* cooked = nullptr;
 };
 /////////////////////////////////////////////////////////////////////////////////
 
 // Public functions
 /////////////////////////////////////////////////////////////////////////////////
-Texture* texture_load(const std::string& path);
-Texture* texture_load(i32 width, i32 height, TextureFormat format, void* pixels);
+// NOTE: The decoded pixels are freed once they are on the GPU, unless 'keep_pixels' is set
+// (for things like the window icon, which need them later).
+// NOTE: If a cooked version of the file exists next to it (see 'texture_file_get_cooked_path'), 
+// that gets loaded instead, unless 'keep_pixels' is set. The path can also point to the cooked file directly.
+Texture* texture_load(const std::string& path, const bool keep_pixels = false);
+// NOTE: Textures that are only ever sampled at their full size (like atlases that get updated 
+// with 'texture_update') can skip the mipmaps with 'has_mipmaps'.
+Texture* texture_load(i32 width, i32 height, TextureFormat format, void* pixels, const bool has_mipmaps = true);
+
+// Decode the texture on the thread pool and upload it once it is done (see 'texture_flush_uploads').
+// The texture can be used right away, and samples a 1x1 white placeholder until it is ready.
+// NOTE: The size and format of the texture are only known once it is ready, and the 
+// decoded pixels are not kept around like they are with 'texture_load'.
+// NOTE: Cooked textures have nothing to decode, so they are just loaded with 'texture_load'.
+Texture* texture_load_async(const std::string& path);
+
+// Returns 'true' once the texture is uploaded (or failed to load), without ever blocking
+const bool texture_is_ready(Texture* texture);
+
+// Upload the textures that finished decoding, oldest first, until 'TEXTURE_UPLOAD_BUDGET' 
+// bytes were uploaded. Returns how many bytes were uploaded.
+// NOTE: Must be called from the render thread, once per frame.
+const usizei texture_flush_uploads();
+
+// Decode the texture from its path again and replace it with the given mip of the image (0 being the full 
+// image), once that is uploaded. The texture keeps what it has until then. Returns 'false' if nothing was 
+// started, because the texture was not loaded from a path, kept its pixels, is still loading, or is already at that mip.
+// NOTE: Cooked textures already have every mip, so those are uploaded right away instead.
+// NOTE: Must be called from the render thread.
+const bool texture_stream(Texture* texture, const u32 mip);
+
+// Replace a part of the texture with the given pixels, which have to be in the format of the texture.
+// NOTE: Only the first level is updated, so this is meant for textures that are sampled without mipmaps.
+// NOTE: Must be called from the render thread.
+void texture_update(Texture* texture, const i32 x, const i32 y, const i32 width, const i32 height, const void* pixels);
+
+// How many bytes the texture takes on the GPU when the given mip is its biggest one
+const usizei texture_get_mip_size(const Texture* texture, const u32 mip);
+
+// Drop every upload that is still pending and free the pixel buffer.
+// NOTE: Must be called from the render thread, after the thread pool is shut down.
+void texture_shutdown_uploads();
 void texture_unload(Texture* texture);
-void texture_use(Texture* texture, i32 slot);
+
+// Bind the texture (and its sampler) to whichever unit is free and return that unit
+// NOTE: Must be called from the render thread.
+const u32 texture_use(Texture* texture);
+
+// Bind the texture (and its sampler) to the given unit
+// NOTE: Must be called from the render thread.
+void texture_use(Texture* texture, const u32 unit);
 /////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,337 @@
+#include "texture_cooker.h"
+#include "defines.h"
+#include "resources/cubemap.h"
+#include "resources/texture_file.h"
+#include "utils/utils_file.h"
+
+#include <stb_image/stb_image.h>
+#include <glm/glm.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// CookImage
+/////////////////////////////////////////////////////////////////////////////////
+// Every mip of one face, as RGBA8
+struct CookImage {
+  std::vector<std::vector<u8>> mips;
+  std::vector<glm::uvec2> sizes;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static u16 pack_565(const glm::vec3& color) {
+  u16 r = (u16)glm::clamp((i32)(color.r * 31.0f / 255.0f + 0.5f), 0, 31);
+  u16 g = (u16)glm::clamp((i32)(color.g * 63.0f / 255.0f + 0.5f), 0, 63);
+  u16 b = (u16)glm::clamp((i32)(color.b * 31.0f / 255.0f + 0.5f), 0, 31);
+
+  return (r << 11) | (g << 5) | b;
+}
+
+static glm::vec3 unpack_565(const u16 color) {
+  f32 r = (f32)((color >> 11) & 31);
+  f32 g = (f32)((color >> 5) & 63);
+  f32 b = (f32)(color & 31);
+
+  return glm::vec3(r * 255.0f / 31.0f, g * 255.0f / 63.0f, b * 255.0f / 31.0f);
+}
+
+// Always in the 4-color mode, which is the only one BC3 has anyway
+static void encode_bc1(const u8 block[16][4], u8* out) {
+  glm::vec3 min(255.0f), max(0.0f);
+  for(u32 i = 0; i < 16; i++) {
+    glm::vec3 color(block[i][0], block[i][1], block[i][2]);
+
+    min = glm::min(min, color);
+    max = glm::max(max, color);
+  }
+
+  // Pull the end points in a bit, so the colors in between land closer to what is actually in the block
+  glm::vec3 inset = (max - min) / 16.0f;
+  u16 c0 = pack_565(max - inset);
+  u16 c1 = pack_565(min + inset);
+
+  // 'c0 > c1' is what marks the 4-color mode
+  if(c0 < c1) {
+    u16 temp = c0;
+    c0 = c1;
+    c1 = temp;
+  }
+
+  u32 indices = 0;
+  if(c0 != c1) {
+    glm::vec3 palette[4];
+    palette[0] = unpack_565(c0);
+    palette[1] = unpack_565(c1);
+    palette[2] = (palette[0] * 2.0f + palette[1]) / 3.0f;
+    palette[3] = (palette[0] + palette[1] * 2.0f) / 3.0f;
+
+    for(u32 i = 0; i < 16; i++) {
+      glm::vec3 color(block[i][0], block[i][1], block[i][2]);
+
+      u32 best      = 0;
+      f32 best_dist = glm::dot(color - palette[0], color - palette[0]);
+      for(u32 j = 1; j < 4; j++) {
+        f32 dist = glm::dot(color - palette[j], color - palette[j]);
+        if(dist < best_dist) {
+          best      = j;
+          best_dist = dist;
+        }
+      }
+
+      indices |= best << (i * 2);
+    }
+  }
+
+  out[0] = c0 & 0xff;
+  out[1] = c0 >> 8;
+  out[2] = c1 & 0xff;
+  out[3] = c1 >> 8;
+  memcpy(&out[4], &indices, sizeof(u32));
+}
+
+// The alpha half of a BC3 block, always in the 8-alpha mode
+static void encode_bc3_alpha(const u8 block[16][4], u8* out) {
+  u8 a0 = 0, a1 = 255;
+  for(u32 i = 0; i < 16; i++) {
+    a0 = glm::max(a0, block[i][3]);
+    a1 = glm::min(a1, block[i][3]);
+  }
+
+  u64 indices = 0;
+  if(a0 != a1) {
+    // 'a0 > a1' is what marks the 8-alpha mode. Index 0 and 1 are the end points themselves. 
+    f32 palette[8];
+    palette[0] = a0;
+    palette[1] = a1;
+    for(u32 j = 1; j < 7; j++) {
+      palette[j + 1] = ((7 - j) * a0 + j * a1) / 7.0f;
+    }
+
+    for(u32 i = 0; i < 16; i++) {
+      u64 best      = 0;
+      f32 best_dist = glm::abs(block[i][3] - palette[0]);
+      for(u32 j = 1; j < 8; j++) {
+        f32 dist = glm::abs(block[i][3] - palette[j]);
+        if(dist < best_dist) {
+          best      = j;
+          best_dist = dist;
+        }
+      }
+
+      indices |= best << (i * 3);
+    }
+  }
+
+  out[0] = a0;
+  out[1] = a1;
+  for(u32 i = 0; i < 6; i++) {
+    out[i + 2] = (indices >> (i * 8)) & 0xff;
+  }
+}
+
+static void encode_image(const u8* pixels, const u32 width, const u32 height, const TextureFileFormat format, u8* out) {
+  if(format == TEXTURE_FILE_RGBA8) {
+    memcpy(out, pixels, (usizei)width * height * 4);
+    return;
+  }
+
+  usizei block_size = format == TEXTURE_FILE_BC1 ? 8 : 16;
+
+  for(u32 by = 0; by < height; by += 4) {
+    for(u32 bx = 0; bx < width; bx += 4) {
+      // Blocks that go past the edge repeat the last row and column
+      u8 block[16][4];
+      for(u32 y = 0; y < 4; y++) {
+        for(u32 x = 0; x < 4; x++) {
+          u32 px = glm::min(bx + x, width - 1);
+          u32 py = glm::min(by + y, height - 1);
+
+          memcpy(block[y * 4 + x], &pixels[((usizei)py * width + px) * 4], 4);
+        }
+      }
+
+      if(format == TEXTURE_FILE_BC3) {
+        encode_bc3_alpha(block, out);
+        encode_bc1(block, out + 8);
+      }
+      else {
+        encode_bc1(block, out);
+      }
+
+      out += block_size;
+    }
+  }
+}
+
+static bool load_image(const std::string& path, CookImage* out_image, bool* has_alpha) {
+  // Same as 'texture_load', so cooked textures come out the same way up
+  stbi_set_flip_vertically_on_load_thread(true);
+
+  i32 width, height, channels;
+  u8* pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+  if(!pixels) {
+    fprintf(stderr, "[ERROR]: Could not load image to cook at \'%s\'\n", path.c_str());
+    return false;
+  }
+
+  for(usizei i = 0; i < (usizei)width * height; i++) {
+    *has_alpha |= pixels[i * 4 + 3] != 255;
+  }
+
+  // Every mip down to 1x1
+  u8* mip = pixels;
+  while(true) {
+    out_image->mips.emplace_back(mip, mip + (usizei)width * height * 4);
+    out_image->sizes.push_back(glm::uvec2(width, height));
+
+    if(width == 1 && height == 1) {
+      break;
+    }
+
+    u8* half = texture_downsample(mip, width, height, 4, &width, &height);
+    stbi_image_free(mip);
+    mip = half;
+  }
+
+  stbi_image_free(mip);
+  return true;
+}
+
+static bool write_file(const std::vector<CookImage>& faces, const TextureFileFormat format, const std::string& out_path) {
+  // Every face has to have the same size for the mips to line up
+  for(auto& face : faces) {
+    if(face.sizes[0] != faces[0].sizes[0]) {
+      fprintf(stderr, "[ERROR]: Cannot cook \'%s\' out of faces with different sizes\n", out_path.c_str());
+      return false;
+    }
+  }
+
+  TextureFileHeader header;
+  header.magic       = TEXTURE_FILE_MAGIC;
+  header.version     = TEXTURE_FILE_VERSION;
+  header.format      = format;
+  header.width       = faces[0].sizes[0].x;
+  header.height      = faces[0].sizes[0].y;
+  header.faces_count = faces.size();
+  header.mips_count  = faces[0].mips.size();
+
+  if(header.mips_count > TEXTURE_FILE_MAX_MIPS) {
+    fprintf(stderr, "[ERROR]: Image is too big to cook into \'%s\'\n", out_path.c_str());
+    return false;
+  }
+
+  // Lay every level out (mip-major) after the header and the table
+  std::vector<TextureFileLevel> levels(header.mips_count * header.faces_count);
+  usizei offset = sizeof(TextureFileHeader) + sizeof(TextureFileLevel) * levels.size();
+  for(u32 mip = 0; mip < header.mips_count; mip++) {
+    glm::uvec2 size = faces[0].sizes[mip];
+
+    for(u32 face = 0; face < header.faces_count; face++) {
+      offset = (offset + TEXTURE_FILE_ALIGNMENT - 1) & ~(usizei)(TEXTURE_FILE_ALIGNMENT - 1);
+
+      TextureFileLevel& level = levels[mip * header.faces_count + face];
+      level.offset = offset;
+      level.size   = texture_file_get_image_size(format, size.x, size.y);
+
+      offset += level.size;
+    }
+  }
+
+  std::vector<u8> data(offset, 0);
+  memcpy(data.data(), &header, sizeof(TextureFileHeader));
+  memcpy(data.data() + sizeof(TextureFileHeader), levels.data(), sizeof(TextureFileLevel) * levels.size());
+
+  for(u32 mip = 0; mip < header.mips_count; mip++) {
+    for(u32 face = 0; face < header.faces_count; face++) {
+      const TextureFileLevel& level = levels[mip * header.faces_count + face];
+      glm::uvec2 size = faces[face].sizes[mip];
+
+      encode_image(faces[face].mips[mip].data(), size.x, size.y, format, data.data() + level.offset);
+    }
+  }
+
+  if(!file_write_binary(out_path, data.data(), data.size())) {
+    return false;
+  }
+
+  printf("[INFO]: Cooked \'%s\' (%ux%u, %u mips, %u faces, %s, %zu bytes)\n", 
+         out_path.c_str(), 
+         header.width, 
+         header.height, 
+         header.mips_count, 
+         header.faces_count, 
+         texture_file_format_str(format), 
+         data.size());
+  return true;
+}
+
+static TextureFileFormat pick_format(const bool compress, const bool has_alpha) {
+  if(!compress) {
+    return TEXTURE_FILE_RGBA8;
+  }
+
+  return has_alpha ? TEXTURE_FILE_BC3 : TEXTURE_FILE_BC1;
+}
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+const bool texture_cook(const std::string& path, const std::string& out_path, const bool compress) {
+  std::vector<CookImage> faces(1);
+  bool has_alpha = false;
+
+  if(!load_image(path, &faces[0], &has_alpha)) {
+    return false;
+  }
+
+  return write_file(faces, pick_format(compress, has_alpha), out_path);
+}
+
+const bool texture_cook_cubemap(const std::string& path, const std::string& out_path, const bool compress) {
+  std::vector<CookImage> faces(TEXTURE_FILE_CUBEMAP_FACES);
+  bool has_alpha = false;
+
+  for(u32 i = 0; i < TEXTURE_FILE_CUBEMAP_FACES; i++) {
+    if(!load_image(cubemap_get_face_path(path, i), &faces[i], &has_alpha)) {
+      return false;
+    }
+  }
+
+  return write_file(faces, pick_format(compress, has_alpha), out_path);
+}
+
+u8* texture_downsample(const u8* pixels, const i32 width, const i32 height, const i32 channels, i32* out_width, i32* out_height) {
+  i32 half_width  = width > 1 ? width / 2 : 1;
+  i32 half_height = height > 1 ? height / 2 : 1;
+
+  u8* result = (u8*)malloc((usizei)half_width * half_height * channels);
+  for(i32 y = 0; y < half_height; y++) {
+    i32 y0 = glm::min(y * 2, height - 1);
+    i32 y1 = glm::min(y * 2 + 1, height - 1);
+
+    for(i32 x = 0; x < half_width; x++) {
+      i32 x0 = glm::min(x * 2, width - 1);
+      i32 x1 = glm::min(x * 2 + 1, width - 1);
+
+      for(i32 c = 0; c < channels; c++) {
+        u32 sum = pixels[((usizei)y0 * width + x0) * channels + c] + 
+                  pixels[((usizei)y0 * width + x1) * channels + c] + 
+                  pixels[((usizei)y1 * width + x0) * channels + c] + 
+                  pixels[((usizei)y1 * width + x1) * channels + c];
+
+        result[((usizei)y * half_width + x) * channels + c] = (u8)((sum + 2) / 4);
+      }
+    }
+  }
+
+  *out_width  = half_width;
+  *out_height = half_height;
+  return result;
+}
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "defines.h"
+
+#include <string>
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// Turn images into cooked textures (see 'texture_file.h') ahead of time, so loading them 
+// is just mapping the file and handing every mip straight to the GPU. Opaque images get 
+// compressed as BC1 and images with any transparency as BC3, unless 'compress' is off.
+// NOTE: None of these touch OpenGL, so they can run without a window.
+
+// Cook the image at 'path' into 'out_path'
+const bool texture_cook(const std::string& path, const std::string& out_path, const bool compress = true);
+
+// Cook the six faces a cubemap at 'path' would load (see 'cubemap_load') into one file at 'out_path'
+const bool texture_cook_cubemap(const std::string& path, const std::string& out_path, const bool compress = true);
+
+// Halve the image with a box filter. The last row or column gets repeated if the size is odd.
+// NOTE: The returned pixels are allocated with 'malloc' (so 'stbi_image_free' works on them too).
+u8* texture_downsample(const u8* pixels, const i32 width, const i32 height, const i32 channels, i32* out_width, i32* out_height);
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,219 @@
+#include "texture_file.h"
+#include "defines.h"
+#include "graphics/gl_ext.h"
+#include "utils/utils_file.h"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <cstdio>
+#include <string>
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+static bool is_valid(const TextureFile* file, const std::string& path) {
+  const TextureFileHeader* header = file->header;
+
+  if(header->magic != TEXTURE_FILE_MAGIC || header->version != TEXTURE_FILE_VERSION) {
+    fprintf(stderr, "[ERROR]: \'%s\' is not a cooked texture (or was cooked by an older version)\n", path.c_str());
+    return false;
+  }
+
+  if(header->format >= TEXTURE_FILE_FORMATS_MAX || 
+     (header->faces_count != 1 && header->faces_count != TEXTURE_FILE_CUBEMAP_FACES) ||
+     header->mips_count == 0 || header->mips_count > TEXTURE_FILE_MAX_MIPS || 
+     header->width == 0 || header->height == 0) {
+    fprintf(stderr, "[ERROR]: Invalid header in cooked texture \'%s\'\n", path.c_str());
+    return false;
+  }
+
+  usizei levels_count = header->mips_count * header->faces_count;
+  if(sizeof(TextureFileHeader) + sizeof(TextureFileLevel) * levels_count > file->mapping.size) {
+    fprintf(stderr, "[ERROR]: Cooked texture \'%s\' is cut short\n", path.c_str());
+    return false;
+  }
+
+  // Every level has to be where the header says it is, and as big as its size says it should be
+  for(u32 mip = 0; mip < header->mips_count; mip++) {
+    usizei expected = texture_file_get_image_size((TextureFileFormat)header->format, 
+                                                  texture_file_get_mip_width(file, mip), 
+                                                  texture_file_get_mip_height(file, mip));
+
+    for(u32 face = 0; face < header->faces_count; face++) {
+      const TextureFileLevel& level = file->levels[mip * header->faces_count + face];
+      if(level.size != expected || level.offset + level.size > file->mapping.size) {
+        fprintf(stderr, "[ERROR]: Cooked texture \'%s\' has an invalid level (mip %u, face %u)\n", path.c_str(), mip, face);
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+static u32 get_gl_format(const TextureFileFormat format) {
+  switch(format) {
+    case TEXTURE_FILE_BC1:
+      return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case TEXTURE_FILE_BC3:
+      return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case TEXTURE_FILE_BC7:
+      return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    default:
+      return GL_RGBA8;
+  }
+}
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+const bool texture_file_open(const std::string& path, TextureFile* out_file) {
+  *out_file = TextureFile{};
+  if(!file_map(path, &out_file->mapping)) {
+    return false;
+  }
+
+  if(out_file->mapping.size < sizeof(TextureFileHeader)) {
+    fprintf(stderr, "[ERROR]: Cooked texture \'%s\' is cut short\n", path.c_str());
+    
+    file_unmap(&out_file->mapping);
+    return false;
+  }
+
+  out_file->header = (const TextureFileHeader*)out_file->mapping.data;
+  out_file->levels = (const TextureFileLevel*)(out_file->mapping.data + sizeof(TextureFileHeader));
+
+  if(!is_valid(out_file, path)) {
+    texture_file_close(out_file);
+    return false;
+  }
+
+  return true;
+}
+
+void texture_file_close(TextureFile* file) {
+  file_unmap(&file->mapping);
+  *file = TextureFile{};
+}
+
+const u8* texture_file_get_level(const TextureFile* file, const u32 mip, const u32 face, usizei* out_size) {
+  const TextureFileLevel& level = file->levels[mip * file->header->faces_count + face];
+  
+  *out_size = level.size;
+  return file->mapping.data + level.offset;
+}
+
+const u32 texture_file_get_mip_width(const TextureFile* file, const u32 mip) {
+  return glm::max(file->header->width >> mip, 1u);
+}
+
+const u32 texture_file_get_mip_height(const TextureFile* file, const u32 mip) {
+  return glm::max(file->header->height >> mip, 1u);
+}
+
+const usizei texture_file_get_image_size(const TextureFileFormat format, const u32 width, const u32 height) {
+  // Block-compressed formats always cover whole 4x4 blocks, even for the smallest mips
+  usizei blocks = (usizei)((width + 3) / 4) * ((height + 3) / 4);
+
+  switch(format) {
+    case TEXTURE_FILE_RGBA8:
+      return (usizei)width * height * 4;
+    case TEXTURE_FILE_BC1:
+      return blocks * 8;
+    case TEXTURE_FILE_BC3:
+    case TEXTURE_FILE_BC7:
+      return blocks * 16;
+    default:
+      return 0;
+  }
+}
+
+const u32 texture_file_get_mips_count(const u32 width, const u32 height) {
+  u32 count = 1;
+  u32 size  = glm::max(width, height);
+
+  while(size > 1) {
+    size >>= 1;
+    count++;
+  }
+
+  return count;
+}
+
+const std::string texture_file_get_cooked_path(const std::string& path) {
+  std::string cooked = path;
+  if(!cooked.empty() && cooked.back() == '/') {
+    cooked.pop_back();
+  }
+
+  // Only an extension in the file name itself counts, not a '.' somewhere in the directories
+  usizei dot   = cooked.find_last_of('.');
+  usizei slash = cooked.find_last_of('/');
+  if(dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+    cooked.erase(dot);
+  }
+
+  return cooked + TEXTURE_FILE_EXTENSION;
+}
+
+const bool texture_file_is_cooked(const std::string& path) {
+  std::string ext = TEXTURE_FILE_EXTENSION;
+  return path.size() > ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+const char* texture_file_format_str(const TextureFileFormat format) {
+  switch(format) {
+    case TEXTURE_FILE_RGBA8:
+      return "RGBA8";
+    case TEXTURE_FILE_BC1:
+      return "BC1";
+    case TEXTURE_FILE_BC3:
+      return "BC3";
+    case TEXTURE_FILE_BC7:
+      return "BC7";
+    default:
+      return "UNKNOWN";
+  }
+}
+
+const bool texture_file_is_supported(const TextureFileFormat format) {
+  switch(format) {
+    case TEXTURE_FILE_RGBA8:
+      return true;
+    case TEXTURE_FILE_BC1:
+    case TEXTURE_FILE_BC3:
+      return gl_ext_supported(GLEXT_TEXTURE_COMPRESSION_S3TC);
+    case TEXTURE_FILE_BC7:
+      return gl_ext_supported(GLEXT_TEXTURE_COMPRESSION_BPTC);
+    default:
+      return false;
+  }
+}
+
+const usizei texture_file_upload(const TextureFile* file, const u32 target, const u32 face, const u32 first_mip) {
+  TextureFileFormat format = (TextureFileFormat)file->header->format;
+  u32 gl_format            = get_gl_format(format);
+  usizei uploaded          = 0;
+
+  // Levels are only 16-byte aligned in the file, and RGBA8 rows are always a multiple of 4 anyway
+  for(u32 mip = first_mip; mip < file->header->mips_count; mip++) {
+    usizei size;
+    const u8* data = texture_file_get_level(file, mip, face, &size);
+
+    u32 width  = texture_file_get_mip_width(file, mip);
+    u32 height = texture_file_get_mip_height(file, mip);
+    i32 level  = mip - first_mip;
+
+    if(format == TEXTURE_FILE_RGBA8) {
+      glTexImage2D(target, level, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    }
+    else {
+      glCompressedTexImage2D(target, level, gl_format, width, height, 0, size, data);
+    }
+
+    uploaded += size;
+  }
+
+  return uploaded;
+}
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "defines.h"
+#include "utils/utils_file.h"
+
+#include <string>
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+// A cooked texture is everything the GPU needs, ready to upload as-is: every mip of 
+// every face, already compressed. The layout is:
+//
+//   TextureFileHeader
+//   TextureFileLevel[mips_count * faces_count] (mip-major, so all the faces of mip 0 come first)
+//   The data of each level, aligned to 'TEXTURE_FILE_ALIGNMENT'
+//
+// Mips always go all the way down to 1x1.
+#define TEXTURE_FILE_MAGIC     0x58455443 // "CTEX"
+#define TEXTURE_FILE_VERSION   1
+#define TEXTURE_FILE_EXTENSION ".ctex"
+#define TEXTURE_FILE_ALIGNMENT 16
+#define TEXTURE_FILE_MAX_MIPS  16
+
+// Cubemaps store their faces in the order OpenGL numbers them (+X, -X, +Y, -Y, +Z, -Z)
+#define TEXTURE_FILE_CUBEMAP_FACES 6
+/////////////////////////////////////////////////////////////////////////////////
+
+// TextureFileFormat
+/////////////////////////////////////////////////////////////////////////////////
+enum TextureFileFormat {
+  TEXTURE_FILE_RGBA8 = 0,
+  TEXTURE_FILE_BC1,       // RGB in 8 bytes per 4x4 block
+  TEXTURE_FILE_BC3,       // RGBA in 16 bytes per 4x4 block
+  TEXTURE_FILE_BC7,       // RGBA in 16 bytes per 4x4 block, at a higher quality than BC3
+
+  TEXTURE_FILE_FORMATS_MAX,
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// TextureFileHeader
+/////////////////////////////////////////////////////////////////////////////////
+struct TextureFileHeader {
+  u32 magic, version;
+  u32 format; // TextureFileFormat
+
+  u32 width, height;
+  u32 faces_count; // 1, or 'TEXTURE_FILE_CUBEMAP_FACES' for cubemaps
+  u32 mips_count;
+
+  u32 reserved = 0;
+};
+
+struct TextureFileLevel {
+  u64 offset, size; // In bytes, from the start of the file
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// TextureFile
+/////////////////////////////////////////////////////////////////////////////////
+struct TextureFile {
+  FileMapping mapping;
+
+  const TextureFileHeader* header;
+  const TextureFileLevel* levels;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// Map the cooked texture at 'path' and check that it is valid. Nothing gets read 
+// until the levels are used.
+const bool texture_file_open(const std::string& path, TextureFile* out_file);
+void texture_file_close(TextureFile* file);
+
+// A pointer straight into the mapped file
+const u8* texture_file_get_level(const TextureFile* file, const u32 mip, const u32 face, usizei* out_size);
+
+// The size of the given mip of the texture in the file
+const u32 texture_file_get_mip_width(const TextureFile* file, const u32 mip);
+const u32 texture_file_get_mip_height(const TextureFile* file, const u32 mip);
+
+// How many bytes a 'width' by 'height' image takes in the given format
+const usizei texture_file_get_image_size(const TextureFileFormat format, const u32 width, const u32 height);
+
+// How many mips an image of this size has, down to (and including) 1x1
+const u32 texture_file_get_mips_count(const u32 width, const u32 height);
+
+// Where the cooked version of the file at 'path' would be. That is the same path 
+// with 'TEXTURE_FILE_EXTENSION' as its extension (a trailing '/' is dropped first, for cubemaps).
+const std::string texture_file_get_cooked_path(const std::string& path);
+
+// Returns 'true' if the path has 'TEXTURE_FILE_EXTENSION' as its extension
+const bool texture_file_is_cooked(const std::string& path);
+
+const char* texture_file_format_str(const TextureFileFormat format);
+
+// Returns 'true' if the driver can sample the given format (see 'gl_ext_supported')
+const bool texture_file_is_supported(const TextureFileFormat format);
+
+// Upload the mips of the given face, starting at 'first_mip', straight from the mapped file 
+// into the texture currently bound to 'target'. 'first_mip' ends up as level 0 of the texture.
+// 'target' is the face itself for cubemaps (i.e 'GL_TEXTURE_CUBE_MAP_POSITIVE_X + face'). 
+// Returns how many bytes were uploaded.
+// NOTE: Must be called from the render thread.
+const usizei texture_file_upload(const TextureFile* file, const u32 target, const u32 face, const u32 first_mip);
+/////////////////////////////////////////////////////////////////////////////////
@@ -6,6 +6,15 @@
 #include <sstream>
 #include <fstream>
 
+#ifdef PLAT_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 // MACROS
 /////////////////////////////////////////////////////////////////////////////////
 #define FILE_OPEN_ERR(file, path) {                                                 \
@@ -33,6 +42,11 @@ const usizei file_get_size(const std::string& path) {
   return file_get_size(file);
 }
 
+const bool file_exists(const std::string& path) {
+  std::ifstream file(path);
+  return file.is_open();
+}
+
 const bool file_is_empty(std::ifstream& file) {
   return file_get_size(file) <= 0;
 }
@@ -141,4 +155,90 @@ bool file_write_binary(const std::string& path, const void* in_buff, const usize
   file.close();
   return wrote;
 }
+
+#ifdef PLAT_WINDOWS
+bool file_map(const std::string& path, FileMapping* out_mapping) {
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if(file == INVALID_HANDLE_VALUE) {
+    fprintf(stderr, "[FILE-ERROR]: Could not open file at \'%s\'\n", path.c_str());
+    return false;
+  }
+
+  LARGE_INTEGER size;
+  if(!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    fprintf(stderr, "[FILE-ERROR]: Cannot map empty file at \'%s\'\n", path.c_str());
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  void* data     = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if(!data) {
+    fprintf(stderr, "[FILE-ERROR]: Could not map file at \'%s\'\n", path.c_str());
+    
+    if(mapping) {
+      CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    return false;
+  }
+
+  out_mapping->data           = (const u8*)data;
+  out_mapping->size           = (usizei)size.QuadPart;
+  out_mapping->file_handle    = file;
+  out_mapping->mapping_handle = mapping;
+
+  return true;
+}
+
+void file_unmap(FileMapping* mapping) {
+  if(!mapping->data) {
+    return;
+  }
+
+  UnmapViewOfFile(mapping->data);
+  CloseHandle(mapping->mapping_handle);
+  CloseHandle(mapping->file_handle);
+
+  *mapping = FileMapping{};
+}
+#else
+bool file_map(const std::string& path, FileMapping* out_mapping) {
+  i32 fd = open(path.c_str(), O_RDONLY);
+  if(fd < 0) {
+    fprintf(stderr, "[FILE-ERROR]: Could not open file at \'%s\'\n", path.c_str());
+    return false;
+  }
+
+  struct stat info;
+  if(fstat(fd, &info) != 0 || info.st_size == 0) {
+    fprintf(stderr, "[FILE-ERROR]: Cannot map empty file at \'%s\'\n", path.c_str());
+    close(fd);
+    return false;
+  }
+
+  // The mapping keeps its own reference to the file
+  void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if(data == MAP_FAILED) {
+    fprintf(stderr, "[FILE-ERROR]: Could not map file at \'%s\'\n", path.c_str());
+    return false;
+  }
+
+  out_mapping->data = (const u8*)data;
+  out_mapping->size = (usizei)info.st_size;
+
+  return true;
+}
+
+void file_unmap(FileMapping* mapping) {
+  if(!mapping->data) {
+    return;
+  }
+
+  munmap((void*)mapping->data, mapping->size);
+  *mapping = FileMapping{};
+}
+#endif
 /////////////////////////////////////////////////////////////////////////////////
@@ -5,6 +5,19 @@
 #include <string>
 #include <fstream>
 
+// FileMapping
+/////////////////////////////////////////////////////////////////////////////////
+// A whole file mapped (read-only) into memory. The OS pages it in as it gets read.
+struct FileMapping {
+  const u8* data = nullptr;
+  usizei size    = 0;
+
+  // Platform handles
+  void* file_handle    = nullptr;
+  void* mapping_handle = nullptr;
+};
+/////////////////////////////////////////////////////////////////////////////////
+
 // Public functions
 /////////////////////////////////////////////////////////////////////////////////
 // NOTE: The functions where the file handle is passed, do not close the file. 
@@ -18,6 +31,9 @@
 const usizei file_get_size(std::ifstream& file);
 const usizei file_get_size(const std::string& path);
 
+// Returns 'true' if there is a file at the path that can be opened
+const bool file_exists(const std::string& path);
+
 // Returns 'true' if the file is empty and 'false' otherwise.
 const bool file_is_empty(std::ifstream& file);
 const bool file_is_empty(const std::string& path);
@@ -43,4 +59,9 @@ bool file_write_string(const std::string& path, const std::string& contents);
 // file if the buffer is a 'nullptr'.
 bool file_write_binary(std::ofstream& file, const void* in_buff, const usizei buff_size);
 bool file_write_binary(const std::string& path, const void* in_buff, const usizei buff_size);
+
+// Map the whole file into memory, without reading any of it yet.
+// NOTE: The mapping stays valid until 'file_unmap' is called, even after the path is gone.
+bool file_map(const std::string& path, FileMapping* out_mapping);
+void file_unmap(FileMapping* mapping);
 /////////////////////////////////////////////////////////////////////////////////
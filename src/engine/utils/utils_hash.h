@@ -0,0 +1,45 @@
+#pragma once
+
+#include "defines.h"
+
+// DEFS
+/////////////////////////////////////////////////////////////////////////////////
+#define FNV1A_OFFSET_BASIS 2166136261u
+#define FNV1A_PRIME        16777619u
+/////////////////////////////////////////////////////////////////////////////////
+
+// Public functions
+/////////////////////////////////////////////////////////////////////////////////
+// 32-bit FNV-1a hash of a null-terminated string. When given a string literal, this
+// gets evaluated at compile time. 'seed' can be the result of a previous hash to
+// continue hashing where it left off.
+constexpr u32 hash_fnv1a(const char* str, const u32 seed = FNV1A_OFFSET_BASIS) {
+  u32 hash = seed;
+  for(; *str; str++) {
+    hash ^= (u8)*str;
+    hash *= FNV1A_PRIME;
+  }
+
+  return hash;
+}
+
+// Continues the hash of an array's name with "[index]", giving the same result as hashing
+// the whole string (e.g "u_textures[3]") without having to build it first.
+constexpr u32 hash_fnv1a_index(const u32 seed, const u32 index) {
+  // The digits of the index, from last to first
+  char digits[10] = {0};
+  u32 count = 0;
+  u32 value = index;
+  do {
+    digits[count++] = '0' + (value % 10);
+    value /= 10;
+  } while(value > 0);
+
+  u32 hash = (seed ^ (u8)'[') * FNV1A_PRIME;
+  while(count > 0) {
+    hash = (hash ^ (u8)digits[--count]) * FNV1A_PRIME;
+  }
+
+  return (hash ^ (u8)']') * FNV1A_PRIME;
+}
+/////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,247 @@
+#include "defines.h"
+#include "graphics/texture_residency.h"
+#include "resources/texture.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+// Stubs
+/////////////////////////////////////////////////////////////////////////////////
+// Residency only needs the sizes of the mips and a way to request them. Streaming 
+// finishes right away here, as if the upload was flushed on the same frame, unless 
+// 's_stream_finishes' is off. Then the mip stays requested until 'finish_streams'.
+
+static u32 s_stream_calls    = 0;
+static bool s_stream_finishes = true;
+
+const usizei texture_get_mip_size(const Texture* texture, const u32 mip) {
+  usizei width  = texture->full_width >> mip;
+  usizei height = texture->full_height >> mip;
+
+  return width * height * 4;
+}
+
+const bool texture_stream(Texture* texture, const u32 mip) {
+  texture->requested_mip = mip;
+  if(s_stream_finishes) {
+    texture->resident_mip = mip;
+  }
+
+  s_stream_calls++;
+  return true;
+}
+/////////////////////////////////////////////////////////////////////////////////
+
+// Private functions
+/////////////////////////////////////////////////////////////////////////////////
+#define CHECK(cond) \
+  if(!(cond)) { \
+    fprintf(stderr, "[FAILED]: %s:%i: %s\n", __FILE__, __LINE__, #cond); \
+    exit(1); \
+  }
+
+static void reset() {
+  texture_residency_shutdown();
+  texture_residency_set_budget(TEXTURE_RESIDENCY_VRAM_BUDGET, TEXTURE_RESIDENCY_RAM_BUDGET);
+
+  s_stream_calls    = 0;
+  s_stream_finishes = true;
+}
+
+// A 1024x1024 texture with 4 channels. Every mip is a quarter of the one before (4MB, 1MB, 256KB, ...).
+static void add_texture(Texture* texture, const u32 resident_mip = 0) {
+  texture->full_width    = 1024;
+  texture->full_height   = 1024;
+  texture->channels      = 4;
+  texture->resident_mip  = resident_mip;
+  texture->requested_mip = resident_mip;
+
+  texture_residency_add(texture);
+}
+
+static void reset(Texture* texture) {
+  reset();
+  add_texture(texture);
+}
+
+static void finish_streams(Texture* textures, const u32 count) {
+  for(u32 i = 0; i < count; i++) {
+    textures[i].resident_mip = textures[i].requested_mip;
+  }
+}
+
+static u32 count_requested(const Texture* textures, const u32 count, const u32 mip) {
+  u32 found = 0;
+  for(u32 i = 0; i < count; i++) {
+    if(textures[i].requested_mip == mip) {
+      found++;
+    }
+  }
+
+  return found;
+}
+
+// A texture that is culled for a single frame should not drop (and then stream back) its mips
+static void test_missed_frame_keeps_mip() {
+  Texture texture;
+  reset(&texture);
+
+  texture_residency_touch(&texture, 1024.0f);
+  texture_residency_update();
+  CHECK(texture.resident_mip == 0);
+
+  // Not drawn this frame
+  texture_residency_update();
+  CHECK(texture.resident_mip == 0);
+  CHECK(s_stream_calls == 0);
+
+  texture_residency_touch(&texture, 1024.0f);
+  texture_residency_update();
+  CHECK(texture.resident_mip == 0);
+  CHECK(s_stream_calls == 0);
+}
+
+// Only textures that were not drawn for a while drop down to their smallest mip (1024 >> 4 = 64 pixels)
+static void test_idle_texture_drops() {
+  Texture texture;
+  reset(&texture);
+
+  texture_residency_touch(&texture, 1024.0f);
+  texture_residency_update();
+
+  for(u32 i = 0; i < 120; i++) {
+    texture_residency_update();
+  }
+  CHECK(texture.resident_mip == 0);
+
+  texture_residency_update();
+  CHECK(texture.resident_mip == 4);
+}
+
+// A smaller size on a later frame replaces the one that was kept
+static void test_new_frame_replaces_size() {
+  Texture texture;
+  reset(&texture);
+
+  texture_residency_touch(&texture, 1024.0f);
+  texture_residency_update();
+
+  texture_residency_touch(&texture, 128.0f);
+  texture_residency_update();
+  CHECK(texture.resident_mip == 3);
+}
+
+// Over the VRAM budget, the least recently drawn textures lose their mips first
+static void test_vram_budget_drops_lru() {
+  Texture textures[3];
+  reset();
+
+  // Drawn on frames 0, 1, and 2 (oldest first)
+  for(u32 i = 0; i < 3; i++) {
+    add_texture(&textures[i]);
+  }
+  for(u32 i = 0; i < 3; i++) {
+    texture_residency_touch(&textures[i], 1024.0f);
+    texture_residency_update();
+  }
+  CHECK(textures[0].resident_mip == 0);
+  CHECK(textures[1].resident_mip == 0);
+  CHECK(textures[2].resident_mip == 0);
+
+  // 4MB + 4MB + 1MB. Only the oldest has to give up a mip.
+  texture_residency_set_budget(9 * 1024 * 1024, TEXTURE_RESIDENCY_RAM_BUDGET);
+  texture_residency_update();
+  CHECK(textures[0].resident_mip == 1);
+  CHECK(textures[1].resident_mip == 0);
+  CHECK(textures[2].resident_mip == 0);
+
+  // 1MB + 1MB + 4MB. The most recent one keeps its full size.
+  texture_residency_set_budget(6 * 1024 * 1024, TEXTURE_RESIDENCY_RAM_BUDGET);
+  texture_residency_update();
+  CHECK(textures[0].resident_mip == 1);
+  CHECK(textures[1].resident_mip == 1);
+  CHECK(textures[2].resident_mip == 0);
+
+  // Drawing the oldest again makes the other two the least recently used
+  texture_residency_set_budget(9 * 1024 * 1024, TEXTURE_RESIDENCY_RAM_BUDGET);
+  texture_residency_touch(&textures[0], 1024.0f);
+  texture_residency_update();
+  CHECK(textures[0].resident_mip == 0);
+  CHECK(textures[1].resident_mip == 1);
+  CHECK(textures[2].resident_mip == 0);
+}
+
+// New mips are only requested while the decodes on their way fit in the RAM budget
+static void test_ram_budget_limits_streams() {
+  Texture textures[4];
+  reset();
+  s_stream_finishes = false;
+
+  // Every decode takes 4MB. Two of them fit.
+  texture_residency_set_budget(TEXTURE_RESIDENCY_VRAM_BUDGET, 10 * 1024 * 1024);
+
+  // Sitting at their smallest mip, and now wanted at full size
+  for(u32 i = 0; i < 4; i++) {
+    add_texture(&textures[i], 4);
+  }
+  texture_residency_update();
+
+  for(u32 i = 0; i < 4; i++) {
+    texture_residency_touch(&textures[i], 1024.0f);
+  }
+  texture_residency_update();
+  CHECK(s_stream_calls == 2);
+  CHECK(count_requested(textures, 4, 0) == 2);
+
+  // Still decoding. Nothing else gets through.
+  for(u32 i = 0; i < 4; i++) {
+    texture_residency_touch(&textures[i], 1024.0f);
+  }
+  texture_residency_update();
+  CHECK(s_stream_calls == 2);
+  CHECK(texture_residency_get_stats().streaming_count == 2);
+
+  // Done. The other two can go now.
+  finish_streams(textures, 4);
+  for(u32 i = 0; i < 4; i++) {
+    texture_residency_touch(&textures[i], 1024.0f);
+  }
+  texture_residency_update();
+  CHECK(s_stream_calls == 4);
+  CHECK(count_requested(textures, 4, 0) == 4);
+}
+
+// A decode bigger than the whole RAM budget still gets through, one at a time
+static void test_ram_budget_lets_one_through() {
+  Texture textures[2];
+  reset();
+  s_stream_finishes = false;
+
+  texture_residency_set_budget(TEXTURE_RESIDENCY_VRAM_BUDGET, 1024 * 1024);
+
+  for(u32 i = 0; i < 2; i++) {
+    add_texture(&textures[i], 4);
+  }
+  texture_residency_update();
+
+  for(u32 i = 0; i < 2; i++) {
+    texture_residency_touch(&textures[i], 1024.0f);
+  }
+  texture_residency_update();
+  CHECK(s_stream_calls == 1);
+  CHECK(count_requested(textures, 2, 0) == 1);
+}
+/////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  test_missed_frame_keeps_mip();
+  test_idle_texture_drops();
+  test_new_frame_replaces_size();
+  test_vram_budget_drops_lru();
+  test_ram_budget_limits_streams();
+  test_ram_budget_lets_one_through();
+
+  texture_residency_shutdown();
+  printf("[INFO]: All texture residency tests passed\n");
+  return 0;
+}